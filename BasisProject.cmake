@@ -58,7 +58,7 @@ basis_project (
   DEPENDS
     MIRTK{Common,Numerics,Image,PointSet,IO}
     Boost-1.48 # {math_c99} used, but headers only
-    Eigen3
+    Eigen3-3.3
     "VTK-7|6{
       vtkCommonCore,
       vtkCommonDataModel,
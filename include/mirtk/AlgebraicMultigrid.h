@@ -0,0 +1,261 @@
+/*
+ * Medical Image Registration ToolKit (MIRTK)
+ *
+ * Copyright 2013-2016 Imperial College London
+ * Copyright 2013-2016 Andreas Schuh
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MIRTK_AlgebraicMultigrid_H
+#define MIRTK_AlgebraicMultigrid_H
+
+#include "mirtk/Object.h"
+#include "mirtk/Array.h"
+
+#include "Eigen/SparseCore"
+#include "Eigen/SparseCholesky"
+#include "Eigen/OrderingMethods"
+#include "Eigen/LU"
+
+
+namespace mirtk {
+
+
+/**
+ * Smoothed aggregation algebraic multigrid for symmetric positive definite matrices
+ *
+ * The hierarchy of coarser linear systems is built by greedy aggregation of
+ * strongly connected unknowns (Vanek et al., 1996). The piecewise constant
+ * tentative prolongator of each aggregate is smoothed by one damped Jacobi
+ * step and the coarse matrices are the Galerkin products P^T A P. The system
+ * at the coarsest level is solved by a sparse Cholesky factorization, or by
+ * a dense LU factorization with full pivoting when the sparse factorization
+ * failed, e.g., because the coarse matrix is only positive semi-definite.
+ *
+ * The multigrid V-cycle with damped Jacobi pre- and post-smoothing is a
+ * symmetric operator and can thus be used as preconditioner of the conjugate
+ * gradient method. It can also be iterated as standalone solver.
+ *
+ * Setup computes the aggregates and the numeric hierarchy. When the matrix
+ * values change, but not its non-zero pattern, Update reuses the aggregates
+ * and only recomputes the prolongators and Galerkin products.
+ *
+ * Vanek, Mandel, and Brezina (1996). Algebraic multigrid by smoothed aggregation
+ * for second and fourth order elliptic problems. Computing, 56(3), 179–196.
+ */
+class AlgebraicMultigrid : public Object
+{
+  mirtkObjectMacro(AlgebraicMultigrid);
+
+  // ---------------------------------------------------------------------------
+  // Types
+
+public:
+
+  /// Type of sparse system matrix
+  typedef Eigen::SparseMatrix<double> Matrix;
+
+  /// Type of vectors
+  typedef Eigen::VectorXd Vector;
+
+  /// Sparse direct solver of coarsest level system
+  typedef Eigen::SimplicialLDLT<Matrix, Eigen::Lower, Eigen::AMDOrdering<int> > CoarseSolver;
+
+  /// Dense direct solver of coarsest level system used when CoarseSolver failed
+  typedef Eigen::FullPivLU<Eigen::MatrixXd> DenseCoarseSolver;
+
+  /// Linear system at one level of the multigrid hierarchy
+  struct Level
+  {
+    Matrix A;        ///< System matrix
+    Matrix P;        ///< Prolongation from next coarser level
+    Matrix R;        ///< Restriction to next coarser level
+    Vector InvDiag;  ///< Damped inverse of diagonal of system matrix
+  };
+
+  // ---------------------------------------------------------------------------
+  // Attributes
+
+  /// Threshold of strength of connection between two unknowns
+  ///
+  /// Unknowns i and j are strongly connected when |a_ij| > t * sqrt(|a_ii a_jj|).
+  mirtkPublicAttributeMacro(double, StrengthThreshold);
+
+  /// Maximum number of levels
+  mirtkPublicAttributeMacro(int, MaxNumberOfLevels);
+
+  /// Maximum number of unknowns at coarsest level
+  mirtkPublicAttributeMacro(int, CoarseSize);
+
+  /// Number of Jacobi pre-smoothing steps
+  mirtkPublicAttributeMacro(int, NumberOfPreSmoothingSteps);
+
+  /// Number of Jacobi post-smoothing steps
+  mirtkPublicAttributeMacro(int, NumberOfPostSmoothingSteps);
+
+  /// Levels of multigrid hierarchy from finest to coarsest
+  mirtkReadOnlyAttributeMacro(Array<Level>, Levels);
+
+  /// Aggregate index of each unknown at each level except the coarsest
+  mirtkReadOnlyAttributeMacro(Array<Array<int> >, Aggregates);
+
+  /// Number of aggregates at each level except the coarsest
+  mirtkReadOnlyAttributeMacro(Array<int>, NumberOfAggregates);
+
+protected:
+
+  /// Solver of coarsest level system
+  CoarseSolver _CoarseSolver;
+
+  /// Dense solver of coarsest level system
+  DenseCoarseSolver _DenseCoarseSolver;
+
+  /// Whether coarsest level system is solved by dense solver
+  bool _DenseCoarseSolve;
+
+  /// Copy attributes of this class from another instance
+  void CopyAttributes(const AlgebraicMultigrid &);
+
+  // ---------------------------------------------------------------------------
+  // Construction/Destruction
+
+public:
+
+  /// Constructor
+  AlgebraicMultigrid();
+
+  /// Copy constructor
+  ///
+  /// Only the parameters are copied, not the multigrid hierarchy.
+  AlgebraicMultigrid(const AlgebraicMultigrid &);
+
+  /// Assignment operator
+  ///
+  /// Only the parameters are copied, not the multigrid hierarchy.
+  AlgebraicMultigrid &operator =(const AlgebraicMultigrid &);
+
+  /// Destructor
+  virtual ~AlgebraicMultigrid();
+
+  // ---------------------------------------------------------------------------
+  // Setup
+
+  /// Compute aggregates and multigrid hierarchy of given matrix
+  ///
+  /// \returns Whether the system of the coarsest level could be factorized.
+  bool Setup(const Matrix &);
+
+  /// Recompute multigrid hierarchy of matrix with the same non-zero pattern
+  ///
+  /// The aggregates of the matrix passed to the last Setup call are reused.
+  /// When no aggregates are available or the matrix size differs, Setup is
+  /// called instead.
+  ///
+  /// \returns Whether the system of the coarsest level could be factorized.
+  bool Update(const Matrix &);
+
+  /// Whether multigrid hierarchy was set up
+  bool IsInitialized() const;
+
+  /// Number of levels of multigrid hierarchy
+  int NumberOfLevels() const;
+
+  /// Ratio of total number of non-zero entries at all levels to finest level
+  double OperatorComplexity() const;
+
+  // ---------------------------------------------------------------------------
+  // Solver
+
+  /// Apply one V-cycle to solve A x = b with initial guess x
+  ///
+  /// \param[in]     b Right-hand side.
+  /// \param[in,out] x Initial guess and improved solution.
+  void VCycle(const Vector &b, Vector &x) const;
+
+  /// Apply V-cycle with zero initial guess, i.e., multigrid preconditioner
+  ///
+  /// \param[in] b Right-hand side.
+  ///
+  /// \returns Approximate solution of A x = b.
+  Vector Apply(const Vector &b) const;
+
+  /// Iterate V-cycles until convergence
+  ///
+  /// \param[in]     b       Right-hand side.
+  /// \param[in,out] x       Initial guess and solution.
+  /// \param[in]     maxiter Maximum number of V-cycles.
+  /// \param[in]     tol     Tolerance of relative residual norm.
+  /// \param[out]    error   Relative residual norm of solution.
+  ///
+  /// \returns Number of V-cycles performed.
+  int Solve(const Vector &b, Vector &x, int maxiter, double tol, double *error = nullptr) const;
+
+protected:
+
+  /// Compute aggregates of strongly connected unknowns
+  ///
+  /// \param[in]  A   System matrix.
+  /// \param[out] agg Aggregate index of each unknown.
+  ///
+  /// \returns Number of aggregates.
+  int Aggregate(const Matrix &A, Array<int> &agg) const;
+
+  /// Compute damped inverse diagonal of matrix and spectral radius estimate
+  ///
+  /// \param[in, out] level Level whose InvDiag is set.
+  ///
+  /// \returns Damping factor of Jacobi smoother and prolongator smoothing.
+  double InitializeSmoother(Level &level) const;
+
+  /// Compute prolongator and coarse system matrix from aggregates
+  void InitializeCoarseLevel(int l);
+
+  /// Factorize system matrix of coarsest level
+  ///
+  /// \param[in] analyze Whether to also compute the symbolic factorization.
+  ///
+  /// \returns Whether the sparse or the dense factorization succeeded.
+  bool InitializeCoarseSolver(bool analyze);
+
+  /// Recursive V-cycle starting at given level
+  void VCycle(int l, const Vector &b, Vector &x) const;
+
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Inline definitions
+////////////////////////////////////////////////////////////////////////////////
+
+// -----------------------------------------------------------------------------
+inline bool AlgebraicMultigrid::IsInitialized() const
+{
+  return !_Levels.empty();
+}
+
+// -----------------------------------------------------------------------------
+inline int AlgebraicMultigrid::NumberOfLevels() const
+{
+  return static_cast<int>(_Levels.size());
+}
+
+// -----------------------------------------------------------------------------
+inline void AlgebraicMultigrid::VCycle(const Vector &b, Vector &x) const
+{
+  VCycle(0, b, x);
+}
+
+
+} // namespace mirtk
+
+#endif // MIRTK_AlgebraicMultigrid_H
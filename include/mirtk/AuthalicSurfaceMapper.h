@@ -66,13 +66,39 @@ public:
   /// Destructor
   virtual ~AuthalicSurfaceMapper();
 
+  /// Create new copy of this instance
+  virtual LinearFixedBoundarySurfaceMapper *NewCopy() const;
+
   // ---------------------------------------------------------------------------
   // Execution
 
 protected:
 
+  /// Compute authalic weights of the two directed edges between two points
+  ///
+  /// The weight of the directed edge (i, j) is the sum of the cotangents of
+  /// the angles at j of the adjacent triangles divided by the squared length
+  /// of the edge.
+  ///
+  /// \param[in]  a Start point i of edge.
+  /// \param[in]  b End point j of edge.
+  /// \param[in]  c Other point of first adjacent triangle.
+  /// \param[in]  d Other point of second adjacent triangle or nullptr.
+  /// \param[out] w Weights of directed edges (i, j) and (j, i).
+  static void EdgeWeights(const double a[3], const double b[3],
+                          const double c[3], const double *d, double w[2]);
+
+  /// Compute authalic weights of all directed edges
+  ///
+  /// \param[out] w Weight of each directed edge (i, j) with edge ID e at
+  ///               index 2 * e if i < j, and index 2 * e + 1 otherwise.
+  virtual void ComputeWeights(Array<double> &w) const;
+
   /// Weight of directed edge (i, j)
   ///
+  /// Unlike ComputeWeights, which is used to assemble the linear system,
+  /// this function computes the weight of a single edge.
+  ///
   /// \param[in] i Index of start point.
   /// \param[in] j Index of end point.
   ///
@@ -58,6 +58,10 @@ class BoundaryMapper : public Object
   mirtkAttributeMacro(Matrix, Values);
 
   /// Piecewise linear boundary map
+  ///
+  /// The point data of the map domain contains an array named "SurfacePointIds"
+  /// with the IDs of the boundary points in the surface mesh. Surface mappers
+  /// use these to look up the boundary value of a surface point directly.
   mirtkReadOnlyAttributeMacro(SharedPtr<PiecewiseLinearMap>, Output);
 
   /// Copy attributes of this class from another instance
@@ -64,6 +64,9 @@ public:
   /// Destructor
   virtual ~ChordLengthSurfaceMapper();
 
+  /// Create new copy of this instance
+  virtual LinearFixedBoundarySurfaceMapper *NewCopy() const;
+
   // ---------------------------------------------------------------------------
   // Execution
 
@@ -77,6 +80,12 @@ protected:
   /// \returns Weight of undirected edge (i, j).
   virtual double Weight(int i, int j) const;
 
+  /// Whether all edge weights are equal to one, i.e., exponent is non-positive
+  virtual bool UniformWeights() const;
+
+  /// Compute weights of all edges from precomputed edge lengths
+  virtual void ComputeWeights(Array<double> &w) const;
+
 };
 
 
@@ -22,6 +22,8 @@
 
 #include "mirtk/SphericalSurfaceMapper.h"
 
+#include "mirtk/LinearSolverType.h"
+
 
 namespace mirtk {
 
@@ -79,6 +81,13 @@ class ConformalSurfaceFlattening : public SphericalSurfaceMapper
   /// Radius of sphere to which flattened map is projected
   mirtkPublicAttributeMacro(double, Radius);
 
+  /// Type of sparse linear solver
+  ///
+  /// By default, a sparse LU factorization is used when the number of
+  /// iterations is negative or 1, and the conjugate gradient method otherwise.
+  /// The Cholesky factorizations are not suitable for the singular matrix.
+  mirtkPublicAttributeMacro(LinearSolverType, LinearSolver);
+
   /// Maximum number of iterations
   ///
   /// When the number of iterations is set to 1, a sparse direct solver is used.
@@ -87,6 +96,11 @@ class ConformalSurfaceFlattening : public SphericalSurfaceMapper
   /// Tolerance for sparse linear solver
   mirtkPublicAttributeMacro(double, Tolerance);
 
+  /// Whether to factorize or precondition the linear system in single precision
+  ///
+  /// \sa SparseLinearSolver::MixedPrecision
+  mirtkPublicAttributeMacro(bool, MixedPrecision);
+
   /// Computed map values at surface points
   mirtkAttributeMacro(vtkSmartPointer<vtkDataArray>, Values);
 
@@ -0,0 +1,202 @@
+/*
+ * Medical Image Registration ToolKit (MIRTK)
+ *
+ * Copyright 2013-2016 Imperial College London
+ * Copyright 2013-2016 Andreas Schuh
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MIRTK_CotangentLaplacian_H
+#define MIRTK_CotangentLaplacian_H
+
+#include "mirtk/Object.h"
+#include "mirtk/Array.h"
+#include "mirtk/Memory.h"
+#include "mirtk/Algorithm.h"
+#include "mirtk/EdgeTable.h"
+#include "mirtk/TriangleMeshGeometry.h"
+
+#include "vtkSmartPointer.h"
+#include "vtkPolyData.h"
+
+#include "Eigen/SparseCore"
+
+
+namespace mirtk {
+
+
+/**
+ * Cotangent Laplacian and mass matrix of a triangulated surface mesh
+ *
+ * The cotangents of the three angles and the area of each triangle are computed
+ * once by a TriangleMeshGeometry filter. The discrete operators are assembled by
+ * a parallel loop over the surface points, where each point gathers the values
+ * of its incident triangles into its row of a sparse matrix. The non-zero
+ * pattern of these matrices and the index of the non-zero entry of each edge
+ * of each triangle are precomputed by Run such that no search or allocation
+ * is required during assembly.
+ *
+ * The stiffness matrix L has entries L_ij = -(cot alpha_ij + cot beta_ij),
+ * where alpha_ij and beta_ij are the angles opposite to edge (i, j), and
+ * L_ii = -sum_j L_ij. Note that the usual factor 1/2 is omitted. The consistent
+ * mass matrix of piecewise linear elements has entries M_ij = sum_t A_t / 12
+ * over the triangles t with area A_t adjacent to edge (i, j), and
+ * M_ii = sum_t A_t / 6 over the triangles adjacent to point i. The lumped mass
+ * matrix is the diagonal matrix with entries sum_t A_t / 3.
+ *
+ * Vertices and lines of the surface mesh are ignored. All other cells must be
+ * triangles.
+ */
+class CotangentLaplacian : public Object
+{
+  mirtkObjectMacro(CotangentLaplacian);
+
+  // ---------------------------------------------------------------------------
+  // Types
+
+public:
+
+  /// Type of sparse matrix
+  typedef Eigen::SparseMatrix<double> Matrix;
+
+  /// Type of diagonal matrix entries
+  typedef Eigen::VectorXd Vector;
+
+  // ---------------------------------------------------------------------------
+  // Attributes
+
+  /// Triangulated surface mesh
+  mirtkPublicAttributeMacro(vtkSmartPointer<vtkPolyData>, Surface);
+
+  /// Pre-computed edge table of surface mesh
+  mirtkPublicAttributeMacro(SharedPtr<mirtk::EdgeTable>, EdgeTable);
+
+  /// Triangles and edges of surface mesh and their geometry
+  mirtkReadOnlyAttributeMacro(TriangleMeshGeometry, Geometry);
+
+protected:
+
+  /// Offsets of rows of sparse matrices
+  Array<int> _Offsets;
+
+  /// Column indices of non-zero entries of sparse matrices
+  Array<int> _Indices;
+
+  /// Offsets of the corners of the triangles adjacent to each point
+  Array<int> _CornerOffsets;
+
+  /// Index 3 * t + c of corner c of triangle t adjacent to each point
+  Array<int> _Corners;
+
+  /// Indices of the non-zero entries (i, i), (i, j), and (i, k) of each
+  /// corner i of a triangle, where j and k are the next and previous point
+  Array<int> _Entries;
+
+  /// Copy attributes of this class from another instance
+  void CopyAttributes(const CotangentLaplacian &);
+
+  // ---------------------------------------------------------------------------
+  // Construction/Destruction
+
+public:
+
+  /// Constructor
+  CotangentLaplacian(vtkPolyData * = nullptr, SharedPtr<mirtk::EdgeTable> = nullptr);
+
+  /// Copy constructor
+  CotangentLaplacian(const CotangentLaplacian &);
+
+  /// Assignment operator
+  CotangentLaplacian &operator =(const CotangentLaplacian &);
+
+  /// Destructor
+  virtual ~CotangentLaplacian();
+
+  // ---------------------------------------------------------------------------
+  // Execution
+
+  /// Compute non-zero pattern, triangle cotangents, and areas
+  void Run();
+
+  /// Recompute triangle cotangents and areas after the points have moved
+  void Update();
+
+  // ---------------------------------------------------------------------------
+  // Discrete operators
+
+  /// Number of surface points, i.e., rows and columns of sparse matrices
+  int NumberOfPoints() const;
+
+  /// Number of triangles
+  int NumberOfTriangles() const;
+
+  /// Get cotangent stiffness matrix
+  void GetStiffnessMatrix(Matrix &L) const;
+
+  /// Get consistent mass matrix
+  void GetMassMatrix(Matrix &M) const;
+
+  /// Get diagonal entries of lumped mass matrix
+  void GetLumpedMassMatrix(Vector &M) const;
+
+  /// Get sum of cotangents of angles opposite to each edge of the edge table
+  ///
+  /// \param[out] w Weight of each edge, i.e., -L_ij.
+  void GetEdgeWeights(Array<double> &w) const;
+
+  /// Index of non-zero entry (i, j) of sparse matrices in row-wise order
+  ///
+  /// The entries of row i of a symmetric matrix are stored in column i of the
+  /// column-major Eigen::SparseMatrix, i.e., this is also the index of the
+  /// entry (j, i) in the array of non-zero values of such matrix.
+  ///
+  /// \returns Index of non-zero entry or -1 if points are not adjacent.
+  int NonZeroIndex(int i, int j) const;
+
+protected:
+
+  /// Allocate sparse matrix with precomputed non-zero pattern and zero entries
+  void InitializeMatrix(Matrix &) const;
+
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Inline definitions
+////////////////////////////////////////////////////////////////////////////////
+
+// -----------------------------------------------------------------------------
+inline int CotangentLaplacian::NumberOfPoints() const
+{
+  return static_cast<int>(_Offsets.empty() ? 0 : _Offsets.size() - 1);
+}
+
+// -----------------------------------------------------------------------------
+inline int CotangentLaplacian::NumberOfTriangles() const
+{
+  return _Geometry.NumberOfTriangles();
+}
+
+// -----------------------------------------------------------------------------
+inline int CotangentLaplacian::NonZeroIndex(int i, int j) const
+{
+  const int * const begin = _Indices.data() + _Offsets[i];
+  const int * const end   = _Indices.data() + _Offsets[i+1];
+  const int * const it    = lower_bound(begin, end, j);
+  return (it != end && *it == j ? static_cast<int>(it - _Indices.data()) : -1);
+}
+
+
+} // namespace mirtk
+
+#endif // MIRTK_CotangentLaplacian_H
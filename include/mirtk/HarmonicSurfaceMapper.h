@@ -80,6 +80,9 @@ public:
   /// Destructor
   virtual ~HarmonicSurfaceMapper();
 
+  /// Create new copy of this instance
+  virtual LinearFixedBoundarySurfaceMapper *NewCopy() const;
+
   // ---------------------------------------------------------------------------
   // Execution
 
@@ -93,6 +96,9 @@ protected:
   /// \returns Weight of undirected edge (i, j).
   virtual double Weight(int i, int j) const;
 
+  /// Compute cotangent weights of all edges
+  virtual void ComputeWeights(Array<double> &w) const;
+
 };
 
 
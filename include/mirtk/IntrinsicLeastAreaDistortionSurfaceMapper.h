@@ -67,6 +67,9 @@ public:
   /// Destructor
   virtual ~IntrinsicLeastAreaDistortionSurfaceMapper();
 
+  /// Create new copy of this instance
+  virtual LinearFixedBoundarySurfaceMapper *NewCopy() const;
+
   // ---------------------------------------------------------------------------
   // Execution
 
@@ -63,6 +63,9 @@ public:
   /// Destructor
   virtual ~IntrinsicLeastEdgeLengthDistortionSurfaceMapper();
 
+  /// Create new copy of this instance
+  virtual LinearFixedBoundarySurfaceMapper *NewCopy() const;
+
   // ---------------------------------------------------------------------------
   // Execution
 
@@ -63,6 +63,14 @@ class IntrinsicSurfaceMapper : public NonSymmetricWeightsSurfaceMapper
   /// Weight of conformal energy in [0, 1], weight of authalic energy is 1 - Lambda.
   mirtkPublicAttributeMacro(double, Lambda);
 
+  /// Conformal weight of each undirected edge used by ComputeMap, i.e.,
+  /// sum of the cotangents of the angles opposite to the edge
+  mirtkAttributeMacro(Array<double>, ConformalWeights);
+
+  /// Authalic weight of each directed edge (i, j) with edge ID e used by
+  /// ComputeMap at index 2 * e if i < j, and index 2 * e + 1 otherwise
+  mirtkAttributeMacro(Array<double>, AuthalicWeights);
+
   /// Copy attributes of this class from another instance
   void CopyAttributes(const IntrinsicSurfaceMapper &);
 
@@ -86,9 +94,15 @@ public:
   /// Destructor
   virtual ~IntrinsicSurfaceMapper();
 
+  /// Create new copy of this instance
+  virtual LinearFixedBoundarySurfaceMapper *NewCopy() const;
+
   // ---------------------------------------------------------------------------
   // Execution
 
+  /// Compute conformal and authalic edge weights and solve linear system
+  virtual void ComputeMap();
+
 protected:
 
   /// Weight of directed edge (i, j)
@@ -99,6 +113,19 @@ protected:
   /// \returns Weight of directed edge (i, j).
   virtual double Weight(int i, int j) const;
 
+  /// Compute conformal and authalic weights of all edges
+  ///
+  /// Both weight components are computed from the cotangents of the triangle
+  /// angles which are evaluated only once in a single pass over the triangles.
+  void ComputeWeightComponents();
+
+  /// Compute affine combination of conformal and authalic edge weights
+  ///
+  /// \param[out] w Weight of each directed edge (i, j) with edge ID e at
+  ///               index 2 * e if i < j, and index 2 * e + 1 otherwise.
+  ///               Empty when the weight components were not computed.
+  virtual void ComputeWeights(Array<double> &w) const;
+
 };
 
 
@@ -23,6 +23,7 @@
 #include "mirtk/FreeBoundarySurfaceMapper.h"
 
 #include "mirtk/Array.h"
+#include "mirtk/LinearSolverType.h"
 
 #include "vtkSmartPointer.h"
 #include "vtkDataArray.h"
@@ -68,6 +69,15 @@ class LeastSquaresConformalSurfaceMapper : public FreeBoundarySurfaceMapper
 
 private:
 
+  /// Type of sparse linear solver
+  ///
+  /// By default, a sparse direct solver is used when the number of iterations
+  /// is negative or 1, and an iterative solver otherwise.
+  mirtkPublicAttributeMacro(LinearSolverType, LinearSolver);
+
+  /// Preconditioner of iterative sparse linear solver
+  mirtkPublicAttributeMacro(LinearSolverPreconditioner, Preconditioner);
+
   /// Maximum number of iterations
   ///
   /// When the number of iterations is set to 1 a sparse direct solver is used.
@@ -76,6 +86,11 @@ private:
   /// Tolerance for sparse linear solver
   mirtkPublicAttributeMacro(double, Tolerance);
 
+  /// Whether to factorize or precondition the linear system in single precision
+  ///
+  /// \sa SparseLinearSolver::MixedPrecision
+  mirtkPublicAttributeMacro(bool, MixedPrecision);
+
   /// Index of point in set of points with free (i >= 0) or fixed (i < 0) values
   mirtkAttributeMacro(Array<int>, PointIndex);
 
@@ -126,13 +141,10 @@ public:
 
 protected:
 
-  /// Weight of undirected edge (i, j)
-  ///
-  /// \param[in] i First end point.
-  /// \param[in] j Second end point.
+  /// Compute cotangent weights of undirected edges
   ///
-  /// \returns Weight of undirected edge (i, j).
-  virtual double Weight(int i, int j) const;
+  /// \param[out] w Weights indexed by edge ID of edge table.
+  virtual void ComputeWeights(Array<double> &w) const;
 
   /// Initialize filter after input and parameters are set
   virtual void Initialize();
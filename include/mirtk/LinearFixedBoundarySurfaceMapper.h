@@ -23,6 +23,9 @@
 #include "mirtk/FixedBoundarySurfaceMapper.h"
 
 #include "mirtk/Array.h"
+#include "mirtk/Algorithm.h"
+#include "mirtk/LinearSolverType.h"
+#include "mirtk/SparseSystemCache.h"
 
 #include "vtkSmartPointer.h"
 #include "vtkDataArray.h"
@@ -55,6 +58,15 @@ class LinearFixedBoundarySurfaceMapper : public FixedBoundarySurfaceMapper
   // ---------------------------------------------------------------------------
   // Attributes
 
+  /// Type of sparse linear solver
+  ///
+  /// By default, a sparse direct solver is used when the number of iterations
+  /// is negative or 1, and an iterative solver otherwise.
+  mirtkPublicAttributeMacro(LinearSolverType, LinearSolver);
+
+  /// Preconditioner of iterative sparse linear solver
+  mirtkPublicAttributeMacro(LinearSolverPreconditioner, Preconditioner);
+
   /// Maximum number of iterations
   ///
   /// When the number of iterations is set to 1 a sparse direct solver is used.
@@ -63,6 +75,36 @@ class LinearFixedBoundarySurfaceMapper : public FixedBoundarySurfaceMapper
   /// Tolerance for sparse linear solver
   mirtkPublicAttributeMacro(double, Tolerance);
 
+  /// Whether to factorize or precondition the linear system in single precision
+  ///
+  /// \sa SparseLinearSolver::MixedPrecision
+  mirtkPublicAttributeMacro(bool, MixedPrecision);
+
+  /// Initial map values of points with free map value used by iterative solver
+  ///
+  /// When set, this array must have one tuple per surface point and as many
+  /// components as the boundary map. The values at fixed points are ignored.
+  mirtkPublicAttributeMacro(vtkSmartPointer<vtkDataArray>, InitialGuess);
+
+  /// Number of levels of coarse-to-fine multiresolution scheme
+  ///
+  /// When greater than one and an iterative linear solver is used, a hierarchy
+  /// of surface meshes is obtained by repeated decimation of the input surface,
+  /// where boundary points are preserved. The linear system of the coarsest
+  /// level is solved with a sparse direct solver. The map of each level is
+  /// interpolated at the points of the next finer level, where it is used as
+  /// initial guess of the iterative solver.
+  mirtkPublicAttributeMacro(int, NumberOfLevels);
+
+  /// Target fraction of points removed by decimation at each coarser level
+  mirtkPublicAttributeMacro(double, LevelReduction);
+
+  /// Maximum number of iterations at intermediate levels
+  ///
+  /// When non-positive, the map of the coarsest level is only interpolated
+  /// at the points of the intermediate levels.
+  mirtkPublicAttributeMacro(int, NumberOfSmoothingIterations);
+
   /// Index of point in set of points with free (i >= 0) or fixed (i < 0) values
   mirtkAttributeMacro(Array<int>, PointIndex);
 
@@ -75,6 +117,13 @@ class LinearFixedBoundarySurfaceMapper : public FixedBoundarySurfaceMapper
   /// Computed map values at surface points
   mirtkAttributeMacro(vtkSmartPointer<vtkDataArray>, Values);
 
+  /// Whether to share the non-zero pattern and solver of the linear system
+  /// with other maps via the SparseSystemCache
+  ///
+  /// Disabled for the levels of the multiresolution hierarchy, which would
+  /// otherwise evict the entry of the input surface from the cache.
+  mirtkAttributeMacro(bool, CacheSparseSystem);
+
   /// Copy attributes of this class from another instance
   void CopyAttributes(const LinearFixedBoundarySurfaceMapper &);
 
@@ -97,6 +146,13 @@ public:
   /// Destructor
   virtual ~LinearFixedBoundarySurfaceMapper();
 
+  /// Create new copy of this instance
+  ///
+  /// Used to compute the maps of the coarser levels when NumberOfLevels is
+  /// greater than one. The default implementation returns nullptr, in which
+  /// case no initial guess is computed using a coarse-to-fine scheme.
+  virtual LinearFixedBoundarySurfaceMapper *NewCopy() const;
+
   // ---------------------------------------------------------------------------
   // Execution
 
@@ -109,6 +165,70 @@ public:
   /// Assemble output surface map
   virtual void Finalize();
 
+protected:
+
+  /// Get boundary map domain point corresponding to each surface point
+  ///
+  /// This lookup table is available when the boundary map was computed by
+  /// a BoundaryMapper for the input surface, which records the surface point
+  /// ID of each boundary map domain point.
+  ///
+  /// \param[out] ids Index of boundary map domain point for each surface point
+  ///                 or -1 when the surface point is not a domain point.
+  ///
+  /// \returns Whether the surface point IDs of the boundary map are known.
+  bool GetBoundaryPointIds(Array<vtkIdType> &ids) const;
+
+  /// Get non-zero pattern of linear system matrix for points with free map value
+  ///
+  /// The sparse matrix contains a diagonal entry for each free point and an
+  /// off-diagonal entry for each edge between two free points. Its pattern is
+  /// returned in compressed sparse column storage, which is identical to the
+  /// compressed sparse row storage because the pattern is symmetric.
+  ///
+  /// \param[out] offsets Index of first non-zero entry of each column and
+  ///                     total number of non-zero entries at index n.
+  /// \param[out] indices Row indices of non-zero entries sorted per column.
+  void GetSparsityPattern(Array<int> &offsets, Array<int> &indices) const;
+
+  /// Number of non-zero entries of linear system matrix
+  int NumberOfNonZeros() const;
+
+  /// Get index of non-zero entry in compressed sparse column storage
+  ///
+  /// \param[in] offsets Index of first non-zero entry of each column.
+  /// \param[in] indices Row indices of non-zero entries sorted per column.
+  /// \param[in] r       Row index of non-zero entry.
+  /// \param[in] c       Column index of non-zero entry.
+  ///
+  /// \returns Index of non-zero entry (r, c).
+  static int NonZeroIndex(const int *offsets, const int *indices, int r, int c);
+
+  /// Get stamp of surface mesh connectivity
+  ///
+  /// The stamp is computed in constant time from the number of points and
+  /// cells of the input surface, and the address and modification time of
+  /// its polygons cell array. Surfaces which share their polygons, e.g.,
+  /// shallow copies of a common template mesh with different point
+  /// coordinates, have the same stamp. It is used to look up cached data of
+  /// the sparse direct solver in the SparseSystemCache.
+  size_t TopologyStamp() const;
+
+  /// Get cached non-zero pattern and solver of linear system
+  ///
+  /// The returned entry is only shared with linear systems of equal size,
+  /// number of non-zero entries, and set of points with free map value.
+  /// Its mutex must be held by the caller while the entry is used. When
+  /// CacheSparseSystem is false, a new entry is returned which is not cached.
+  SharedPtr<SparseSystemCache::Entry> GetSparseSystemCacheEntry() const;
+
+  /// Compute initial guess of map values using coarse-to-fine scheme
+  ///
+  /// \returns Map values interpolated from next coarser level at the points
+  ///          of the input surface or nullptr if no coarser level was created
+  ///          or this mapper cannot be copied (cf. NewCopy).
+  vtkSmartPointer<vtkDataArray> ComputeInitialGuess() const;
+
   // ---------------------------------------------------------------------------
   // Auxiliaries
 
@@ -265,6 +385,15 @@ inline bool LinearFixedBoundarySurfaceMapper::IsFixedPoint(int ptId) const
   return FixedPointIndex(ptId) != -1;
 }
 
+// -----------------------------------------------------------------------------
+inline int LinearFixedBoundarySurfaceMapper
+::NonZeroIndex(const int *offsets, const int *indices, int r, int c)
+{
+  const int *begin = indices + offsets[c];
+  const int *end   = indices + offsets[c + 1];
+  return static_cast<int>(std::lower_bound(begin, end, r) - indices);
+}
+
 // -----------------------------------------------------------------------------
 inline double LinearFixedBoundarySurfaceMapper::GetValue(int i, int j) const
 {
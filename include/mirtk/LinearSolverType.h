@@ -0,0 +1,137 @@
+/*
+ * Medical Image Registration ToolKit (MIRTK)
+ *
+ * Copyright 2013-2016 Imperial College London
+ * Copyright 2013-2016 Andreas Schuh
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MIRTK_LinearSolverType_H
+#define MIRTK_LinearSolverType_H
+
+#include "mirtk/String.h"
+
+
+namespace mirtk {
+
+
+// -----------------------------------------------------------------------------
+/// Enumeration of sparse linear solvers
+enum LinearSolverType
+{
+  LinearSolver_Default,  ///< Solver chosen by map filter, e.g., based on number of iterations
+  LinearSolver_LU,       ///< Sparse supernodal LU factorization
+  LinearSolver_LDLT,     ///< Simplicial LDL^T Cholesky factorization of symmetric matrix
+  LinearSolver_LLT,      ///< Simplicial LL^T Cholesky factorization of s.p.d. matrix
+  LinearSolver_CG,       ///< Conjugate gradient method for s.p.d. matrix
+  LinearSolver_BiCGSTAB, ///< Bi-conjugate gradient stabilized method
+  LinearSolver_AMG       ///< Algebraic multigrid V-cycles for s.p.d. matrix
+};
+
+// -----------------------------------------------------------------------------
+/// Enumeration of preconditioners of iterative sparse linear solvers
+enum LinearSolverPreconditioner
+{
+  Preconditioner_Default,  ///< Preconditioner chosen by solver, i.e., Jacobi
+  Preconditioner_None,     ///< Identity, i.e., no preconditioning
+  Preconditioner_Jacobi,   ///< Diagonal (Jacobi) preconditioner
+  Preconditioner_IC,       ///< Incomplete Cholesky factorization of s.p.d. matrix
+  Preconditioner_ILUT,     ///< Incomplete LU factorization with dual thresholding
+  Preconditioner_AMG       ///< Algebraic multigrid V-cycle for s.p.d. matrix
+};
+
+// -----------------------------------------------------------------------------
+/// Whether linear solver is a direct solver based on matrix factorization
+inline bool IsDirectLinearSolver(LinearSolverType type)
+{
+  return type == LinearSolver_LU || type == LinearSolver_LDLT || type == LinearSolver_LLT;
+}
+
+// -----------------------------------------------------------------------------
+/// Whether linear solver is an iterative method
+inline bool IsIterativeLinearSolver(LinearSolverType type)
+{
+  return type == LinearSolver_CG || type == LinearSolver_BiCGSTAB || type == LinearSolver_AMG;
+}
+
+// -----------------------------------------------------------------------------
+template <>
+inline string ToString(const LinearSolverType &value, int w, char c, bool left)
+{
+  const char *str;
+  switch (value) {
+    case LinearSolver_Default:  str = "Default";  break;
+    case LinearSolver_LU:       str = "LU";       break;
+    case LinearSolver_LDLT:     str = "LDLT";     break;
+    case LinearSolver_LLT:      str = "LLT";      break;
+    case LinearSolver_CG:       str = "CG";       break;
+    case LinearSolver_BiCGSTAB: str = "BiCGSTAB"; break;
+    case LinearSolver_AMG:      str = "AMG";      break;
+    default:                    str = "Unknown";  break;
+  }
+  return ToString(str, w, c, left);
+}
+
+// -----------------------------------------------------------------------------
+template <>
+inline bool FromString(const char *str, LinearSolverType &value)
+{
+  const string lstr = ToLower(str);
+  if      (lstr == "default")  value = LinearSolver_Default;
+  else if (lstr == "lu")       value = LinearSolver_LU;
+  else if (lstr == "ldlt")     value = LinearSolver_LDLT;
+  else if (lstr == "llt" || lstr == "cholesky") value = LinearSolver_LLT;
+  else if (lstr == "cg")       value = LinearSolver_CG;
+  else if (lstr == "bicgstab") value = LinearSolver_BiCGSTAB;
+  else if (lstr == "amg")      value = LinearSolver_AMG;
+  else return false;
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+template <>
+inline string ToString(const LinearSolverPreconditioner &value, int w, char c, bool left)
+{
+  const char *str;
+  switch (value) {
+    case Preconditioner_Default: str = "Default"; break;
+    case Preconditioner_None:    str = "None";    break;
+    case Preconditioner_Jacobi:  str = "Jacobi";  break;
+    case Preconditioner_IC:      str = "IC";      break;
+    case Preconditioner_ILUT:    str = "ILUT";    break;
+    case Preconditioner_AMG:     str = "AMG";     break;
+    default:                     str = "Unknown"; break;
+  }
+  return ToString(str, w, c, left);
+}
+
+// -----------------------------------------------------------------------------
+template <>
+inline bool FromString(const char *str, LinearSolverPreconditioner &value)
+{
+  const string lstr = ToLower(str);
+  if      (lstr == "default") value = Preconditioner_Default;
+  else if (lstr == "none" || lstr == "identity") value = Preconditioner_None;
+  else if (lstr == "jacobi" || lstr == "diagonal") value = Preconditioner_Jacobi;
+  else if (lstr == "ic" || lstr == "incomplete-cholesky") value = Preconditioner_IC;
+  else if (lstr == "ilut" || lstr == "incomplete-lu") value = Preconditioner_ILUT;
+  else if (lstr == "amg" || lstr == "multigrid") value = Preconditioner_AMG;
+  else return false;
+  return true;
+}
+
+
+} // namespace mirtk
+
+#endif // MIRTK_LinearSolverType_H
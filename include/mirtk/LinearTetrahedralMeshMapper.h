@@ -23,6 +23,7 @@
 #include "mirtk/TetrahedralMeshMapper.h"
 
 #include "mirtk/Array.h"
+#include "mirtk/LinearSolverType.h"
 
 
 namespace mirtk {
@@ -48,12 +49,23 @@ class LinearTetrahedralMeshMapper : public TetrahedralMeshMapper
   // ---------------------------------------------------------------------------
   // Attributes
 
+  /// Type of sparse linear solver, conjugate gradient method by default
+  mirtkPublicAttributeMacro(LinearSolverType, LinearSolver);
+
+  /// Preconditioner of iterative sparse linear solver
+  mirtkPublicAttributeMacro(LinearSolverPreconditioner, Preconditioner);
+
   /// Maximum number of linear solver iterations
   mirtkPublicAttributeMacro(int, NumberOfIterations);
 
   /// Linear solver tolerance
   mirtkPublicAttributeMacro(double, Tolerance);
 
+  /// Whether to factorize or precondition the linear system in single precision
+  ///
+  /// \sa SparseLinearSolver::MixedPrecision
+  mirtkPublicAttributeMacro(bool, MixedPrecision);
+
   /// Relaxation factor
   mirtkPublicAttributeMacro(double, RelaxationFactor);
 
@@ -183,6 +183,27 @@ public:
   /// \returns Whether input point is inside map domain.
   bool Evaluate(double *v, const Point &p) const;
 
+  /// Evaluate map at multiple points
+  ///
+  /// Input and output buffers are in structure-of-arrays layout, i.e., the l-th
+  /// component of the map value at the i-th point is stored at v[l * n + i].
+  /// The map values of points outside the map domain are set to the \c OutsideValue.
+  ///
+  /// The default implementation evaluates the map at each point separately.
+  /// Subclasses override this function to share temporary buffers and other
+  /// per query setup costs among all points of a batch.
+  ///
+  /// \param[out] v      Map values, array of size n * NumberOfComponents().
+  /// \param[in]  n      Number of points.
+  /// \param[in]  x      Coordinates of points along x axis.
+  /// \param[in]  y      Coordinates of points along y axis.
+  /// \param[in]  z      Coordinates of points along z axis or nullptr if all zero.
+  /// \param[out] inside Whether the i-th input point is inside the map domain.
+  ///
+  /// \returns Number of input points inside map domain.
+  virtual int Evaluate(double *v, int n, const double *x, const double *y,
+                       const double *z = nullptr, bool *inside = nullptr) const;
+
   /// Evaluate map at a given point
   ///
   /// \param[in] x Coordinate of point along x axis at which to evaluate map.
@@ -308,7 +329,13 @@ inline bool Mapping::Evaluate(double *v, const Point &p) const
 // -----------------------------------------------------------------------------
 inline double Mapping::Evaluate(double x, double y, double z, int l) const
 {
-  double * const v = new double[this->NumberOfComponents()];
+  const int dim = this->NumberOfComponents();
+  if (dim <= 3) {
+    double v[3];
+    this->Evaluate(v, x, y, z);
+    return v[l];
+  }
+  double * const v = new double[dim];
   this->Evaluate(v, x, y, z);
   const double s = v[l];
   delete[] v;
@@ -0,0 +1,220 @@
+/*
+ * Medical Image Registration ToolKit (MIRTK)
+ *
+ * Copyright 2013-2016 Imperial College London
+ * Copyright 2013-2016 Andreas Schuh
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MIRTK_MeshReordering_H
+#define MIRTK_MeshReordering_H
+
+#include "mirtk/Object.h"
+#include "mirtk/Array.h"
+#include "mirtk/String.h"
+
+#include "vtkSmartPointer.h"
+#include "vtkPointSet.h"
+#include "vtkDataArray.h"
+
+
+namespace mirtk {
+
+
+// -----------------------------------------------------------------------------
+/// Enumeration of point and cell orderings of a mesh
+enum MeshOrdering
+{
+  MeshOrdering_None, ///< Keep order of input mesh
+  MeshOrdering_RCM,  ///< Reverse Cuthill-McKee ordering of point graph
+  MeshOrdering_SFC   ///< Morton order of points along space-filling curve
+};
+
+// -----------------------------------------------------------------------------
+template <>
+inline string ToString(const MeshOrdering &value, int w, char c, bool left)
+{
+  const char *str;
+  switch (value) {
+    case MeshOrdering_None: str = "None";    break;
+    case MeshOrdering_RCM:  str = "RCM";     break;
+    case MeshOrdering_SFC:  str = "SFC";     break;
+    default:                str = "Unknown"; break;
+  }
+  return ToString(str, w, c, left);
+}
+
+// -----------------------------------------------------------------------------
+template <>
+inline bool FromString(const char *str, MeshOrdering &value)
+{
+  const string lstr = ToLower(str);
+  if      (lstr == "none" || lstr == "input") value = MeshOrdering_None;
+  else if (lstr == "rcm"  || lstr == "cuthill-mckee") value = MeshOrdering_RCM;
+  else if (lstr == "sfc"  || lstr == "morton" || lstr == "space-filling-curve") value = MeshOrdering_SFC;
+  else return false;
+  return true;
+}
+
+
+/**
+ * Renumber points and cells of a mesh to improve locality of memory accesses
+ *
+ * Meshes produced by marching cubes or external remeshing tools often have
+ * a point order which is unrelated to the mesh connectivity. Neighboring
+ * points are then far apart in memory, which slows down the iteration over
+ * edges, sparse matrix products, and the traversal of the cells of a map
+ * domain by a point locator.
+ *
+ * This filter computes a new order of the mesh points either by the reverse
+ * Cuthill-McKee (RCM) algorithm, which minimizes the bandwidth of the graph
+ * Laplacian, or by sorting the points along a Morton (Z-order) space-filling
+ * curve (SFC). The cells are then sorted by their smallest new point ID.
+ * The output mesh has the same type as the input mesh, which must be either
+ * a vtkPolyData or a vtkUnstructuredGrid, and its point and cell data arrays
+ * are permuted accordingly. The ID maps from output to input IDs and vice
+ * versa are used to restore the input order of values computed for the
+ * output mesh.
+ */
+class MeshReordering : public Object
+{
+  mirtkObjectMacro(MeshReordering);
+
+  // ---------------------------------------------------------------------------
+  // Attributes
+
+  /// Input mesh
+  mirtkPublicAttributeMacro(vtkSmartPointer<vtkPointSet>, Input);
+
+  /// Ordering of output points
+  mirtkPublicAttributeMacro(MeshOrdering, Ordering);
+
+  /// Reordered output mesh
+  mirtkReadOnlyAttributeMacro(vtkSmartPointer<vtkPointSet>, Output);
+
+  /// Input point ID of each output point
+  mirtkReadOnlyAttributeMacro(Array<int>, OriginalPointIds);
+
+  /// Output point ID of each input point
+  mirtkReadOnlyAttributeMacro(Array<int>, ReorderedPointIds);
+
+  /// Input cell ID of each output cell
+  mirtkReadOnlyAttributeMacro(Array<int>, OriginalCellIds);
+
+  /// Output cell ID of each input cell
+  mirtkReadOnlyAttributeMacro(Array<int>, ReorderedCellIds);
+
+  /// Copy attributes of this class from another instance
+  void CopyAttributes(const MeshReordering &);
+
+  // ---------------------------------------------------------------------------
+  // Construction/Destruction
+
+public:
+
+  /// Constructor
+  MeshReordering(MeshOrdering = MeshOrdering_RCM);
+
+  /// Copy constructor
+  MeshReordering(const MeshReordering &);
+
+  /// Assignment operator
+  MeshReordering &operator =(const MeshReordering &);
+
+  /// Destructor
+  virtual ~MeshReordering();
+
+  // ---------------------------------------------------------------------------
+  // Execution
+
+  /// Compute new point and cell order and reordered output mesh
+  void Run();
+
+  // ---------------------------------------------------------------------------
+  // Auxiliaries
+
+  /// Input point ID of output point
+  int OriginalPointId(int) const;
+
+  /// Output point ID of input point
+  int ReorderedPointId(int) const;
+
+  /// Input cell ID of output cell
+  int OriginalCellId(int) const;
+
+  /// Output cell ID of input cell
+  int ReorderedCellId(int) const;
+
+  /// Permute values given for each input point into output point order
+  ///
+  /// \param[in] values Data array with one tuple per input point.
+  ///
+  /// \returns New data array with one tuple per output point.
+  vtkSmartPointer<vtkDataArray> ApplyPointOrder(vtkDataArray *values) const;
+
+  /// Restore input point order of values given for each output point
+  ///
+  /// \param[in] values Data array with one tuple per output point.
+  ///
+  /// \returns New data array with one tuple per input point.
+  vtkSmartPointer<vtkDataArray> RestorePointOrder(vtkDataArray *values) const;
+
+protected:
+
+  /// Compute reverse Cuthill-McKee ordering of mesh points
+  void ComputeCuthillMcKeeOrder(Array<int> &order) const;
+
+  /// Compute Morton order of mesh points
+  void ComputeMortonOrder(Array<int> &order) const;
+
+  /// Compute new order of cells given new order of points
+  void ComputeCellOrder(Array<int> &order) const;
+
+  /// Create output mesh with permuted points and cells
+  void CreateOutput();
+
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Inline definitions
+////////////////////////////////////////////////////////////////////////////////
+
+// -----------------------------------------------------------------------------
+inline int MeshReordering::OriginalPointId(int ptId) const
+{
+  return _OriginalPointIds[ptId];
+}
+
+// -----------------------------------------------------------------------------
+inline int MeshReordering::ReorderedPointId(int ptId) const
+{
+  return _ReorderedPointIds[ptId];
+}
+
+// -----------------------------------------------------------------------------
+inline int MeshReordering::OriginalCellId(int cellId) const
+{
+  return _OriginalCellIds[cellId];
+}
+
+// -----------------------------------------------------------------------------
+inline int MeshReordering::ReorderedCellId(int cellId) const
+{
+  return _ReorderedCellIds[cellId];
+}
+
+
+} // namespace mirtk
+
+#endif // MIRTK_MeshReordering_H
@@ -48,6 +48,13 @@ public:
   /// \returns Biharmonic kernel function value.
   static double B(double d);
 
+protected:
+
+  /// Copy source points and kernel function weights to structure-of-arrays layout
+  virtual SharedPtr<KernelSources> NewKernelSources() const;
+
+public:
+
   // ---------------------------------------------------------------------------
   // Construction/Destruction
 
@@ -85,6 +92,20 @@ public:
   /// \returns Whether input point is inside map domain.
   virtual bool Evaluate(double *v, double x, double y, double z = 0) const;
 
+  /// Evaluate map at multiple points
+  ///
+  /// \param[out] v      Map values, array of size n * NumberOfComponents(),
+  ///                    where v[l * n + i] is the l-th component at the i-th point.
+  /// \param[in]  n      Number of points.
+  /// \param[in]  x      Coordinates of points along x axis.
+  /// \param[in]  y      Coordinates of points along y axis.
+  /// \param[in]  z      Coordinates of points along z axis or nullptr if all zero.
+  /// \param[out] inside Whether the i-th input point is inside the map domain.
+  ///
+  /// \returns Number of input points inside map domain.
+  virtual int Evaluate(double *v, int n, const double *x, const double *y,
+                       const double *z = nullptr, bool *inside = nullptr) const;
+
   /// Evaluate map at a given point
   ///
   /// \param[in] x Coordinate of point along x axis at which to evaluate map.
@@ -22,7 +22,9 @@
 
 #include "mirtk/MeshlessMap.h"
 
+#include "mirtk/Array.h"
 #include "mirtk/Math.h"
+#include "mirtk/Memory.h"
 #include "mirtk/PointSet.h"
 #include "mirtk/Vector.h"
 
@@ -40,6 +42,91 @@ class MeshlessHarmonicMap : public MeshlessMap
 {
   mirtkObjectMacro(MeshlessHarmonicMap);
 
+  // ---------------------------------------------------------------------------
+  // Attributes
+
+  /// Opening angle of Barnes-Hut treecode used to evaluate the map
+  ///
+  /// The sum of kernel functions centered at a cluster of source points is
+  /// approximated by its monopole and dipole moments when the ratio of the
+  /// cluster radius to the distance of the query point from the cluster center
+  /// is less than this angle. Smaller values are more accurate, but slower.
+  /// When zero, the map is evaluated by direct summation over all source points.
+  ///
+  /// \note The treecode is built by Initialize, which must thus be called after
+  ///       the source points or coefficients were modified. It is discarded
+  ///       when source points are added.
+  mirtkPublicAttributeMacro(double, OpeningAngle);
+
+public:
+
+  /// Octree of source points with multipole moments
+  struct Treecode;
+
+  /// Source points and kernel function weights in structure-of-arrays layout
+  struct KernelSources
+  {
+    int           NumberOfSources;    ///< Number of source points
+    int           NumberOfComponents; ///< Number of map components
+    Array<double> X, Y, Z;            ///< Source point coordinates
+    Array<double> H;                  ///< Weights of kernel functions 1/d, where H[j * n + i] is the
+                                      ///< weight of the i-th source point for the j-th component
+    Array<double> B;                  ///< Weights of kernel functions d or empty
+  };
+
+protected:
+
+  /// Octree of source points used when opening angle is positive
+  SharedPtr<Treecode> _Treecode;
+
+  /// Source points and kernel function weights used to evaluate the map at
+  /// multiple points, built by Initialize
+  SharedPtr<KernelSources> _KernelSources;
+
+  /// Copy attributes of this class from another instance
+  void CopyAttributes(const MeshlessHarmonicMap &);
+
+  /// Build octree of source points and compute multipole moments
+  void BuildTreecode();
+
+  /// Evaluate map at a given point using treecode
+  ///
+  /// \param[out] v Map value.
+  /// \param[in]  s Stride of map value components in output array.
+  /// \param[in]  p Point at which to evaluate map.
+  ///
+  /// \returns Whether input point is inside map domain.
+  bool EvaluateTreecode(double *v, int s, const double p[3]) const;
+
+  /// Copy source points and kernel function weights to structure-of-arrays layout
+  virtual SharedPtr<KernelSources> NewKernelSources() const;
+
+  /// Get source points and kernel function weights built by Initialize
+  ///
+  /// \returns Copy made by NewKernelSources when Initialize was not called
+  ///          after the source points or coefficients were last resized.
+  SharedPtr<KernelSources> GetKernelSources() const;
+
+  /// Evaluate weighted sum of kernel functions at multiple points
+  ///
+  /// The kernel functions are summed for blocks of points at a time using
+  /// loops which are vectorized by the compiler.
+  ///
+  /// \param[out] v      Map values, where v[j * n + i] is the j-th component at the i-th point.
+  /// \param[in]  n      Number of points.
+  /// \param[in]  x      Coordinates of points along x axis.
+  /// \param[in]  y      Coordinates of points along y axis.
+  /// \param[in]  z      Coordinates of points along z axis or nullptr if all zero.
+  /// \param[out] inside Whether the i-th input point is inside the map domain.
+  /// \param[in]  src    Source points and kernel function weights.
+  ///
+  /// \returns Number of input points inside map domain.
+  int EvaluateKernels(double *v, int n, const double *x, const double *y,
+                      const double *z, bool *inside, const KernelSources &src) const;
+
+  /// Discard treecode and kernel sources built by Initialize
+  virtual void SourcePointsModified();
+
 public:
 
   // ---------------------------------------------------------------------------
@@ -64,6 +151,9 @@ public:
   /// Assignment operator
   MeshlessHarmonicMap &operator =(const MeshlessHarmonicMap &);
 
+  /// Initialize map after inputs and parameters are set
+  virtual void Initialize();
+
   /// Make deep copy of this volumetric map
   virtual Mapping *NewCopy() const;
 
@@ -86,6 +176,20 @@ public:
   /// \returns Whether input point is inside map domain.
   virtual bool Evaluate(double *v, double x, double y, double z = .0) const;
 
+  /// Evaluate map at multiple points
+  ///
+  /// \param[out] v      Map values, array of size n * NumberOfComponents(),
+  ///                    where v[l * n + i] is the l-th component at the i-th point.
+  /// \param[in]  n      Number of points.
+  /// \param[in]  x      Coordinates of points along x axis.
+  /// \param[in]  y      Coordinates of points along y axis.
+  /// \param[in]  z      Coordinates of points along z axis or nullptr if all zero.
+  /// \param[out] inside Whether the i-th input point is inside the map domain.
+  ///
+  /// \returns Number of input points inside map domain.
+  virtual int Evaluate(double *v, int n, const double *x, const double *y,
+                       const double *z = nullptr, bool *inside = nullptr) const;
+
   /// Evaluate map at a given point
   ///
   /// \param[in] x Coordinate of point along x axis at which to evaluate map.
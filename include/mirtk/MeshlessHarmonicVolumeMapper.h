@@ -88,6 +88,13 @@ protected:
   /// \returns Whether source point was added or too close to existing point.
   virtual bool AddSourcePoint(double q[3]);
 
+  /// Add source points after filter initialization
+  ///
+  /// \param[in] points Source points.
+  ///
+  /// \returns Number of source points added, i.e., not too close to existing points.
+  virtual int AddSourcePoints(const PointSet &points);
+
   /// Compute meshless map coefficients
   virtual void Solve();
 
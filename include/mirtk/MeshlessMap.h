@@ -23,6 +23,7 @@
 #include "mirtk/Mapping.h"
 
 #include "mirtk/Math.h"
+#include "mirtk/Memory.h"
 #include "mirtk/Matrix.h"
 #include "mirtk/PointSet.h"
 
@@ -55,9 +56,31 @@ private:
   /// The columns contain the source point weights for each scalar map.
   mirtkPublicAttributeMacro(Matrix, Coefficients);
 
+public:
+
+  /// Hash grid of source points used to find points within a given distance
+  struct SourcePointGrid;
+
+private:
+
+  /// Hash grid of source points added with non-zero tolerance
+  ///
+  /// The grid is kept across calls of AddSourcePoint and AddSourcePoints and
+  /// updated with source points which were set otherwise before it is used.
+  SharedPtr<SourcePointGrid> _SourcePointGrid;
+
   /// Copy attributes of this class from another instance
   void CopyAttributes(const MeshlessMap &);
 
+  /// Get hash grid of current source points for given tolerance
+  SourcePointGrid &UpdateSourcePointGrid(double tol);
+
+  /// Reserve storage for additional source points
+  ///
+  /// The capacity is grown geometrically such that adding source points one
+  /// at a time takes amortized constant time.
+  void ReserveSourcePoints(int m);
+
   // ---------------------------------------------------------------------------
   // Construction/Destruction
 
@@ -102,12 +125,40 @@ public:
 
   /// Add source point with zero coefficient
   ///
+  /// Points which are too close to an existing source point are found using
+  /// a hash grid which is kept by the map.
+  ///
+  /// \param[in] p   Source point to add.
+  /// \param[in] tol Minimum distance along each axis from existing points.
+  ///
   /// \returns Whether source point was added or too close to existing point.
   bool AddSourcePoint(double p[3], double tol = .0);
 
+  /// Add source points with zero coefficients
+  ///
+  /// Unlike repeated calls of AddSourcePoint, this function resizes the
+  /// coefficients matrix only once. Points which are too close to an existing
+  /// or previously added point are found using the same hash grid.
+  ///
+  /// \param[in] points Source points to add.
+  /// \param[in] tol    Minimum distance along each axis from existing points.
+  ///
+  /// \returns Number of source points added.
+  int AddSourcePoints(const PointSet &points, double tol = .0);
+
   /// Get number of source points
   int NumberOfSourcePoints() const;
 
+protected:
+
+  /// Called after source points were added or read from a file
+  ///
+  /// Subclasses override this function to discard data derived from the
+  /// source points and coefficients by Initialize.
+  virtual void SourcePointsModified();
+
+public:
+
   // ---------------------------------------------------------------------------
   // Evaluation
 
@@ -131,24 +182,6 @@ protected:
 // Inline definitions
 ////////////////////////////////////////////////////////////////////////////////
 
-// -----------------------------------------------------------------------------
-inline bool MeshlessMap::AddSourcePoint(double p[3], double tol)
-{
-  if (tol > .0) {
-    for (int i = 0; i < _SourcePoints.Size(); ++i) {
-      const Point &q = _SourcePoints(i);
-      if (fequal(p[0], q._x, tol) &&
-          fequal(p[1], q._y, tol) &&
-          fequal(p[2], q._z, tol)) {
-        return false;
-      }
-    }
-  }
-  _SourcePoints.Add(p);
-  _Coefficients.Resize(_SourcePoints.Size(), _Coefficients.Cols());
-  return true;
-}
-
 // -----------------------------------------------------------------------------
 inline int MeshlessMap::NumberOfSourcePoints() const
 {
@@ -168,6 +168,13 @@ protected:
   /// \returns Whether source point was added or too close to existing point.
   virtual bool AddSourcePoint(double q[3]);
 
+  /// Add new source points
+  ///
+  /// \param[in] points Source points.
+  ///
+  /// \returns Number of source points added, i.e., not too close to existing points.
+  virtual int AddSourcePoints(const PointSet &points);
+
   /// Evenly partition source points into smaller subsets
   virtual void PartitionSourcePoints();
 
@@ -36,6 +36,15 @@ namespace mirtk {
  * of independently computed conformal and authalic surface maps with given fixed
  * boundary values which minimize a certain non-linear distortion criterion.
  *
+ * The conformal and authalic weights of the edges are computed only once from
+ * the triangle geometry and shared by the two linear systems of the conformal
+ * and authalic maps. Both system matrices have the same non-zero pattern, such
+ * that the cached sparse solver reuses the symbolic analysis of the first system
+ * matrix for the second (cf. SparseSystemCache). Optionally, the linear system
+ * with the near-optimal affine combination of edge weights is solved afterwards,
+ * where the affine combination of the two maps is the initial guess of an
+ * iterative solver.
+ *
  * - Desbrun, Meyer, and Alliez (2002). Intrinsic parameterizations of surface meshes.
  *   Computer Graphics Forum, 21(3), 209–218.
  */
@@ -46,6 +55,12 @@ class NearOptimalIntrinsicSurfaceMapper : public IntrinsicSurfaceMapper
   // ---------------------------------------------------------------------------
   // Attributes
 
+  /// Whether to solve the linear system with the near-optimal lambda value
+  ///
+  /// When false, the surface map values are the affine combination of the
+  /// discrete conformal and authalic maps with the near-optimal lambda value.
+  mirtkPublicAttributeMacro(bool, ExactSolution);
+
   /// Copy attributes of this class from another instance
   void CopyAttributes(const NearOptimalIntrinsicSurfaceMapper &);
 
@@ -39,6 +39,11 @@ class NonSymmetricWeightsSurfaceMapper : public LinearFixedBoundarySurfaceMapper
   /// Copy attributes of this class from another instance
   void CopyAttributes(const NonSymmetricWeightsSurfaceMapper &);
 
+  // Auxiliary functors used to assemble linear system in parallel
+  struct VirtualWeights;
+  struct DirectedEdgeWeightArray;
+  template <class TWeights> struct AssembleLinearSystem;
+
   // ---------------------------------------------------------------------------
   // Construction/Destruction
 
@@ -89,8 +94,25 @@ protected:
   ///       edge weights requires common intermediate computations, it is more
   ///       efficient to compute all edge weights in an overridden subclass
   ///       implementation of this function. The Weight function is then unused.
+  ///
+  /// \note This function is called concurrently for different nodes i by the
+  ///       parallel assembly of the linear system. Implementations must thus
+  ///       only write to \p w, and should avoid heap allocations which would
+  ///       otherwise serialize the threads on the memory allocator.
   virtual void Weights(int i, const int *j, double *w, int d) const;
 
+  /// Compute weights of all directed edges at once
+  ///
+  /// \param[out] w Weight of each directed edge (i, j) with edge ID e at
+  ///               index 2 * e if i < j, and index 2 * e + 1 otherwise.
+  ///
+  /// \note The default implementation returns an empty array, in which case
+  ///       the Weights function is called for each free point. Subclasses
+  ///       whose weights are cheaper to compute per edge from precomputed
+  ///       geometric quantities override this function instead, which allows
+  ///       the weight lookup to be inlined into the assembly loop.
+  virtual void ComputeWeights(Array<double> &w) const;
+
 };
 
 
@@ -22,12 +22,21 @@
 
 #include "mirtk/Mapping.h"
 #include "mirtk/Point.h"
+#include "mirtk/Array.h"
+#include "mirtk/Memory.h"
+#include "mirtk/SimplexLocator.h"
 
 #include "vtkSmartPointer.h"
 #include "vtkDataSet.h"
 #include "vtkDataArray.h"
 #include "vtkAbstractCellLocator.h"
 
+#include <mutex>
+#include <atomic>
+
+class vtkGenericCell;
+class vtkIdList;
+
 
 namespace mirtk {
 
@@ -58,12 +67,39 @@ class PiecewiseLinearMap : public Mapping
   /// Point data array with map values at mesh points
   mirtkPublicAttributeMacro(vtkSmartPointer<vtkDataArray>, Values);
 
+public:
+
+  /// Locates cell within which a given point lies
+  ///
+  /// The locator is built on first query of a map value at an arbitrary point.
+  /// It is shared by copies of the map until either of these is re-initialized.
+  struct CellLocator
+  {
+    std::mutex                              Mutex;   ///< Guards construction of locator
+    std::atomic<bool>                       Built;   ///< Whether locator was built
+    vtkSmartPointer<vtkAbstractCellLocator> Generic; ///< Generic VTK cell locator
+    SharedPtr<SimplexLocator>               Simplex; ///< Triangle or tetrahedron locator
+
+    /// Constructor
+    CellLocator() : Built(false) {}
+  };
+
+private:
+
   /// Locates cell within which a given point lies
-  mirtkAttributeMacro(vtkSmartPointer<vtkAbstractCellLocator>, Locator);
+  mirtkAttributeMacro(SharedPtr<CellLocator>, Locator);
 
   /// Maximum number cell points
   mirtkAttributeMacro(int, MaxCellSize);
 
+  /// Maximum number of cells visited when walking from the cell containing
+  /// the previous query point towards the next query point before the global
+  /// cell locator is used to find the cell containing the query point
+  ///
+  /// The walk is only used for triangle and tetrahedral meshes. When zero,
+  /// only the cell containing the previous query point is tested.
+  mirtkPublicAttributeMacro(int, MaxWalkSteps);
+
   /// Squared distance tolerance used to locate cells
   /// \note Unused argument of vtkCellLocator::FindCell (as of VTK <= 7.0).
   static const double _Tolerance2;
@@ -71,6 +107,63 @@ class PiecewiseLinearMap : public Mapping
   /// Copy attributes of this class from another instance
   void CopyAttributes(const PiecewiseLinearMap &);
 
+  // ---------------------------------------------------------------------------
+  // Evaluation context
+
+public:
+
+  /// Temporary objects used to locate the cell containing a query point
+  ///
+  /// A context can be reused for any number of queries of the same map, but it
+  /// must not be shared by concurrently executing threads. The map itself is
+  /// not modified by any Evaluate function and can thus be evaluated by many
+  /// threads at the same time as long as each thread uses its own context.
+  ///
+  /// The search starts at the cell found for the previous query point, from
+  /// which it walks across shared faces towards the query point. Map values
+  /// at points on the shared face of two cells may therefore differ by
+  /// round-off error depending on the order in which the points are queried.
+  struct EvaluationContext
+  {
+    vtkSmartPointer<vtkGenericCell> Cell;         ///< Cell found for previous query point
+    Array<double>                   Weights;      ///< Interpolation weights of cell points
+    vtkIdType                       CellId;       ///< ID of previous cell or -1
+    Array<vtkIdType>                PointIds;     ///< IDs of points of found cell
+    const vtkDataSet               *Domain;       ///< Domain of map last evaluated
+    const CellLocator              *Locator;      ///< Cell locator of map last evaluated
+    vtkSmartPointer<vtkIdList>      FacePointIds; ///< Points of face crossed by walk
+    vtkSmartPointer<vtkIdList>      NeighborIds;  ///< Cells sharing crossed face
+
+    /// Constructor
+    EvaluationContext();
+
+    /// Destructor
+    ~EvaluationContext();
+  };
+
+protected:
+
+  /// Build cell locator unless done before
+  ///
+  /// This function is called by FindCell and may be called concurrently by
+  /// multiple threads evaluating the map.
+  void BuildLocator() const;
+
+  /// Find cell containing given point
+  ///
+  /// \param[in,out] ctx Evaluation context. The cell points and interpolation
+  ///                    weights of the found cell are stored in this context.
+  /// \param[in]     p   Query point.
+  ///
+  /// \returns ID of cell containing the query point or -1 if point is outside.
+  vtkIdType FindCell(EvaluationContext &ctx, double p[3]) const;
+
+  /// Evaluate map at each point of a regular lattice
+  ///
+  /// \sa Evaluate(GenericImage<float> &, int, vtkSmartPointer<vtkPointSet>)
+  template <class TVoxel>
+  void EvaluateLattice(GenericImage<TVoxel> &f, int l, vtkSmartPointer<vtkPointSet> m) const;
+
   // ---------------------------------------------------------------------------
   // Construction/Destruction
 
@@ -181,6 +274,9 @@ public:
 
   /// Evaluate map at a given point
   ///
+  /// The cell containing the query point is searched for starting at the cell
+  /// found for the previous query point of the calling thread.
+  ///
   /// \param[out] v Map value.
   /// \param[in]  x Coordinate of point along x axis at which to evaluate map.
   /// \param[in]  y Coordinate of point along y axis at which to evaluate map.
@@ -189,6 +285,36 @@ public:
   /// \returns Whether input point is inside map domain.
   virtual bool Evaluate(double *v, double x, double y, double z = 0) const;
 
+  /// Evaluate map at a given point
+  ///
+  /// \param[in,out] ctx Evaluation context of calling thread.
+  /// \param[out]    v   Map value.
+  /// \param[in]     x   Coordinate of point along x axis at which to evaluate map.
+  /// \param[in]     y   Coordinate of point along y axis at which to evaluate map.
+  /// \param[in]     z   Coordinate of point along z axis at which to evaluate map.
+  ///
+  /// \returns Whether input point is inside map domain.
+  bool Evaluate(EvaluationContext &ctx, double *v, double x, double y, double z = 0) const;
+
+  /// Evaluate map at multiple points
+  ///
+  /// Large batches of query points are traversed in Morton order such that
+  /// consecutive query points are likely contained in the same or nearby cells.
+  /// Query points which are monotonically ordered along each axis, such as the
+  /// points of a lattice row, are traversed in the given order.
+  ///
+  /// \param[out] v      Map values, array of size n * NumberOfComponents(),
+  ///                    where v[l * n + i] is the l-th component at the i-th point.
+  /// \param[in]  n      Number of points.
+  /// \param[in]  x      Coordinates of points along x axis.
+  /// \param[in]  y      Coordinates of points along y axis.
+  /// \param[in]  z      Coordinates of points along z axis or nullptr if all zero.
+  /// \param[out] inside Whether the i-th input point is inside the map domain.
+  ///
+  /// \returns Number of input points inside map domain.
+  virtual int Evaluate(double *v, int n, const double *x, const double *y,
+                       const double *z = nullptr, bool *inside = nullptr) const;
+
   /// Evaluate map at a given point
   ///
   /// \param[in] x Coordinate of point along x axis at which to evaluate map.
@@ -200,6 +326,28 @@ public:
   ///          or the \c OutsideValue when input point is outside the map domain.
   virtual double Evaluate(double x, double y, double z = 0, int l = 0) const;
 
+  /// Evaluate map at each point of a regular lattice
+  ///
+  /// When the map domain is a tetrahedral mesh and the lattice is 3D, or the
+  /// domain is a triangulated planar surface and the lattice is 2D, each cell
+  /// is scan-converted onto the lattice and the map values are interpolated
+  /// using the barycentric coordinates of the lattice points. Otherwise, the
+  /// map is evaluated at each lattice point separately.
+  ///
+  /// \param[out] f Defines lattice on which to evaluate the map. The map value
+  ///               at each lattice point is stored at the respective voxel.
+  ///               The number of map values stored in the output image is
+  ///               determined by the temporal dimension of the image.
+  /// \param[in]  l Index of first map value component to store in output image.
+  /// \param[in]  m Piecewise linear complex (PLC) defining an arbitrary subset
+  ///               of the lattice points at which to evaluate the map.
+  virtual void Evaluate(GenericImage<float> &f, int l = 0, vtkSmartPointer<vtkPointSet> m = nullptr) const;
+
+  /// Evaluate map at each point of a regular lattice
+  ///
+  /// \sa Evaluate(GenericImage<float> &, int, vtkSmartPointer<vtkPointSet>)
+  virtual void Evaluate(GenericImage<double> &f, int l = 0, vtkSmartPointer<vtkPointSet> m = nullptr) const;
+
   // ---------------------------------------------------------------------------
   // I/O
 
@@ -21,6 +21,7 @@
 #define MIRTK_ShapePreservingSurfaceMapper_H
 
 #include "mirtk/NonSymmetricWeightsSurfaceMapper.h"
+#include "mirtk/TriangleMeshGeometry.h"
 
 
 namespace mirtk {
@@ -46,6 +47,9 @@ class ShapePreservingSurfaceMapper : public NonSymmetricWeightsSurfaceMapper
   // ---------------------------------------------------------------------------
   // Attributes
 
+  /// Point coordinates used by ComputeMap
+  mirtkAttributeMacro(SharedPtr<TriangleMeshGeometry>, Geometry);
+
   /// Copy attributes of this class from another instance
   void CopyAttributes(const ShapePreservingSurfaceMapper &);
 
@@ -66,9 +70,15 @@ public:
   /// Destructor
   virtual ~ShapePreservingSurfaceMapper();
 
+  /// Create new copy of this instance
+  virtual LinearFixedBoundarySurfaceMapper *NewCopy() const;
+
   // ---------------------------------------------------------------------------
   // Execution
 
+  /// Copy point coordinates to contiguous arrays and solve linear system
+  virtual void ComputeMap();
+
 protected:
 
   /// Weights of edges adjacent to node i
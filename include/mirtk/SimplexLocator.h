@@ -0,0 +1,222 @@
+/*
+ * Medical Image Registration ToolKit (MIRTK)
+ *
+ * Copyright 2013-2016 Imperial College London
+ * Copyright 2013-2016 Andreas Schuh
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MIRTK_SimplexLocator_H
+#define MIRTK_SimplexLocator_H
+
+#include "mirtk/Object.h"
+#include "mirtk/Array.h"
+
+#include "vtkSmartPointer.h"
+#include "vtkDataSet.h"
+
+
+namespace mirtk {
+
+
+/**
+ * Bounding volume hierarchy of triangles or tetrahedra
+ *
+ * This locator finds the triangle or tetrahedron of a simplicial mesh which
+ * contains a given query point. Unlike vtkCellLocator, it is restricted to
+ * meshes made up of only triangles or only tetrahedra, for which it stores
+ * the affine map from world coordinates to the barycentric coordinates of
+ * each cell. The point-in-simplex test and subsequent interpolation of a
+ * piecewise linear function is thus a single small matrix-vector product.
+ *
+ * The hierarchy is stored as flat array of nodes in depth-first order, where
+ * the left child of a node immediately follows its parent node.
+ */
+class SimplexLocator : public Object
+{
+  mirtkObjectMacro(SimplexLocator);
+
+  // ---------------------------------------------------------------------------
+  // Types
+
+public:
+
+  /// Node of bounding volume hierarchy
+  struct Node
+  {
+    double Bounds[6]; ///< Bounding box [x1, x2, y1, y2, z1, z2]
+    int    Begin;     ///< Index of first simplex of leaf node
+    int    End;       ///< Index after last simplex of leaf node
+    int    Right;     ///< Index of right child node or -1 if leaf node
+  };
+
+  // ---------------------------------------------------------------------------
+  // Attributes
+
+private:
+
+  /// Triangle or tetrahedral mesh
+  mirtkPublicAttributeMacro(vtkSmartPointer<vtkDataSet>, DataSet);
+
+  /// Maximum number of simplices stored in a leaf node
+  mirtkPublicAttributeMacro(int, MaxCellsPerNode);
+
+  /// Tolerance of barycentric coordinates used to test if a point lies in a simplex
+  ///
+  /// A point is considered inside a simplex when none of its barycentric
+  /// coordinates is less than the negative tolerance. The default value of
+  /// 1e-3 is the parametric coordinate tolerance of vtkTriangle and vtkTetra.
+  mirtkPublicAttributeMacro(double, Tolerance);
+
+  /// Squared distance tolerance used to test if a point lies in a triangle plane
+  mirtkPublicAttributeMacro(double, Tolerance2);
+
+  /// Dimension of simplices, i.e., 2 for triangles and 3 for tetrahedra
+  mirtkReadOnlyAttributeMacro(int, Dimension);
+
+  /// Nodes of bounding volume hierarchy
+  Array<Node> _Nodes;
+
+  /// IDs of simplices in the order referenced by leaf nodes
+  Array<vtkIdType> _CellIds;
+
+  /// Index of simplex in leaf node order given its cell ID or -1 if degenerate
+  Array<int> _CellIndex;
+
+  /// IDs of simplex vertices, four per simplex
+  Array<vtkIdType> _PointIds;
+
+  /// Coefficients of affine map from world to barycentric coordinates
+  ///
+  /// The first three arrays contain the coordinates of the first vertex and
+  /// the remaining nine the row-major 3x3 inverse of the matrix whose columns
+  /// are the edge vectors from the first vertex to the other vertices.
+  /// In case of a triangle, the third column is the unit normal such that the
+  /// third coordinate is the signed distance of the point to the triangle plane.
+  /// Each array stores the respective coefficient of all simplices.
+  Array<double> _Coefficients[12];
+
+  /// Copy attributes of this class from another instance
+  void CopyAttributes(const SimplexLocator &);
+
+  // ---------------------------------------------------------------------------
+  // Construction/Destruction
+
+public:
+
+  /// Default constructor
+  SimplexLocator();
+
+  /// Copy constructor
+  SimplexLocator(const SimplexLocator &);
+
+  /// Assignment operator
+  SimplexLocator &operator =(const SimplexLocator &);
+
+  /// Destructor
+  virtual ~SimplexLocator();
+
+  /// Whether a given mesh consists only of triangles or only of tetrahedra
+  static bool IsSimplicial(vtkDataSet *);
+
+  /// Build bounding volume hierarchy
+  void Initialize();
+
+  // ---------------------------------------------------------------------------
+  // Point location
+
+  /// Number of vertices of each simplex
+  int NumberOfCellPoints() const;
+
+  /// Get barycentric coordinates of point with respect to given simplex
+  ///
+  /// \param[in]  cellId ID of simplex.
+  /// \param[in]  p      Query point.
+  /// \param[out] w      Barycentric coordinates, i.e., interpolation weights.
+  ///
+  /// \returns Whether the point lies inside the simplex.
+  bool Weights(vtkIdType cellId, const double p[3], double w[4]) const;
+
+  /// Get IDs of simplex vertices
+  ///
+  /// \param[in] cellId ID of simplex.
+  ///
+  /// \returns Pointer to NumberOfCellPoints() vertex IDs or nullptr when the
+  ///          cell is degenerate and thus never found by this locator.
+  const vtkIdType *CellPointIds(vtkIdType cellId) const;
+
+  /// Find simplex containing a given point
+  ///
+  /// \param[in]  p Query point.
+  /// \param[out] w Barycentric coordinates, i.e., interpolation weights.
+  ///
+  /// \returns ID of simplex containing the query point or -1 if outside.
+  vtkIdType FindCell(const double p[3], double w[4]) const;
+
+protected:
+
+  /// Get barycentric coordinates of point with respect to i-th simplex in leaf node order
+  bool InsideSimplex(int i, const double p[3], double w[4]) const;
+
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Inline definitions
+////////////////////////////////////////////////////////////////////////////////
+
+// -----------------------------------------------------------------------------
+inline int SimplexLocator::NumberOfCellPoints() const
+{
+  return _Dimension + 1;
+}
+
+// -----------------------------------------------------------------------------
+inline bool SimplexLocator::InsideSimplex(int i, const double p[3], double w[4]) const
+{
+  const double eps = _Tolerance;
+  const double dx  = p[0] - _Coefficients[0][i];
+  const double dy  = p[1] - _Coefficients[1][i];
+  const double dz  = p[2] - _Coefficients[2][i];
+  w[1] = _Coefficients[ 3][i] * dx + _Coefficients[ 4][i] * dy + _Coefficients[ 5][i] * dz;
+  w[2] = _Coefficients[ 6][i] * dx + _Coefficients[ 7][i] * dy + _Coefficients[ 8][i] * dz;
+  w[3] = _Coefficients[ 9][i] * dx + _Coefficients[10][i] * dy + _Coefficients[11][i] * dz;
+  if (_Dimension == 2) {
+    w[0] = 1. - w[1] - w[2];
+    const bool inside = (w[0] >= -eps && w[1] >= -eps && w[2] >= -eps && w[3] * w[3] <= _Tolerance2);
+    w[3] = .0;
+    return inside;
+  }
+  w[0] = 1. - w[1] - w[2] - w[3];
+  return (w[0] >= -eps && w[1] >= -eps && w[2] >= -eps && w[3] >= -eps);
+}
+
+// -----------------------------------------------------------------------------
+inline bool SimplexLocator::Weights(vtkIdType cellId, const double p[3], double w[4]) const
+{
+  const int i = _CellIndex[cellId];
+  if (i < 0) return false;
+  return InsideSimplex(i, p, w);
+}
+
+// -----------------------------------------------------------------------------
+inline const vtkIdType *SimplexLocator::CellPointIds(vtkIdType cellId) const
+{
+  const int i = _CellIndex[cellId];
+  return (i < 0 ? nullptr : _PointIds.data() + 4 * i);
+}
+
+
+} // namespace mirtk
+
+#endif // MIRTK_SimplexLocator_H
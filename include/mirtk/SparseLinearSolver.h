@@ -0,0 +1,334 @@
+/*
+ * Medical Image Registration ToolKit (MIRTK)
+ *
+ * Copyright 2013-2016 Imperial College London
+ * Copyright 2013-2016 Andreas Schuh
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MIRTK_SparseLinearSolver_H
+#define MIRTK_SparseLinearSolver_H
+
+#include "mirtk/Object.h"
+#include "mirtk/LinearSolverType.h"
+#include "mirtk/AlgebraicMultigrid.h"
+
+#include "Eigen/SparseCore"
+#include "Eigen/SparseLU"
+#include "Eigen/SparseCholesky"
+#include "Eigen/OrderingMethods"
+
+
+namespace mirtk {
+
+
+/**
+ * Solver of sparse system of linear equations with runtime selectable method
+ *
+ * This class wraps the sparse direct and iterative solvers of Eigen used by
+ * the map filters. When the solver type is LinearSolver_Default, a direct
+ * solver is used when the maximum number of iterations is negative or one
+ * and an iterative solver otherwise. The Cholesky factorization LDL^T and the
+ * conjugate gradient method are used for symmetric matrices, and the LU
+ * factorization and BiCGSTAB method for non-symmetric matrices, respectively.
+ *
+ * The symbolic analysis of a direct solver is done by the first Solve call
+ * only. Subsequent calls must thus pass a system matrix with identical non-zero
+ * pattern, which allows reuse of this analysis for linear systems of different
+ * surfaces with identical mesh topology (cf. SparseSystemCache). Call Reset
+ * before solving a linear system with different non-zero pattern.
+ *
+ * When a Cholesky factorization fails because the matrix is not positive
+ * definite, the linear system is solved using the LU factorization instead.
+ *
+ * The iterative solvers use a Jacobi preconditioner by default. An incomplete
+ * Cholesky factorization of symmetric positive definite matrices or an
+ * incomplete LU factorization with threshold (ILUT) reduce the number of
+ * iterations considerably at the cost of a more expensive setup. For large
+ * symmetric positive definite systems such as mesh Laplacians, an algebraic
+ * multigrid V-cycle can be used as preconditioner of the conjugate gradient
+ * method or iterated as standalone solver. Like the symbolic analysis of the
+ * direct solvers, the multigrid aggregates are computed by the first Solve
+ * call only and reused by subsequent calls until Reset.
+ *
+ * The linear systems of the columns of a right-hand side with multiple columns,
+ * i.e., the components of a vector-valued map, are solved by the iterative
+ * solvers in parallel, where the preconditioner is computed only once and
+ * shared by all columns.
+ */
+class SparseLinearSolver : public Object
+{
+  mirtkObjectMacro(SparseLinearSolver);
+
+  // ---------------------------------------------------------------------------
+  // Types
+
+public:
+
+  /// Type of sparse system matrix
+  typedef Eigen::SparseMatrix<double> Matrix;
+
+  /// Type of right-hand side and solution matrix with one column per system
+  typedef Eigen::MatrixXd Values;
+
+  /// Sparse LU solver
+  typedef Eigen::SparseLU<Matrix, Eigen::COLAMDOrdering<int> > LUSolver;
+
+  /// Sparse Cholesky solver for symmetric matrices
+  typedef Eigen::SimplicialLDLT<Matrix, Eigen::Lower, Eigen::AMDOrdering<int> > LDLTSolver;
+
+  /// Sparse Cholesky solver for symmetric positive definite matrices
+  typedef Eigen::SimplicialLLT<Matrix, Eigen::Lower, Eigen::AMDOrdering<int> > LLTSolver;
+
+  /// Type of sparse system matrix in single precision
+  typedef Eigen::SparseMatrix<float> FloatMatrix;
+
+  /// Sparse LU solver in single precision
+  typedef Eigen::SparseLU<FloatMatrix, Eigen::COLAMDOrdering<int> > FloatLUSolver;
+
+  /// Sparse Cholesky solver for symmetric matrices in single precision
+  typedef Eigen::SimplicialLDLT<FloatMatrix, Eigen::Lower, Eigen::AMDOrdering<int> > FloatLDLTSolver;
+
+  /// Sparse Cholesky solver for symmetric positive definite matrices in single precision
+  typedef Eigen::SimplicialLLT<FloatMatrix, Eigen::Lower, Eigen::AMDOrdering<int> > FloatLLTSolver;
+
+  // ---------------------------------------------------------------------------
+  // Attributes
+
+  /// Type of linear solver
+  mirtkPublicAttributeMacro(LinearSolverType, Type);
+
+  /// Whether system matrix is symmetric
+  mirtkPublicAttributeMacro(bool, Symmetric);
+
+  /// Maximum number of iterations of iterative solver
+  ///
+  /// When the number of iterations is negative or 1 and the solver type is
+  /// LinearSolver_Default, a sparse direct solver is used. When non-positive,
+  /// the AMG solver performs at most 100 V-cycles.
+  mirtkPublicAttributeMacro(int, MaxNumberOfIterations);
+
+  /// Tolerance of iterative solver
+  ///
+  /// When non-positive, the default tolerance of the Eigen solvers is used
+  /// by CG and BiCGSTAB, and a relative residual norm of 1e-10 by AMG.
+  mirtkPublicAttributeMacro(double, Tolerance);
+
+  /// Preconditioner of iterative solver
+  mirtkPublicAttributeMacro(LinearSolverPreconditioner, Preconditioner);
+
+  /// Whether to apply fill-reducing AMD ordering before incomplete Cholesky factorization
+  ///
+  /// The ILUT preconditioner always uses an AMD ordering.
+  mirtkPublicAttributeMacro(bool, Reordering);
+
+  /// Drop tolerance of ILUT preconditioner
+  mirtkPublicAttributeMacro(double, DropTolerance);
+
+  /// Fill factor of ILUT preconditioner, i.e., maximum number of non-zero
+  /// entries per row of each incomplete factor relative to row of matrix
+  mirtkPublicAttributeMacro(int, FillFactor);
+
+  /// Whether to factorize the system matrix in single precision
+  ///
+  /// When enabled, the direct solvers factorize the system matrix in single
+  /// precision and improve the solution by iterative refinement with residuals
+  /// computed in double precision until the relative residual norm is below
+  /// the tolerance (default: 1e-10) or the maximum number of iterations
+  /// (default: 20) is reached. When the tolerance is not reached, the system
+  /// matrix is factorized in double precision instead. The incomplete
+  /// factorizations IC and ILUT of the iterative solvers are computed and
+  /// applied in single precision. Other preconditioners are unaffected.
+  mirtkPublicAttributeMacro(bool, MixedPrecision);
+
+  /// Type of linear solver used by last Solve call
+  mirtkReadOnlyAttributeMacro(LinearSolverType, UsedType);
+
+  /// Maximum number of iterations performed for any column by last Solve call
+  mirtkReadOnlyAttributeMacro(int, NumberOfIterations);
+
+  /// Maximum estimated relative error of solution columns of iterative solver
+  mirtkReadOnlyAttributeMacro(double, Error);
+
+protected:
+
+  /// Sparse LU solver
+  LUSolver _LU;
+
+  /// Sparse LDL^T Cholesky solver
+  LDLTSolver _LDLT;
+
+  /// Sparse LL^T Cholesky solver
+  LLTSolver _LLT;
+
+  /// Whether symbolic analysis of LU solver was done
+  bool _AnalyzedLU;
+
+  /// Whether symbolic analysis of LDL^T solver was done
+  bool _AnalyzedLDLT;
+
+  /// Whether symbolic analysis of LL^T solver was done
+  bool _AnalyzedLLT;
+
+  /// Sparse LU solver in single precision
+  FloatLUSolver _FloatLU;
+
+  /// Sparse LDL^T Cholesky solver in single precision
+  FloatLDLTSolver _FloatLDLT;
+
+  /// Sparse LL^T Cholesky solver in single precision
+  FloatLLTSolver _FloatLLT;
+
+  /// Whether symbolic analysis of single precision LU solver was done
+  bool _AnalyzedFloatLU;
+
+  /// Whether symbolic analysis of single precision LDL^T solver was done
+  bool _AnalyzedFloatLDLT;
+
+  /// Whether symbolic analysis of single precision LL^T solver was done
+  bool _AnalyzedFloatLLT;
+
+  /// Algebraic multigrid hierarchy
+  AlgebraicMultigrid _AMG;
+
+  /// Whether multigrid aggregates were computed
+  bool _AnalyzedAMG;
+
+  /// Copy attributes of this class from another instance
+  void CopyAttributes(const SparseLinearSolver &);
+
+  // ---------------------------------------------------------------------------
+  // Construction/Destruction
+
+public:
+
+  /// Constructor
+  SparseLinearSolver(LinearSolverType = LinearSolver_Default, bool symmetric = false);
+
+  /// Copy constructor
+  ///
+  /// Only the solver parameters are copied, not the factorization.
+  SparseLinearSolver(const SparseLinearSolver &);
+
+  /// Assignment operator
+  ///
+  /// Only the solver parameters are copied, not the factorization.
+  SparseLinearSolver &operator =(const SparseLinearSolver &);
+
+  /// Destructor
+  virtual ~SparseLinearSolver();
+
+  /// Discard symbolic analysis and factorization of previous system matrix
+  void Reset();
+
+  // ---------------------------------------------------------------------------
+  // Solver
+
+  /// Type of linear solver used for given parameters
+  LinearSolverType SolverType() const;
+
+  /// Whether a direct solver is used
+  bool IsDirect() const;
+
+  /// Whether an iterative solver is used
+  bool IsIterative() const;
+
+  /// Algebraic multigrid used by last Solve call
+  const AlgebraicMultigrid &Multigrid() const;
+
+  /// Preconditioner used by iterative solver for given parameters
+  LinearSolverPreconditioner PreconditionerType() const;
+
+  /// Solve sparse linear system
+  ///
+  /// \param[in]     A System matrix.
+  /// \param[in]     b Right-hand side with one column per linear system.
+  /// \param[in,out] x Initial guess used by iterative solver and solution.
+  ///
+  /// \returns Whether the solver succeeded.
+  bool Solve(const Matrix &A, const Values &b, Values &x);
+
+  /// Solve sparse linear system with single right-hand side
+  ///
+  /// \param[in]     A System matrix.
+  /// \param[in]     b Right-hand side.
+  /// \param[in,out] x Initial guess used by iterative solver and solution.
+  ///
+  /// \returns Whether the solver succeeded.
+  bool Solve(const Matrix &A, const Eigen::VectorXd &b, Eigen::VectorXd &x);
+
+protected:
+
+  /// Compute factorization using given direct solver
+  ///
+  /// \param[in,out] solver   Sparse direct solver.
+  /// \param[in,out] analyzed Whether symbolic analysis of solver was done.
+  /// \param[in]     A        System matrix.
+  ///
+  /// \returns Whether the factorization succeeded.
+  template <class TSolver>
+  static bool Factorize(TSolver &solver, bool &analyzed, const typename TSolver::MatrixType &A);
+
+  /// Solve linear system using direct solver in double precision
+  template <class TSolver>
+  bool SolveDirectly(TSolver &, bool &, const Matrix &, const Values &, Values &);
+
+  /// Solve linear system using direct solver in single precision and iterative refinement
+  ///
+  /// \returns Whether the relative residual norm is below the tolerance.
+  template <class TSolver>
+  bool SolveByRefinement(TSolver &, bool &, const Matrix &, const Values &, Values &);
+
+  /// Solve linear system using direct solver in single precision and iterative
+  /// refinement, or in double precision when the refinement does not converge
+  template <class TFloatSolver, class TSolver>
+  bool SolveMixedPrecision(TFloatSolver &, bool &, TSolver &, bool &, const Matrix &, const Values &, Values &);
+
+  /// Compute algebraic multigrid hierarchy
+  ///
+  /// \returns Whether the system of the coarsest level could be factorized.
+  bool SetupAMG(const Matrix &);
+
+  /// Solve linear system using given iterative solver
+  template <class TSolver>
+  bool SolveIteratively(TSolver &, const Matrix &, const Values &, Values &);
+
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Inline definitions
+////////////////////////////////////////////////////////////////////////////////
+
+// -----------------------------------------------------------------------------
+inline bool SparseLinearSolver::IsDirect() const
+{
+  return IsDirectLinearSolver(SolverType());
+}
+
+// -----------------------------------------------------------------------------
+inline bool SparseLinearSolver::IsIterative() const
+{
+  return IsIterativeLinearSolver(SolverType());
+}
+
+// -----------------------------------------------------------------------------
+inline const AlgebraicMultigrid &SparseLinearSolver::Multigrid() const
+{
+  return _AMG;
+}
+
+
+} // namespace mirtk
+
+#endif // MIRTK_SparseLinearSolver_H
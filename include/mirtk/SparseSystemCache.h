@@ -0,0 +1,134 @@
+/*
+ * Medical Image Registration ToolKit (MIRTK)
+ *
+ * Copyright 2013-2016 Imperial College London
+ * Copyright 2013-2016 Andreas Schuh
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MIRTK_SparseSystemCache_H
+#define MIRTK_SparseSystemCache_H
+
+#include "mirtk/Array.h"
+#include "mirtk/Memory.h"
+#include "mirtk/SparseLinearSolver.h"
+
+#include <mutex>
+
+
+namespace mirtk {
+
+
+/**
+ * Process-wide cache of sparse linear system patterns and symbolic factorizations
+ *
+ * The linear systems of surface maps computed for meshes with identical
+ * connectivity and identical set of points with fixed map value have the same
+ * non-zero pattern. When such maps are computed one after another, e.g., for
+ * a set of surfaces resampled from a common template mesh, the pattern and
+ * the symbolic analysis of the sparse direct solver are reused. Entries are
+ * identified by a stamp of the mesh topology computed by the client in
+ * constant time, e.g., from the identity of the mesh connectivity arrays.
+ * Because distinct topologies may have the same stamp, an entry is only
+ * returned when also the matrix size, the number of non-zero entries, and the
+ * indices of the points with free map value match. Otherwise, the entry is
+ * replaced by a new empty entry for which the client computes the non-zero
+ * pattern anew.
+ *
+ * The cache keeps only the MaximumSize most recently used entries (two by
+ * default), such that at most this many symbolic factorizations are kept
+ * alive after the surface maps which computed them were destroyed. Each entry
+ * has its own mutex, which a client must hold while it uses the entry.
+ */
+class SparseSystemCache
+{
+public:
+
+  /// Cached data of linear systems with identical non-zero pattern
+  struct Entry
+  {
+    const size_t       Key;              ///< Stamp of mesh topology
+    const int          NumberOfRows;     ///< Number of rows/columns of system matrix
+    const int          NumberOfNonZeros; ///< Number of non-zero entries of system matrix
+    const Array<int>   PointIndex;       ///< Index of each point in set of free or fixed points
+    Array<int>         Offsets;          ///< Index of first non-zero entry of each column
+    Array<int>         Indices;          ///< Row indices of non-zero entries
+    SparseLinearSolver Solver;           ///< Sparse solver with reusable symbolic analysis
+    std::mutex         Mutex;            ///< Mutex held by client while using this entry
+
+    Entry(size_t key, int n, int nnz, const Array<int> &index)
+    :
+      Key(key), NumberOfRows(n), NumberOfNonZeros(nnz), PointIndex(index)
+    {}
+
+    /// Whether this entry belongs to the linear system with given properties
+    bool Matches(size_t key, int n, int nnz, const Array<int> &index) const
+    {
+      return Key == key && NumberOfRows == n && NumberOfNonZeros == nnz && PointIndex == index;
+    }
+  };
+
+  /// Get cache entry for a given linear system
+  ///
+  /// \param[in] key   Stamp of mesh topology.
+  /// \param[in] n     Number of rows/columns of system matrix.
+  /// \param[in] nnz   Number of non-zero entries of system matrix.
+  /// \param[in] index Index of each point in set of free or fixed points.
+  ///
+  /// \returns Cache entry, which is empty when no matching entry was found.
+  static SharedPtr<Entry> Get(size_t key, int n, int nnz, const Array<int> &index);
+
+  /// Remove all cache entries
+  static void Clear();
+
+  /// Set maximum number of cache entries, where zero disables the cache
+  static void MaximumSize(int);
+
+  /// Get maximum number of cache entries
+  static int MaximumSize();
+
+  /// Compute hash of an array of integral values
+  ///
+  /// \param[in] data Values.
+  /// \param[in] n    Number of values.
+  /// \param[in] seed Hash of preceding values.
+  ///
+  /// \returns Hash value.
+  template <class T>
+  static size_t Hash(const T *data, size_t n, size_t seed = 0);
+
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Inline definitions
+////////////////////////////////////////////////////////////////////////////////
+
+// -----------------------------------------------------------------------------
+template <class T>
+inline size_t SparseSystemCache::Hash(const T *data, size_t n, size_t seed)
+{
+  // 64-bit FNV-1a hash of the value bytes
+  unsigned long long h = (seed != 0 ? static_cast<unsigned long long>(seed) : 14695981039346656037ULL);
+  const unsigned char *bytes = reinterpret_cast<const unsigned char *>(data);
+  for (size_t i = 0; i < n * sizeof(T); ++i) {
+    h ^= bytes[i];
+    h *= 1099511628211ULL;
+  }
+  return static_cast<size_t>(h);
+}
+
+
+} // namespace mirtk
+
+#endif // MIRTK_SparseSystemCache_H
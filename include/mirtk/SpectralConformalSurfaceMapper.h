@@ -107,13 +107,10 @@ public:
 
 protected:
 
-  /// Weight of undirected edge (i, j)
+  /// Compute cotangent weights of undirected edges
   ///
-  /// \param[in] i First end point.
-  /// \param[in] j Second end point.
-  ///
-  /// \returns Weight of undirected edge (i, j).
-  virtual double Weight(int i, int j) const;
+  /// \param[out] w Weights indexed by edge ID of edge table.
+  virtual void ComputeWeights(Array<double> &w) const;
 
   /// Initialize filter after input and parameters are set
   virtual void Initialize();
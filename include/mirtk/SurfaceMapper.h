@@ -23,11 +23,13 @@
 #include "mirtk/Object.h"
 
 #include "mirtk/Memory.h"
+#include "mirtk/Array.h"
 #include "mirtk/Point.h"
 
 #include "mirtk/EdgeTable.h"
 #include "mirtk/SurfaceBoundary.h"
 #include "mirtk/Mapping.h"
+#include "mirtk/MeshReordering.h"
 
 #include "vtkSmartPointer.h"
 #include "vtkPolyData.h"
@@ -62,6 +64,35 @@ class SurfaceMapper : public Object
   /// Extracted surface mesh boundary
   mirtkPublicAttributeMacro(SharedPtr<SurfaceBoundary>, Boundary);
 
+  /// Order of surface points and cells used for the map computation
+  ///
+  /// When not MeshOrdering_None, the points and cells of the input surface
+  /// are renumbered by Initialize to improve the locality of memory accesses.
+  /// The attributes Surface, EdgeTable, and Boundary then refer to the
+  /// reordered surface until Finalize restores the input attributes and the
+  /// input point order of the output map values. The renumbering is then
+  /// discarded such that point and cell IDs are no longer translated.
+  mirtkPublicAttributeMacro(MeshOrdering, Ordering);
+
+  /// Renumbering of input surface points and cells, or nullptr
+  mirtkAttributeMacro(SharedPtr<MeshReordering>, Reordering);
+
+  /// Input surface while Surface refers to the reordered surface
+  mirtkAttributeMacro(vtkSmartPointer<vtkPolyData>, InputSurface);
+
+  /// Edge table of input surface set by user while surface is reordered
+  mirtkAttributeMacro(SharedPtr<mirtk::EdgeTable>, InputEdgeTable);
+
+  /// Boundary of input surface set by user while surface is reordered
+  mirtkAttributeMacro(SharedPtr<SurfaceBoundary>, InputBoundary);
+
+  /// Cells adjacent to each edge of the surface mesh
+  ///
+  /// For the edge with ID e, the entry at index 3 * e is the number of cells
+  /// which contain both edge points, and the following two entries are the
+  /// IDs of the other points of the first two adjacent triangles or -1.
+  mirtkAttributeMacro(Array<int>, EdgeNeighborPoints);
+
   /// Output surface map
   ///
   /// \note The output map is uninitialized! Mapping::Initialize must be
@@ -101,6 +132,12 @@ protected:
   /// Initialize filter after input and parameters are set
   virtual void Initialize();
 
+  /// Renumber points and cells of input surface
+  void InitializeOrdering();
+
+  /// Determine number of cells adjacent to each edge and their other points
+  void InitializeEdgeNeighborPoints();
+
   /// Compute surface map
   virtual void ComputeMap() = 0;
 
@@ -144,6 +181,36 @@ protected:
   ///          mesh is triangulated, the return value is 1 for a boundary edge,
   ///          and 2 for an interior edge.
   int GetEdgeNeighborPoints(int i, int j, int &k, int &l) const;
+
+  /// Check that each edge is adjacent to one or two triangles
+  ///
+  /// Prints an error message and exits the program otherwise. Must be called
+  /// by functions which compute the edge weights of all edges at once.
+  ///
+  /// \param[in] func Name of calling function used in error message.
+  void CheckTriangulated(const char *func) const;
+
+  /// Get ID of reordered surface point given ID of input surface point
+  int ReorderedPointId(int ptId) const;
+
+  /// Get ID of input surface point given ID of reordered surface point
+  int OriginalPointId(int ptId) const;
+
+  /// Convert IDs of reordered surface points to IDs of input surface points
+  ///
+  /// \param[in,out] ids Point IDs.
+  void OriginalPointIds(Array<int> &ids) const;
+
+  /// Reorder values given for each point of reordered surface to input point order
+  ///
+  /// \param[in,out] values Value of each surface point.
+  void RestorePointOrder(Array<int> &values) const;
+
+  /// Get ID of reordered surface cell given ID of input surface cell
+  int ReorderedCellId(int cellId) const;
+
+  /// Get ID of input surface cell given ID of reordered surface cell
+  int OriginalCellId(int cellId) const;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -180,6 +247,30 @@ inline Point SurfaceMapper::Point(int ptId) const
   return p;
 }
 
+// -----------------------------------------------------------------------------
+inline int SurfaceMapper::ReorderedPointId(int ptId) const
+{
+  return (_Reordering ? _Reordering->ReorderedPointId(ptId) : ptId);
+}
+
+// -----------------------------------------------------------------------------
+inline int SurfaceMapper::OriginalPointId(int ptId) const
+{
+  return (_Reordering ? _Reordering->OriginalPointId(ptId) : ptId);
+}
+
+// -----------------------------------------------------------------------------
+inline int SurfaceMapper::ReorderedCellId(int cellId) const
+{
+  return (_Reordering ? _Reordering->ReorderedCellId(cellId) : cellId);
+}
+
+// -----------------------------------------------------------------------------
+inline int SurfaceMapper::OriginalCellId(int cellId) const
+{
+  return (_Reordering ? _Reordering->OriginalCellId(cellId) : cellId);
+}
+
 
 } // namespace mirtk
 
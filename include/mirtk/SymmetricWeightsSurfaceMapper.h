@@ -39,6 +39,12 @@ class SymmetricWeightsSurfaceMapper : public LinearFixedBoundarySurfaceMapper
   /// Copy attributes of this class from another instance
   void CopyAttributes(const SymmetricWeightsSurfaceMapper &);
 
+  // Auxiliary functors used to assemble linear system in parallel
+  struct ComputeEdgeWeights;
+  struct EdgeWeightArray;
+  struct UnitEdgeWeight;
+  template <class TEdgeWeight> struct AssembleLinearSystem;
+
   // ---------------------------------------------------------------------------
   // Construction/Destruction
 
@@ -74,6 +80,22 @@ protected:
   /// \returns Weight of undirected edge (i, j).
   virtual double Weight(int i, int j) const = 0;
 
+  /// Whether all edge weights are equal to one
+  ///
+  /// When true, the system matrix is the graph Laplacian of the edge table.
+  /// Its coefficients are then set directly from the point adjacencies and
+  /// neither ComputeWeights nor Weight is called.
+  virtual bool UniformWeights() const;
+
+  /// Compute weights of all edges with at least one free end point
+  ///
+  /// \param[out] w Weight of each edge of the edge table.
+  ///
+  /// \note The default implementation calls the Weight function for each edge
+  ///       in parallel. Subclasses can override this function to compute the
+  ///       weights of all edges more efficiently at once.
+  virtual void ComputeWeights(Array<double> &w) const;
+
 };
 
 
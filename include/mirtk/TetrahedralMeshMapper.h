@@ -21,6 +21,7 @@
 #define MIRTK_TetrahedralMeshMapper_H
 
 #include "mirtk/VolumeMapper.h"
+#include "mirtk/MeshReordering.h"
 
 #include "vtkSmartPointer.h"
 #include "vtkPointSet.h"
@@ -48,6 +49,16 @@ protected:
   /// Boolean array indicating which points are on the boundary, i.e., fixed
   mirtkPublicAttributeMacro(vtkSmartPointer<vtkDataArray>, InputMask);
 
+  /// Order of volume mesh points and cells used for the map computation
+  ///
+  /// When not MeshOrdering_None, the points and cells of the tetrahedral mesh
+  /// are renumbered by Initialize to improve the locality of memory accesses.
+  /// Finalize restores the point order of the tetrahedralized input domain.
+  mirtkPublicAttributeMacro(MeshOrdering, Ordering);
+
+  /// Renumbering of volume mesh points and cells, or nullptr
+  mirtkAttributeMacro(SharedPtr<MeshReordering>, Reordering);
+
   /// Discretized input domain, i.e., tetrahedral mesh
   mirtkReadOnlyAttributeMacro(vtkSmartPointer<vtkPointSet>, Volume);
 
@@ -0,0 +1,204 @@
+/*
+ * Medical Image Registration ToolKit (MIRTK)
+ *
+ * Copyright 2013-2016 Imperial College London
+ * Copyright 2013-2016 Andreas Schuh
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MIRTK_TriangleMeshGeometry_H
+#define MIRTK_TriangleMeshGeometry_H
+
+#include "mirtk/Object.h"
+
+#include "mirtk/Array.h"
+#include "mirtk/Memory.h"
+#include "mirtk/EdgeTable.h"
+
+#include "vtkSmartPointer.h"
+#include "vtkPolyData.h"
+
+
+namespace mirtk {
+
+
+/**
+ * Geometric quantities of the triangles and edges of a surface mesh
+ *
+ * This filter copies the point coordinates of a triangulated surface mesh once
+ * into contiguous arrays of x, y, and z coordinates, respectively, and computes
+ * the cotangent and the tangent of half the angle at each triangle corner, the
+ * double area of each triangle, and the length of each edge. The triangles are
+ * processed in parallel in small batches, where the corner coordinates of each
+ * batch are first gathered into local arrays such that the arithmetic is done
+ * by simple loops over contiguous memory which the compiler can vectorize.
+ *
+ * The per-edge weights of the linear surface mappers can thus be computed from
+ * these precomputed quantities instead of fetching the points of each edge one
+ * at a time from the vtkPoints and recomputing the geometry of each triangle
+ * once for every adjacent edge.
+ *
+ * Vertices and lines of the surface mesh are ignored. All other cells must be
+ * triangles unless only the edge geometry is requested.
+ */
+class TriangleMeshGeometry : public Object
+{
+  mirtkObjectMacro(TriangleMeshGeometry);
+
+  // ---------------------------------------------------------------------------
+  // Attributes
+
+  /// Triangulated surface mesh
+  mirtkPublicAttributeMacro(vtkSmartPointer<vtkPolyData>, Surface);
+
+  /// Pre-computed edge table of surface mesh
+  mirtkPublicAttributeMacro(SharedPtr<mirtk::EdgeTable>, EdgeTable);
+
+  /// Whether to compute the geometry of the triangles
+  ///
+  /// When false, only the point coordinates and edge lengths are computed
+  /// and the surface mesh may contain polygons with more than three points.
+  mirtkPublicAttributeMacro(bool, TriangleGeometry);
+
+  /// x coordinates of surface points
+  mirtkReadOnlyAttributeMacro(Array<double>, X);
+
+  /// y coordinates of surface points
+  mirtkReadOnlyAttributeMacro(Array<double>, Y);
+
+  /// z coordinates of surface points
+  mirtkReadOnlyAttributeMacro(Array<double>, Z);
+
+  /// Point IDs of each triangle
+  mirtkReadOnlyAttributeMacro(Array<int>, Triangles);
+
+  /// ID of the edge opposite to each corner of each triangle
+  mirtkReadOnlyAttributeMacro(Array<int>, TriangleEdges);
+
+  /// IDs of the end points of each edge, where the first ID is the smaller
+  mirtkReadOnlyAttributeMacro(Array<int>, Edges);
+
+  /// Cotangent of the angle at each corner of each triangle
+  mirtkReadOnlyAttributeMacro(Array<double>, Cotangents);
+
+  /// Tangent of half the angle at each corner of each triangle
+  mirtkReadOnlyAttributeMacro(Array<double>, HalfAngleTangents);
+
+  /// Twice the area of each triangle
+  mirtkReadOnlyAttributeMacro(Array<double>, DoubleAreas);
+
+  /// Length of each edge
+  mirtkReadOnlyAttributeMacro(Array<double>, EdgeLengths);
+
+  /// Copy attributes of this class from another instance
+  void CopyAttributes(const TriangleMeshGeometry &);
+
+  // ---------------------------------------------------------------------------
+  // Construction/Destruction
+
+public:
+
+  /// Constructor
+  TriangleMeshGeometry(vtkPolyData * = nullptr, SharedPtr<mirtk::EdgeTable> = nullptr);
+
+  /// Copy constructor
+  TriangleMeshGeometry(const TriangleMeshGeometry &);
+
+  /// Assignment operator
+  TriangleMeshGeometry &operator =(const TriangleMeshGeometry &);
+
+  /// Destructor
+  virtual ~TriangleMeshGeometry();
+
+  // ---------------------------------------------------------------------------
+  // Execution
+
+  /// Get triangles and edges of surface mesh and compute their geometry
+  void Run();
+
+  /// Recompute geometry of triangles and edges after the points have moved
+  void Update();
+
+  // ---------------------------------------------------------------------------
+  // Geometry
+
+  /// Number of surface points
+  int NumberOfPoints() const;
+
+  /// Number of triangles
+  int NumberOfTriangles() const;
+
+  /// Number of edges
+  int NumberOfEdges() const;
+
+  /// Get point coordinates
+  void GetPoint(int ptId, double p[3]) const;
+
+  /// Squared distance of two points
+  double Distance2(int i, int j) const;
+
+  /// Sum values of triangle corners at the end points of each adjacent edge
+  ///
+  /// \param[in]  v Value of each corner of each triangle, e.g., Cotangents.
+  /// \param[out] s Sum of values at each end point of each edge, where
+  ///               s[2 * e + k] is the sum of the values of the corners at
+  ///               end point Edges[2 * e + k] of the triangles adjacent to
+  ///               edge e.
+  void GetEdgeEndSums(const Array<double> &v, Array<double> &s) const;
+
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Inline definitions
+////////////////////////////////////////////////////////////////////////////////
+
+// -----------------------------------------------------------------------------
+inline int TriangleMeshGeometry::NumberOfPoints() const
+{
+  return static_cast<int>(_X.size());
+}
+
+// -----------------------------------------------------------------------------
+inline int TriangleMeshGeometry::NumberOfTriangles() const
+{
+  return static_cast<int>(_Triangles.size() / 3);
+}
+
+// -----------------------------------------------------------------------------
+inline int TriangleMeshGeometry::NumberOfEdges() const
+{
+  return static_cast<int>(_Edges.size() / 2);
+}
+
+// -----------------------------------------------------------------------------
+inline void TriangleMeshGeometry::GetPoint(int ptId, double p[3]) const
+{
+  p[0] = _X[ptId];
+  p[1] = _Y[ptId];
+  p[2] = _Z[ptId];
+}
+
+// -----------------------------------------------------------------------------
+inline double TriangleMeshGeometry::Distance2(int i, int j) const
+{
+  const double dx = _X[j] - _X[i];
+  const double dy = _Y[j] - _Y[i];
+  const double dz = _Z[j] - _Z[i];
+  return dx * dx + dy * dy + dz * dz;
+}
+
+
+} // namespace mirtk
+
+#endif // MIRTK_TriangleMeshGeometry_H
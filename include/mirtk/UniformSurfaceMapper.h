@@ -61,6 +61,9 @@ public:
   /// Destructor
   virtual ~UniformSurfaceMapper();
 
+  /// Create new copy of this instance
+  virtual LinearFixedBoundarySurfaceMapper *NewCopy() const;
+
   // ---------------------------------------------------------------------------
   // Execution
 
@@ -74,6 +77,9 @@ protected:
   /// \returns Weight of undirected edge (i, j).
   virtual double Weight(int i, int j) const;
 
+  /// Whether all edge weights are equal to one, i.e., always true
+  virtual bool UniformWeights() const;
+
 };
 
 
@@ -0,0 +1,373 @@
+/*
+ * Medical Image Registration ToolKit (MIRTK)
+ *
+ * Copyright 2013-2016 Imperial College London
+ * Copyright 2013-2016 Andreas Schuh
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mirtk/AlgebraicMultigrid.h"
+
+#include "mirtk/Math.h"
+
+
+namespace mirtk {
+
+
+// =============================================================================
+// Auxiliaries
+// =============================================================================
+
+namespace AlgebraicMultigridUtils {
+
+
+/// Number of power iterations used to estimate spectral radius of D^-1 A
+const int _NumberOfPowerIterations = 20;
+
+/// Maximum size of coarsest level system solved by dense LU factorization
+const int _MaxDenseCoarseSize = 2000;
+
+
+} // namespace AlgebraicMultigridUtils
+using namespace AlgebraicMultigridUtils;
+
+// =============================================================================
+// Construction/destruction
+// =============================================================================
+
+// -----------------------------------------------------------------------------
+void AlgebraicMultigrid::CopyAttributes(const AlgebraicMultigrid &other)
+{
+  _StrengthThreshold          = other._StrengthThreshold;
+  _MaxNumberOfLevels          = other._MaxNumberOfLevels;
+  _CoarseSize                 = other._CoarseSize;
+  _NumberOfPreSmoothingSteps  = other._NumberOfPreSmoothingSteps;
+  _NumberOfPostSmoothingSteps = other._NumberOfPostSmoothingSteps;
+  _Levels.clear();
+  _Aggregates.clear();
+  _NumberOfAggregates.clear();
+  _DenseCoarseSolve = false;
+}
+
+// -----------------------------------------------------------------------------
+AlgebraicMultigrid::AlgebraicMultigrid()
+:
+  _StrengthThreshold(.08),
+  _MaxNumberOfLevels(10),
+  _CoarseSize(500),
+  _NumberOfPreSmoothingSteps(1),
+  _NumberOfPostSmoothingSteps(1),
+  _DenseCoarseSolve(false)
+{
+}
+
+// -----------------------------------------------------------------------------
+AlgebraicMultigrid::AlgebraicMultigrid(const AlgebraicMultigrid &other)
+:
+  Object(other)
+{
+  CopyAttributes(other);
+}
+
+// -----------------------------------------------------------------------------
+AlgebraicMultigrid &AlgebraicMultigrid::operator =(const AlgebraicMultigrid &other)
+{
+  if (this != &other) {
+    Object::operator =(other);
+    CopyAttributes(other);
+  }
+  return *this;
+}
+
+// -----------------------------------------------------------------------------
+AlgebraicMultigrid::~AlgebraicMultigrid()
+{
+}
+
+// =============================================================================
+// Setup
+// =============================================================================
+
+// -----------------------------------------------------------------------------
+int AlgebraicMultigrid::Aggregate(const Matrix &A, Array<int> &agg) const
+{
+  const int n = static_cast<int>(A.rows());
+  const Vector d = A.diagonal().cwiseAbs();
+
+  // Strongly connected neighbors of each unknown, where the column of the
+  // symmetric matrix is identical to the row of the respective unknown
+  Array<int>    offsets(n + 1);
+  Array<int>    strong;
+  Array<double> weight;
+  strong.reserve(A.nonZeros());
+  weight.reserve(A.nonZeros());
+  for (int j = 0; j < n; ++j) {
+    offsets[j] = static_cast<int>(strong.size());
+    for (Matrix::InnerIterator it(A, j); it; ++it) {
+      const int    i = static_cast<int>(it.row());
+      const double w = abs(it.value());
+      if (i != j && w > _StrengthThreshold * sqrt(d(i) * d(j))) {
+        strong.push_back(i);
+        weight.push_back(w);
+      }
+    }
+  }
+  offsets[n] = static_cast<int>(strong.size());
+
+  agg.resize(n);
+  for (int i = 0; i < n; ++i) agg[i] = -1;
+  int nagg = 0;
+
+  // 1. Form aggregates of unknowns whose strong neighbors are all unaggregated
+  for (int i = 0; i < n; ++i) {
+    if (agg[i] >= 0) continue;
+    bool is_root = true;
+    for (int k = offsets[i]; k < offsets[i+1]; ++k) {
+      if (agg[strong[k]] >= 0) {
+        is_root = false;
+        break;
+      }
+    }
+    if (is_root) {
+      agg[i] = nagg;
+      for (int k = offsets[i]; k < offsets[i+1]; ++k) {
+        agg[strong[k]] = nagg;
+      }
+      ++nagg;
+    }
+  }
+
+  // 2. Add remaining unknowns to aggregate of most strongly connected neighbor
+  const Array<int> root_agg(agg);
+  for (int i = 0; i < n; ++i) {
+    if (agg[i] >= 0) continue;
+    double wmax = .0;
+    for (int k = offsets[i]; k < offsets[i+1]; ++k) {
+      if (root_agg[strong[k]] >= 0 && weight[k] > wmax) {
+        agg[i] = root_agg[strong[k]];
+        wmax   = weight[k];
+      }
+    }
+  }
+
+  // 3. Form aggregates of remaining unknowns and their unaggregated neighbors
+  for (int i = 0; i < n; ++i) {
+    if (agg[i] >= 0) continue;
+    agg[i] = nagg;
+    for (int k = offsets[i]; k < offsets[i+1]; ++k) {
+      if (agg[strong[k]] < 0) agg[strong[k]] = nagg;
+    }
+    ++nagg;
+  }
+
+  return nagg;
+}
+
+// -----------------------------------------------------------------------------
+double AlgebraicMultigrid::InitializeSmoother(Level &level) const
+{
+  const Matrix &A = level.A;
+  const int     n = static_cast<int>(A.rows());
+
+  Vector dinv(n);
+  for (int i = 0; i < n; ++i) {
+    const double a_ii = A.coeff(i, i);
+    dinv(i) = (a_ii != .0 ? 1. / a_ii : .0);
+  }
+
+  // Estimate spectral radius of D^-1 A using power iteration with
+  // deterministic pseudo-random start vector
+  Vector v(n), w;
+  for (int i = 0; i < n; ++i) {
+    v(i) = static_cast<double>((i * 7919 + 13) % 104729) / 104729. - .5;
+  }
+  double rho = .0, norm;
+  for (int k = 0; k < _NumberOfPowerIterations; ++k) {
+    norm = v.norm();
+    if (norm == .0) break;
+    v /= norm;
+    w = dinv.cwiseProduct(A * v);
+    rho = w.norm();
+    v.swap(w);
+  }
+
+  const double omega = (rho > .0 ? 4. / (3. * rho) : 1.);
+  level.InvDiag = omega * dinv;
+  return omega;
+}
+
+// -----------------------------------------------------------------------------
+void AlgebraicMultigrid::InitializeCoarseLevel(int l)
+{
+  const Array<int> &agg  = _Aggregates[l];
+  const int         nagg = _NumberOfAggregates[l];
+  const int         n    = static_cast<int>(agg.size());
+
+  // Tentative prolongator with normalized piecewise constant columns
+  Array<int> size(nagg, 0);
+  for (int i = 0; i < n; ++i) ++size[agg[i]];
+  Array<Eigen::Triplet<double> > entries;
+  entries.reserve(n);
+  for (int i = 0; i < n; ++i) {
+    entries.push_back(Eigen::Triplet<double>(i, agg[i], 1. / sqrt(static_cast<double>(size[agg[i]]))));
+  }
+  Matrix T(n, nagg);
+  T.setFromTriplets(entries.begin(), entries.end());
+
+  // Smoothed prolongator P = (I - omega D^-1 A) T
+  Level &level = _Levels[l];
+  InitializeSmoother(level);
+  const Matrix AT = level.A * T;
+  level.P = T - level.InvDiag.asDiagonal() * AT;
+  level.R = level.P.transpose();
+
+  // Galerkin product of coarse level
+  Level coarse;
+  coarse.A = level.R * (level.A * level.P);
+  coarse.A.makeCompressed();
+  _Levels.push_back(coarse);
+}
+
+// -----------------------------------------------------------------------------
+bool AlgebraicMultigrid::InitializeCoarseSolver(bool analyze)
+{
+  const Matrix &A = _Levels.back().A;
+  if (analyze) _CoarseSolver.compute(A);
+  else         _CoarseSolver.factorize(A);
+  _DenseCoarseSolve = (_CoarseSolver.info() != Eigen::Success);
+  if (_DenseCoarseSolve) {
+    if (A.rows() > _MaxDenseCoarseSize) return false;
+    _DenseCoarseSolver.compute(Eigen::MatrixXd(A));
+  }
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+bool AlgebraicMultigrid::Setup(const Matrix &A)
+{
+  _Levels.clear();
+  _Aggregates.clear();
+  _NumberOfAggregates.clear();
+
+  _Levels.resize(1);
+  _Levels[0].A = A;
+  _Levels[0].A.makeCompressed();
+
+  Array<int> agg;
+  while (NumberOfLevels() < _MaxNumberOfLevels && _Levels.back().A.rows() > _CoarseSize) {
+    const int n    = static_cast<int>(_Levels.back().A.rows());
+    const int nagg = Aggregate(_Levels.back().A, agg);
+    if (nagg == 0 || nagg == n) break;
+    _Aggregates.push_back(agg);
+    _NumberOfAggregates.push_back(nagg);
+    InitializeCoarseLevel(NumberOfLevels() - 1);
+  }
+
+  return InitializeCoarseSolver(true);
+}
+
+// -----------------------------------------------------------------------------
+bool AlgebraicMultigrid::Update(const Matrix &A)
+{
+  if (_Aggregates.empty() || _Levels.empty() || _Levels[0].A.rows() != A.rows()) {
+    return Setup(A);
+  }
+
+  _Levels.resize(1);
+  _Levels[0].A = A;
+  _Levels[0].A.makeCompressed();
+  for (size_t l = 0; l < _Aggregates.size(); ++l) {
+    InitializeCoarseLevel(static_cast<int>(l));
+  }
+
+  return InitializeCoarseSolver(false);
+}
+
+// -----------------------------------------------------------------------------
+double AlgebraicMultigrid::OperatorComplexity() const
+{
+  if (_Levels.empty() || _Levels[0].A.nonZeros() == 0) return .0;
+  double nnz = .0;
+  for (size_t l = 0; l < _Levels.size(); ++l) {
+    nnz += static_cast<double>(_Levels[l].A.nonZeros());
+  }
+  return nnz / static_cast<double>(_Levels[0].A.nonZeros());
+}
+
+// =============================================================================
+// Solver
+// =============================================================================
+
+// -----------------------------------------------------------------------------
+void AlgebraicMultigrid::VCycle(int l, const Vector &b, Vector &x) const
+{
+  const Level &level = _Levels[l];
+
+  // Solve coarsest level system directly
+  if (l == NumberOfLevels() - 1) {
+    if (_DenseCoarseSolve) x = _DenseCoarseSolver.solve(b);
+    else                   x = _CoarseSolver.solve(b);
+    return;
+  }
+
+  // Pre-smoothing
+  for (int k = 0; k < _NumberOfPreSmoothingSteps; ++k) {
+    x += level.InvDiag.cwiseProduct(b - level.A * x);
+  }
+
+  // Coarse grid correction
+  const Vector r = b - level.A * x;
+  Vector xc = Vector::Zero(level.R.rows());
+  VCycle(l + 1, level.R * r, xc);
+  x += level.P * xc;
+
+  // Post-smoothing
+  for (int k = 0; k < _NumberOfPostSmoothingSteps; ++k) {
+    x += level.InvDiag.cwiseProduct(b - level.A * x);
+  }
+}
+
+// -----------------------------------------------------------------------------
+AlgebraicMultigrid::Vector AlgebraicMultigrid::Apply(const Vector &b) const
+{
+  Vector x = Vector::Zero(b.size());
+  VCycle(0, b, x);
+  return x;
+}
+
+// -----------------------------------------------------------------------------
+int AlgebraicMultigrid::Solve(const Vector &b, Vector &x, int maxiter, double tol, double *error) const
+{
+  const Matrix &A = _Levels[0].A;
+
+  const double bnorm = b.norm();
+  if (bnorm == .0) {
+    x.setZero();
+    if (error) *error = .0;
+    return 0;
+  }
+
+  int    iter = 0;
+  double res  = (b - A * x).norm() / bnorm;
+  while (iter < maxiter && res > tol) {
+    VCycle(0, b, x);
+    res = (b - A * x).norm() / bnorm;
+    ++iter;
+  }
+  if (error) *error = res;
+  return iter;
+}
+
+
+} // namespace mirtk
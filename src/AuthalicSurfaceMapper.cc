@@ -20,6 +20,7 @@
 #include "mirtk/AuthalicSurfaceMapper.h"
 
 #include "mirtk/Triangle.h"
+#include "mirtk/EdgeTable.h"
 
 
 namespace mirtk {
@@ -62,14 +63,57 @@ AuthalicSurfaceMapper::~AuthalicSurfaceMapper()
 {
 }
 
+// -----------------------------------------------------------------------------
+LinearFixedBoundarySurfaceMapper *AuthalicSurfaceMapper::NewCopy() const
+{
+  return new AuthalicSurfaceMapper(*this);
+}
+
 // =============================================================================
 // Execution
 // =============================================================================
 
+// -----------------------------------------------------------------------------
+void AuthalicSurfaceMapper::EdgeWeights(const double a[3], const double b[3],
+                                        const double c[3], const double *d, double w[2])
+{
+  // Sum of cotangents of the angles at the end point of the directed edge
+  // divided by the squared edge length
+  w[0] = Triangle::Cotangent(a, b, c);
+  w[1] = Triangle::Cotangent(b, a, c);
+  if (d) {
+    w[0] += Triangle::Cotangent(a, b, d);
+    w[1] += Triangle::Cotangent(b, a, d);
+  }
+  const double l2 = vtkMath::Distance2BetweenPoints(a, b);
+  w[0] /= l2;
+  w[1] /= l2;
+}
+
+// -----------------------------------------------------------------------------
+void AuthalicSurfaceMapper::ComputeWeights(Array<double> &w) const
+{
+  CheckTriangulated("ComputeWeights");
+
+  double a[3], b[3], c[3], d[3];
+  int    i, j, edgeId;
+
+  w.resize(2 * _EdgeTable->NumberOfEdges());
+  EdgeIterator edgeIt(*_EdgeTable);
+  for (edgeIt.InitTraversal(); (edgeId = edgeIt.GetNextEdge(i, j)) != -1;) {
+    const int * const entry = _EdgeNeighborPoints.data() + 3 * edgeId;
+    _Surface->GetPoint(static_cast<vtkIdType>(min(i, j)), a);
+    _Surface->GetPoint(static_cast<vtkIdType>(max(i, j)), b);
+    _Surface->GetPoint(static_cast<vtkIdType>(entry[1]), c);
+    if (entry[2] >= 0) _Surface->GetPoint(static_cast<vtkIdType>(entry[2]), d);
+    EdgeWeights(a, b, c, entry[2] >= 0 ? d : nullptr, w.data() + 2 * edgeId);
+  }
+}
+
 // -----------------------------------------------------------------------------
 double AuthalicSurfaceMapper::Weight(int i, int j) const
 {
-  double a[3], b[3], c[3], w;
+  double a[3], b[3], c[3], d[3], w[2];
 
   int k, l;
   if (GetEdgeNeighborPoints(i, j, k, l) > 2 || k < 0) {
@@ -80,14 +124,10 @@ double AuthalicSurfaceMapper::Weight(int i, int j) const
   _Surface->GetPoint(static_cast<vtkIdType>(i), a);
   _Surface->GetPoint(static_cast<vtkIdType>(j), b);
   _Surface->GetPoint(static_cast<vtkIdType>(k), c);
-  w = Triangle::Cotangent(a, b, c);
-  if (l >= 0) {
-    _Surface->GetPoint(static_cast<vtkIdType>(l), c);
-    w += Triangle::Cotangent(a, b, c);
-  }
+  if (l >= 0) _Surface->GetPoint(static_cast<vtkIdType>(l), d);
+  EdgeWeights(a, b, c, l >= 0 ? d : nullptr, w);
 
-  return w / vtkMath::Distance2BetweenPoints(a, b);
+  return w[0];
 }
 
-
 } // namespace mirtk
@@ -25,9 +25,11 @@
 
 #include "vtkPolyData.h"
 #include "vtkPoints.h"
+#include "vtkPointData.h"
 #include "vtkCellArray.h"
 #include "vtkDataArray.h"
 #include "vtkDoubleArray.h"
+#include "vtkIdTypeArray.h"
 
 
 namespace mirtk {
@@ -135,12 +137,15 @@ void BoundaryMapper::Finalize()
   vtkSmartPointer<vtkCellArray> verts  = vtkSmartPointer<vtkCellArray>::New();
   vtkSmartPointer<vtkCellArray> lines  = vtkSmartPointer<vtkCellArray>::New();
   vtkSmartPointer<vtkDataArray> values = vtkSmartPointer<vtkDoubleArray>::New();
+  vtkSmartPointer<vtkIdTypeArray> surfPtIds = vtkSmartPointer<vtkIdTypeArray>::New();
 
   // Get only those boundary points with valid map value
   values->SetName("BoundaryMap");
   values->SetNumberOfComponents(dim);
   points->Allocate(static_cast<vtkIdType>(num));
   values->Allocate(static_cast<vtkIdType>(dim * num));
+  surfPtIds->SetName("SurfacePointIds");
+  surfPtIds->Allocate(static_cast<vtkIdType>(num));
 
   double p[3];
   UnorderedMap<int, vtkIdType> ptIds;
@@ -151,6 +156,7 @@ void BoundaryMapper::Finalize()
       _Boundary->GetPoint(i, p);
       ptIds[i] = points->InsertNextPoint(p);
       values->InsertNextTuple(_Values.Col(i));
+      surfPtIds->InsertNextValue(static_cast<vtkIdType>(_Boundary->PointId(i)));
     }
   }
   if (points->GetNumberOfPoints() == 0) {
@@ -160,6 +166,7 @@ void BoundaryMapper::Finalize()
 
   points->Squeeze();
   values->Squeeze();
+  surfPtIds->Squeeze();
 
   // Determine topology of boundary map domain
   int       curPt, prePt, nxtPt;
@@ -196,6 +203,7 @@ void BoundaryMapper::Finalize()
   // Assemble piecewise linear output map
   vtkSmartPointer<vtkPolyData> domain = vtkSmartPointer<vtkPolyData>::New();
   domain->SetPoints(points);
+  domain->GetPointData()->AddArray(surfPtIds);
   if (verts->GetNumberOfCells() > 0) {
     verts ->Squeeze();
     domain->SetVerts(verts);
@@ -21,6 +21,7 @@
 
 #include "mirtk/Math.h"
 #include "mirtk/VtkMath.h"
+#include "mirtk/TriangleMeshGeometry.h"
 
 
 namespace mirtk {
@@ -67,6 +68,12 @@ ChordLengthSurfaceMapper::~ChordLengthSurfaceMapper()
 {
 }
 
+// -----------------------------------------------------------------------------
+LinearFixedBoundarySurfaceMapper *ChordLengthSurfaceMapper::NewCopy() const
+{
+  return new ChordLengthSurfaceMapper(*this);
+}
+
 // =============================================================================
 // Execution
 // =============================================================================
@@ -85,5 +92,30 @@ double ChordLengthSurfaceMapper::Weight(int i, int j) const
   return pow(sqrt(dist2), _Exponent);
 }
 
+// -----------------------------------------------------------------------------
+bool ChordLengthSurfaceMapper::UniformWeights() const
+{
+  return _Exponent <= 0;
+}
+
+// -----------------------------------------------------------------------------
+void ChordLengthSurfaceMapper::ComputeWeights(Array<double> &w) const
+{
+  if (_Exponent <= 0) {
+    w.assign(_EdgeTable->NumberOfEdges(), 1.0);
+    return;
+  }
+  TriangleMeshGeometry geometry(_Surface, _EdgeTable);
+  geometry.TriangleGeometry(false);
+  geometry.Run();
+  w = geometry.EdgeLengths();
+  const int nedges = static_cast<int>(w.size());
+  if (_Exponent == 2) {
+    for (int e = 0; e < nedges; ++e) w[e] *= w[e];
+  } else if (_Exponent != 1) {
+    for (int e = 0; e < nedges; ++e) w[e] = pow(w[e], _Exponent);
+  }
+}
+
 
 } // namespace mirtk
@@ -20,11 +20,12 @@
 #include "mirtk/ConformalSurfaceFlattening.h"
 
 #include "mirtk/VtkMath.h"
-#include "mirtk/Triangle.h"
+#include "mirtk/CotangentLaplacian.h"
 #include "mirtk/EdgeTable.h"
 #include "mirtk/SurfaceCurvature.h"
 #include "mirtk/PiecewiseLinearMap.h"
 #include "mirtk/PointSetUtils.h"
+#include "mirtk/SparseLinearSolver.h"
 
 #include "vtkIdList.h"
 #include "vtkPointData.h"
@@ -37,9 +38,6 @@
 #endif
 
 #include "Eigen/SparseCore"
-#include "Eigen/SparseLU"
-#include "Eigen/OrderingMethods"
-#include "Eigen/IterativeLinearSolvers"
 
 
 namespace mirtk {
@@ -61,8 +59,10 @@ void ConformalSurfaceFlattening
   _MapToSphere        = other._MapToSphere;
   _Scale              = other._Scale;
   _Radius             = other._Radius;
+  _LinearSolver       = other._LinearSolver;
   _NumberOfIterations = other._NumberOfIterations;
   _Tolerance          = other._Tolerance;
+  _MixedPrecision     = other._MixedPrecision;
 }
 
 // -----------------------------------------------------------------------------
@@ -72,8 +72,10 @@ ConformalSurfaceFlattening::ConformalSurfaceFlattening()
   _MapToSphere(true),
   _Scale(0.),
   _Radius(1.),
+  _LinearSolver(LinearSolver_Default),
   _NumberOfIterations(-1),
-  _Tolerance(-1.)
+  _Tolerance(-1.),
+  _MixedPrecision(false)
 {
 }
 
@@ -117,6 +119,9 @@ void ConformalSurfaceFlattening::Initialize()
     cerr << this->NameOfType() << "::Initialize: Invalid fixed point cell ID!" << endl;
     exit(1);
   }
+  if (_PolarCellId >= 0) {
+    _PolarCellId = ReorderedCellId(_PolarCellId);
+  }
 
   // Select cell with lowest average curvature as cell containing the polar point
   if (_PolarCellId < 0) {
@@ -171,8 +176,6 @@ void ConformalSurfaceFlattening::Initialize()
 // -----------------------------------------------------------------------------
 void ConformalSurfaceFlattening::ComputeMap()
 {
-  const double use_direct_solver = (_NumberOfIterations < 0 || _NumberOfIterations == 1);
-
   MIRTK_START_TIMING();
 
   typedef Eigen::MatrixXd             Values;
@@ -182,47 +185,11 @@ void ConformalSurfaceFlattening::ComputeMap()
   const int m = 2;
 
   // Calculate matrix D
-  Matrix D(n, n);
+  Matrix D;
   {
-    typedef Eigen::VectorXi Vector;
-
-    vtkIdType npts, *pts;                // cell links list reference
-    double posA [3], posB [3], posC [3]; // position of cell corner points
-    double cotABC, cotBCA, cotCAB;       // cotangent of cell angles
-
-    D.reserve(Vector::Constant(n, _EdgeTable->MaxNumberOfAdjacentPoints() + 1));
-    for (vtkIdType cellId = 0; cellId < _Surface->GetNumberOfCells(); ++cellId) {
-      _Surface->GetCellPoints(cellId, npts, pts);
-      if (npts != 3) {
-        cerr << this->NameOfType() << "::ComputeMap: Surface mesh must be triangulated!" << endl;
-        exit(1);
-      }
-
-      const vtkIdType &ptIdA = pts[0];
-      const vtkIdType &ptIdB = pts[1];
-      const vtkIdType &ptIdC = pts[2];
-
-      _Surface->GetPoint(ptIdA, posA);
-      _Surface->GetPoint(ptIdB, posB);
-      _Surface->GetPoint(ptIdC, posC);
-
-      cotABC = Triangle::Cotangent(posA, posB, posC);
-      cotBCA = Triangle::Cotangent(posB, posC, posA);
-      cotCAB = Triangle::Cotangent(posC, posA, posB);
-
-      D.coeffRef(ptIdA, ptIdA) += cotABC + cotBCA;
-      D.coeffRef(ptIdA, ptIdB) -= cotBCA;
-      D.coeffRef(ptIdA, ptIdC) -= cotABC;
-
-      D.coeffRef(ptIdB, ptIdB) += cotBCA + cotCAB;
-      D.coeffRef(ptIdB, ptIdA) -= cotBCA;
-      D.coeffRef(ptIdB, ptIdC) -= cotCAB;
-
-      D.coeffRef(ptIdC, ptIdC) += cotCAB + cotABC;
-      D.coeffRef(ptIdC, ptIdB) -= cotCAB;
-      D.coeffRef(ptIdC, ptIdA) -= cotABC;
-    }
-    D.makeCompressed();
+    CotangentLaplacian laplacian(_Surface, _EdgeTable);
+    laplacian.Run();
+    laplacian.GetStiffnessMatrix(D);
   }
 
   // Calculate (complex) right hand side vector b
@@ -283,22 +250,20 @@ void ConformalSurfaceFlattening::ComputeMap()
 
   MIRTK_RESET_TIMING();
 
+  // Solve linear system, where system matrix is symmetric, but singular
+  SparseLinearSolver solver(_LinearSolver, true);
+  solver.MaxNumberOfIterations(_NumberOfIterations);
+  solver.Tolerance(_Tolerance);
+  solver.MixedPrecision(_MixedPrecision);
+  if (solver.SolverType() == LinearSolver_LDLT && _LinearSolver == LinearSolver_Default) {
+    solver.Type(LinearSolver_LU);
+  }
+
   Values x(n, m);
-  int    niter = 0;
-  double error = nan;
-
-  if (use_direct_solver) {
-    Eigen::SparseLU<Matrix> solver;
-    solver.analyzePattern(D);
-    solver.factorize(D);
-    x = solver.solve(b);
-  } else {
-    Eigen::ConjugateGradient<Matrix> solver(D);
-    if (_NumberOfIterations > 0 ) solver.setMaxIterations(_NumberOfIterations);
-    if (_Tolerance          > 0.) solver.setTolerance(_Tolerance);
-    x = solver.solve(b);
-    niter = solver.iterations();
-    error = solver.error();
+  x.setZero();
+  if (!solver.Solve(D, b, x)) {
+    cerr << this->NameOfType() << "::ComputeMap: Failed to solve linear system" << endl;
+    exit(1);
   }
 
   for (int i = 0; i < n; ++i) {
@@ -309,9 +274,15 @@ void ConformalSurfaceFlattening::ComputeMap()
 
   MIRTK_DEBUG_TIMING(1, "solving sparse linear system");
 
-  if (verbose && !use_direct_solver) {
-    cout << "  No. of iterations      = " << niter << "\n";
-    cout << "  Estimated error        = " << error << "\n";
+  if (verbose) {
+    cout << "  Linear solver          = " << ToString(solver.UsedType()) << "\n";
+    if (IsIterativeLinearSolver(solver.UsedType())) {
+      cout << "  No. of iterations      = " << solver.NumberOfIterations() << "\n";
+      cout << "  Estimated error        = " << solver.Error() << "\n";
+    } else if (solver.MixedPrecision()) {
+      cout << "  No. of refinements     = " << solver.NumberOfIterations() << "\n";
+      cout << "  Estimated error        = " << solver.Error() << "\n";
+    }
     cout.flush();
   }
 }
@@ -351,6 +322,9 @@ void ConformalSurfaceFlattening::Finalize()
     }
   }
 
+  // Convert ID of polar cell back to ID of input surface cell
+  _PolarCellId = OriginalCellId(_PolarCellId);
+
   // Set output surface map
   SharedPtr<PiecewiseLinearMap> map = NewShared<PiecewiseLinearMap>();
   vtkSmartPointer<vtkPolyData> domain;
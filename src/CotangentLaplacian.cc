@@ -0,0 +1,312 @@
+/*
+ * Medical Image Registration ToolKit (MIRTK)
+ *
+ * Copyright 2013-2016 Imperial College London
+ * Copyright 2013-2016 Andreas Schuh
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mirtk/CotangentLaplacian.h"
+
+#include "mirtk/Parallel.h"
+#include "mirtk/Algorithm.h"
+
+
+namespace mirtk {
+
+
+// =============================================================================
+// Auxiliary functors
+// =============================================================================
+
+namespace CotangentLaplacianUtils {
+
+
+// -----------------------------------------------------------------------------
+/// Base of functors which gather values of triangle corners at each point
+struct GatherCornerValues
+{
+  const int    *_CornerOffsets;
+  const int    *_Corners;
+  const int    *_Entries;
+  const double *_Cotangents;
+  const double *_DoubleAreas;
+  double       *_Values;
+};
+
+// -----------------------------------------------------------------------------
+/// Set entries of rows of cotangent stiffness matrix
+struct AssembleStiffnessMatrix : public GatherCornerValues
+{
+  void operator ()(const blocked_range<int> &ptIds) const
+  {
+    for (int i = ptIds.begin(); i != ptIds.end(); ++i) {
+      for (int k = _CornerOffsets[i]; k < _CornerOffsets[i+1]; ++k) {
+        const int     corner = _Corners[k];
+        const int     t      = corner / 3;
+        const int     c      = corner % 3;
+        const int    *entry  = _Entries + 3 * corner;
+        const double  cot_j  = _Cotangents[3 * t + (c + 1) % 3];
+        const double  cot_k  = _Cotangents[3 * t + (c + 2) % 3];
+        // Edge (i, j) is opposite to corner k and edge (i, k) to corner j
+        _Values[entry[0]] += cot_j + cot_k;
+        _Values[entry[1]] -= cot_k;
+        _Values[entry[2]] -= cot_j;
+      }
+    }
+  }
+};
+
+// -----------------------------------------------------------------------------
+/// Set entries of rows of consistent mass matrix
+struct AssembleMassMatrix : public GatherCornerValues
+{
+  void operator ()(const blocked_range<int> &ptIds) const
+  {
+    for (int i = ptIds.begin(); i != ptIds.end(); ++i) {
+      for (int k = _CornerOffsets[i]; k < _CornerOffsets[i+1]; ++k) {
+        const int     corner = _Corners[k];
+        const int    *entry  = _Entries + 3 * corner;
+        const double  area2  = _DoubleAreas[corner / 3];
+        _Values[entry[0]] += area2 / 12.;
+        _Values[entry[1]] += area2 / 24.;
+        _Values[entry[2]] += area2 / 24.;
+      }
+    }
+  }
+};
+
+// -----------------------------------------------------------------------------
+/// Compute diagonal entries of lumped mass matrix
+struct AssembleLumpedMassMatrix : public GatherCornerValues
+{
+  void operator ()(const blocked_range<int> &ptIds) const
+  {
+    for (int i = ptIds.begin(); i != ptIds.end(); ++i) {
+      _Values[i] = .0;
+      for (int k = _CornerOffsets[i]; k < _CornerOffsets[i+1]; ++k) {
+        _Values[i] += _DoubleAreas[_Corners[k] / 3] / 6.;
+      }
+    }
+  }
+};
+
+
+} // namespace CotangentLaplacianUtils
+using namespace CotangentLaplacianUtils;
+
+// =============================================================================
+// Construction/destruction
+// =============================================================================
+
+// -----------------------------------------------------------------------------
+void CotangentLaplacian::CopyAttributes(const CotangentLaplacian &other)
+{
+  _Surface       = other._Surface;
+  _EdgeTable     = other._EdgeTable;
+  _Geometry      = other._Geometry;
+  _Offsets       = other._Offsets;
+  _Indices       = other._Indices;
+  _CornerOffsets = other._CornerOffsets;
+  _Corners       = other._Corners;
+  _Entries       = other._Entries;
+}
+
+// -----------------------------------------------------------------------------
+CotangentLaplacian::CotangentLaplacian(vtkPolyData *surface, SharedPtr<mirtk::EdgeTable> edgeTable)
+:
+  _Surface(surface),
+  _EdgeTable(edgeTable)
+{
+}
+
+// -----------------------------------------------------------------------------
+CotangentLaplacian::CotangentLaplacian(const CotangentLaplacian &other)
+:
+  Object(other)
+{
+  CopyAttributes(other);
+}
+
+// -----------------------------------------------------------------------------
+CotangentLaplacian &CotangentLaplacian::operator =(const CotangentLaplacian &other)
+{
+  if (this != &other) {
+    Object::operator =(other);
+    CopyAttributes(other);
+  }
+  return *this;
+}
+
+// -----------------------------------------------------------------------------
+CotangentLaplacian::~CotangentLaplacian()
+{
+}
+
+// =============================================================================
+// Execution
+// =============================================================================
+
+// -----------------------------------------------------------------------------
+void CotangentLaplacian::Run()
+{
+  // Check input
+  if (!_Surface) {
+    cerr << this->NameOfType() << "::Run: Missing input surface" << endl;
+    exit(1);
+  }
+  if (!_EdgeTable) {
+    _EdgeTable = NewShared<mirtk::EdgeTable>(_Surface);
+  }
+
+  // Get triangles and compute their cotangents and areas
+  _Geometry.Surface(_Surface);
+  _Geometry.EdgeTable(_EdgeTable);
+  _Geometry.TriangleGeometry(true);
+  _Geometry.Run();
+
+  const int         n          = static_cast<int>(_Surface->GetNumberOfPoints());
+  const int         ntriangles = _Geometry.NumberOfTriangles();
+  const Array<int> &triangles  = _Geometry.Triangles();
+
+  // Non-zero pattern of symmetric matrices with sorted column indices
+  int        d_i;
+  const int *j;
+  _Offsets.resize(n + 1);
+  _Offsets[0] = 0;
+  for (int i = 0; i < n; ++i) {
+    _EdgeTable->GetAdjacentPoints(i, d_i, j);
+    _Offsets[i+1] = _Offsets[i] + d_i + 1;
+  }
+  _Indices.resize(_Offsets[n]);
+  for (int i = 0; i < n; ++i) {
+    int * const begin = _Indices.data() + _Offsets[i];
+    int *       idx   = begin;
+    *idx++ = i;
+    _EdgeTable->GetAdjacentPoints(i, d_i, j);
+    for (int k = 0; k < d_i; ++k) *idx++ = j[k];
+    sort(begin, idx);
+  }
+
+  // Corners of triangles adjacent to each point
+  _CornerOffsets.assign(n + 1, 0);
+  for (int corner = 0; corner < 3 * ntriangles; ++corner) {
+    ++_CornerOffsets[triangles[corner] + 1];
+  }
+  for (int i = 0; i < n; ++i) {
+    _CornerOffsets[i+1] += _CornerOffsets[i];
+  }
+  _Corners.resize(3 * ntriangles);
+  Array<int> count(_CornerOffsets.begin(), _CornerOffsets.end() - 1);
+  for (int corner = 0; corner < 3 * ntriangles; ++corner) {
+    _Corners[count[triangles[corner]]++] = corner;
+  }
+
+  // Indices of non-zero entries of each triangle corner
+  _Entries.resize(9 * ntriangles);
+  for (int t = 0; t < ntriangles; ++t) {
+    const int * const tri = triangles.data() + 3 * t;
+    for (int c = 0; c < 3; ++c) {
+      const int pt[3] = {tri[c], tri[(c + 1) % 3], tri[(c + 2) % 3]};
+      const int * const begin = _Indices.data() + _Offsets[pt[0]];
+      const int * const end   = _Indices.data() + _Offsets[pt[0] + 1];
+      int * const entry = _Entries.data() + 3 * (3 * t + c);
+      for (int k = 0; k < 3; ++k) {
+        const int *it = lower_bound(begin, end, pt[k]);
+        if (it == end || *it != pt[k]) {
+          cerr << this->NameOfType() << "::Run: Edge table does not match surface mesh" << endl;
+          exit(1);
+        }
+        entry[k] = static_cast<int>(it - _Indices.data());
+      }
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+void CotangentLaplacian::Update()
+{
+  _Geometry.Update();
+}
+
+// =============================================================================
+// Discrete operators
+// =============================================================================
+
+// -----------------------------------------------------------------------------
+void CotangentLaplacian::InitializeMatrix(Matrix &A) const
+{
+  const int n = NumberOfPoints();
+  A.resize(n, n);
+  A.resizeNonZeros(_Offsets[n]);
+  memcpy(A.outerIndexPtr(), _Offsets.data(), _Offsets.size() * sizeof(int));
+  memcpy(A.innerIndexPtr(), _Indices.data(), _Indices.size() * sizeof(int));
+  memset(A.valuePtr(), 0, _Indices.size() * sizeof(double));
+}
+
+// -----------------------------------------------------------------------------
+void CotangentLaplacian::GetStiffnessMatrix(Matrix &L) const
+{
+  InitializeMatrix(L);
+  AssembleStiffnessMatrix assemble;
+  assemble._CornerOffsets = _CornerOffsets.data();
+  assemble._Corners       = _Corners.data();
+  assemble._Entries       = _Entries.data();
+  assemble._Cotangents    = _Geometry.Cotangents().data();
+  assemble._DoubleAreas   = _Geometry.DoubleAreas().data();
+  assemble._Values        = L.valuePtr();
+  parallel_for(blocked_range<int>(0, NumberOfPoints()), assemble);
+}
+
+// -----------------------------------------------------------------------------
+void CotangentLaplacian::GetMassMatrix(Matrix &M) const
+{
+  InitializeMatrix(M);
+  AssembleMassMatrix assemble;
+  assemble._CornerOffsets = _CornerOffsets.data();
+  assemble._Corners       = _Corners.data();
+  assemble._Entries       = _Entries.data();
+  assemble._Cotangents    = _Geometry.Cotangents().data();
+  assemble._DoubleAreas   = _Geometry.DoubleAreas().data();
+  assemble._Values        = M.valuePtr();
+  parallel_for(blocked_range<int>(0, NumberOfPoints()), assemble);
+}
+
+// -----------------------------------------------------------------------------
+void CotangentLaplacian::GetLumpedMassMatrix(Vector &M) const
+{
+  M.resize(NumberOfPoints());
+  AssembleLumpedMassMatrix assemble;
+  assemble._CornerOffsets = _CornerOffsets.data();
+  assemble._Corners       = _Corners.data();
+  assemble._Entries       = _Entries.data();
+  assemble._Cotangents    = _Geometry.Cotangents().data();
+  assemble._DoubleAreas   = _Geometry.DoubleAreas().data();
+  assemble._Values        = M.data();
+  parallel_for(blocked_range<int>(0, NumberOfPoints()), assemble);
+}
+
+// -----------------------------------------------------------------------------
+void CotangentLaplacian::GetEdgeWeights(Array<double> &w) const
+{
+  const Array<double> &cot   = _Geometry.Cotangents();
+  const Array<int>    &edges = _Geometry.TriangleEdges();
+  w.assign(_Geometry.NumberOfEdges(), .0);
+  for (size_t corner = 0; corner < cot.size(); ++corner) {
+    w[edges[corner]] += cot[corner];
+  }
+}
+
+
+} // namespace mirtk
@@ -21,6 +21,7 @@
 
 #include "mirtk/VtkMath.h"
 #include "mirtk/Triangle.h"
+#include "mirtk/CotangentLaplacian.h"
 
 #include "vtkIdList.h"
 
@@ -66,6 +67,12 @@ HarmonicSurfaceMapper::~HarmonicSurfaceMapper()
 {
 }
 
+// -----------------------------------------------------------------------------
+LinearFixedBoundarySurfaceMapper *HarmonicSurfaceMapper::NewCopy() const
+{
+  return new HarmonicSurfaceMapper(*this);
+}
+
 // =============================================================================
 // Execution
 // =============================================================================
@@ -97,5 +104,15 @@ double HarmonicSurfaceMapper::Weight(int i, int j) const
   return w;
 }
 
+// -----------------------------------------------------------------------------
+void HarmonicSurfaceMapper::ComputeWeights(Array<double> &w) const
+{
+  CheckTriangulated("ComputeWeights");
+
+  CotangentLaplacian laplacian(_Surface, _EdgeTable);
+  laplacian.Run();
+  laplacian.GetEdgeWeights(w);
+}
+
 
 } // namespace mirtk
@@ -85,6 +85,12 @@ IntrinsicLeastAreaDistortionSurfaceMapper
 {
 }
 
+// -----------------------------------------------------------------------------
+LinearFixedBoundarySurfaceMapper *IntrinsicLeastAreaDistortionSurfaceMapper::NewCopy() const
+{
+  return new IntrinsicLeastAreaDistortionSurfaceMapper(*this);
+}
+
 // =============================================================================
 // Execution
 // =============================================================================
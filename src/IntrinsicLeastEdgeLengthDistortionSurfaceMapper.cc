@@ -79,6 +79,12 @@ IntrinsicLeastEdgeLengthDistortionSurfaceMapper
 {
 }
 
+// -----------------------------------------------------------------------------
+LinearFixedBoundarySurfaceMapper *IntrinsicLeastEdgeLengthDistortionSurfaceMapper::NewCopy() const
+{
+  return new IntrinsicLeastEdgeLengthDistortionSurfaceMapper(*this);
+}
+
 // =============================================================================
 // Execution
 // =============================================================================
@@ -21,6 +21,7 @@
 
 #include "mirtk/Math.h"
 #include "mirtk/Triangle.h"
+#include "mirtk/TriangleMeshGeometry.h"
 
 
 namespace mirtk {
@@ -66,6 +67,12 @@ IntrinsicSurfaceMapper::~IntrinsicSurfaceMapper()
 {
 }
 
+// -----------------------------------------------------------------------------
+LinearFixedBoundarySurfaceMapper *IntrinsicSurfaceMapper::NewCopy() const
+{
+  return new IntrinsicSurfaceMapper(*this);
+}
+
 // =============================================================================
 // Execution
 // =============================================================================
@@ -100,5 +107,65 @@ double IntrinsicSurfaceMapper::Weight(int i, int j) const
   return _Lambda * w_conformal + mu * w_authalic;
 }
 
+// -----------------------------------------------------------------------------
+void IntrinsicSurfaceMapper::ComputeWeightComponents()
+{
+  CheckTriangulated("ComputeWeightComponents");
+
+  TriangleMeshGeometry geometry(_Surface, _EdgeTable);
+  geometry.Run();
+
+  const int             nedges = geometry.NumberOfEdges();
+  const Array<double>  &cot    = geometry.Cotangents();
+  const Array<int>     &edges  = geometry.TriangleEdges();
+  const Array<double>  &length = geometry.EdgeLengths();
+
+  // Sum of cotangents of the angles opposite to each edge
+  _ConformalWeights.assign(nedges, 0.);
+  for (size_t corner = 0; corner < cot.size(); ++corner) {
+    _ConformalWeights[edges[corner]] += cot[corner];
+  }
+
+  // Sum of cotangents of the angles at end point j of edge (i, j)
+  // divided by the squared edge length
+  Array<double> sum;
+  geometry.GetEdgeEndSums(cot, sum);
+  _AuthalicWeights.resize(2 * nedges);
+  for (int e = 0; e < nedges; ++e) {
+    const double l2 = length[e] * length[e];
+    _AuthalicWeights[2 * e    ] = sum[2 * e + 1] / l2;
+    _AuthalicWeights[2 * e + 1] = sum[2 * e    ] / l2;
+  }
+}
+
+// -----------------------------------------------------------------------------
+void IntrinsicSurfaceMapper::ComputeWeights(Array<double> &w) const
+{
+  const int    nedges = static_cast<int>(_ConformalWeights.size());
+  const double mu     = 1. - _Lambda;
+  if (_Lambda == 0.) {
+    w = _AuthalicWeights;
+  } else if (mu == 0.) {
+    w.resize(2 * nedges);
+    for (int e = 0; e < nedges; ++e) {
+      w[2 * e] = w[2 * e + 1] = _ConformalWeights[e];
+    }
+  } else {
+    w.resize(2 * nedges);
+    for (int e = 0; e < nedges; ++e) {
+      w[2 * e    ] = _Lambda * _ConformalWeights[e] + mu * _AuthalicWeights[2 * e    ];
+      w[2 * e + 1] = _Lambda * _ConformalWeights[e] + mu * _AuthalicWeights[2 * e + 1];
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+void IntrinsicSurfaceMapper::ComputeMap()
+{
+  ComputeWeightComponents();
+  NonSymmetricWeightsSurfaceMapper::ComputeMap();
+  _ConformalWeights.clear();
+  _AuthalicWeights.clear();
+}
 
 } // namespace mirtk
@@ -20,9 +20,10 @@
 #include "mirtk/LeastSquaresConformalSurfaceMapper.h"
 
 #include "mirtk/Algorithm.h"
-#include "mirtk/Triangle.h"
+#include "mirtk/CotangentLaplacian.h"
 #include "mirtk/PiecewiseLinearMap.h"
 #include "mirtk/ChordLengthBoundarySegmentParameterizer.h"
+#include "mirtk/SparseLinearSolver.h"
 
 #include "vtkPointData.h"
 #include "vtkCellData.h"
@@ -47,8 +48,11 @@ MIRTK_Common_EXPORT extern int verbose;
 void LeastSquaresConformalSurfaceMapper
 ::CopyAttributes(const LeastSquaresConformalSurfaceMapper &other)
 {
+  _LinearSolver       = other._LinearSolver;
+  _Preconditioner     = other._Preconditioner;
   _NumberOfIterations = other._NumberOfIterations;
   _Tolerance          = other._Tolerance;
+  _MixedPrecision     = other._MixedPrecision;
   _PointIndex         = other._PointIndex;
   _FreePoints         = other._FreePoints;
   _FixedPoints        = other._FixedPoints;
@@ -65,8 +69,11 @@ void LeastSquaresConformalSurfaceMapper
 // -----------------------------------------------------------------------------
 LeastSquaresConformalSurfaceMapper::LeastSquaresConformalSurfaceMapper()
 :
+  _LinearSolver(LinearSolver_Default),
+  _Preconditioner(Preconditioner_Default),
   _NumberOfIterations(-1),
-  _Tolerance(-1.)
+  _Tolerance(-1.),
+  _MixedPrecision(false)
 {
 }
 
@@ -123,27 +130,13 @@ void LeastSquaresConformalSurfaceMapper::AddFixedPoint(int i, double u, double v
 // =============================================================================
 
 // -----------------------------------------------------------------------------
-double LeastSquaresConformalSurfaceMapper::Weight(int i, int j) const
+void LeastSquaresConformalSurfaceMapper::ComputeWeights(Array<double> &w) const
 {
-  int    k, l;
-  double a[3], b[3], c[3], w;
+  CheckTriangulated("ComputeWeights");
 
-  const int n = GetEdgeNeighborPoints(i, j, k, l);
-  if (n == 0 || n > 2) {
-    cerr << this->NameOfType() << "::Weight: Surface mesh must be triangulated!" << endl;
-    exit(1);
-  }
-
-  _Surface->GetPoint(static_cast<vtkIdType>(i), a);
-  _Surface->GetPoint(static_cast<vtkIdType>(k), b);
-  _Surface->GetPoint(static_cast<vtkIdType>(j), c);
-  w = Triangle::Cotangent(a, b, c);
-  if (n == 2) {
-    _Surface->GetPoint(static_cast<vtkIdType>(l), b);
-    w += Triangle::Cotangent(a, b, c);
-  }
-
-  return w;
+  CotangentLaplacian laplacian(_Surface, _EdgeTable);
+  laplacian.Run();
+  laplacian.GetEdgeWeights(w);
 }
 
 // -----------------------------------------------------------------------------
@@ -158,6 +151,11 @@ void LeastSquaresConformalSurfaceMapper::Initialize()
     exit(1);
   }
 
+  // Convert IDs of fixed input surface points to IDs of reordered points
+  for (size_t i = 0; i < _FixedPoints.size(); ++i) {
+    _FixedPoints[i] = ReorderedPointId(_FixedPoints[i]);
+  }
+
   // Choose fixed points
   int s, i;
   if (NumberOfFixedPoints() == 0) {
@@ -229,8 +227,6 @@ void LeastSquaresConformalSurfaceMapper::Initialize()
 // -----------------------------------------------------------------------------
 void LeastSquaresConformalSurfaceMapper::ComputeMap()
 {
-  const bool use_direct_solver = (_NumberOfIterations == 1 || _NumberOfIterations < 0);
-
   MIRTK_START_TIMING();
 
   typedef Eigen::VectorXd             Vector;
@@ -240,7 +236,7 @@ void LeastSquaresConformalSurfaceMapper::ComputeMap()
   const int n = NumberOfFreePoints();
   const int m = 2;
 
-  int i, j, ui, vi, uj, vj;
+  int i, j, edgeId, ui, vi, uj, vj;
 
   Matrix A(m * n, m * n);
   Vector b(m * n);
@@ -252,12 +248,15 @@ void LeastSquaresConformalSurfaceMapper::ComputeMap()
     w.reserve(m * n * (_EdgeTable->MaxNumberOfAdjacentPoints() + 1));
     b.setZero();
 
+    Array<double> weights;
+    this->ComputeWeights(weights);
+
     EdgeIterator edgeIt(*_EdgeTable);
-    for (edgeIt.InitTraversal(); edgeIt.GetNextEdge(i, j) != -1;) {
+    for (edgeIt.InitTraversal(); (edgeId = edgeIt.GetNextEdge(i, j)) != -1;) {
       ui = FreePointIndex(i), vi = ui + n;
       uj = FreePointIndex(j), vj = uj + n;
       if (ui >= 0 || uj >= 0) {
-        w_ij  = - this->Weight(i, j);
+        w_ij  = - weights[edgeId];
         if (ui >= 0 && uj >= 0) {
           w.push_back(NZEntry(ui, uj, w_ij));
           w.push_back(NZEntry(uj, ui, w_ij));
@@ -323,22 +322,18 @@ void LeastSquaresConformalSurfaceMapper::ComputeMap()
 
   MIRTK_RESET_TIMING();
 
+  // Solve linear system, where system matrix is symmetric
+  SparseLinearSolver solver(_LinearSolver, true);
+  solver.Preconditioner(_Preconditioner);
+  solver.MaxNumberOfIterations(_NumberOfIterations);
+  solver.Tolerance(_Tolerance);
+  solver.MixedPrecision(_MixedPrecision);
+
   Vector x(m * n);
-  int    niter = 0;
-  double error = nan;
-
-  if (use_direct_solver) {
-    Eigen::SparseLU<Matrix> solver;
-    solver.analyzePattern(A);
-    solver.factorize(A);
-    x = solver.solve(b);
-  } else {
-    Eigen::ConjugateGradient<Matrix> solver(A);
-    if (_NumberOfIterations > 0 ) solver.setMaxIterations(_NumberOfIterations);
-    if (_Tolerance          > 0.) solver.setTolerance(_Tolerance);
-    x = solver.solve(b);
-    niter = solver.iterations();
-    error = solver.error();
+  x.setZero();
+  if (!solver.Solve(A, b, x)) {
+    cerr << this->NameOfType() << "::ComputeMap: Failed to solve linear system" << endl;
+    exit(1);
   }
 
   for (ui = 0, vi = n; ui < n; ++ui, ++vi) {
@@ -349,9 +344,16 @@ void LeastSquaresConformalSurfaceMapper::ComputeMap()
 
   MIRTK_DEBUG_TIMING(1, "solving sparse linear system");
 
-  if (verbose && !use_direct_solver) {
-    cout << "  No. of iterations            = " << niter << "\n";
-    cout << "  Estimated error              = " << error << "\n";
+  if (verbose) {
+    cout << "  Linear solver                = " << ToString(solver.UsedType()) << "\n";
+    if (IsIterativeLinearSolver(solver.UsedType())) {
+      cout << "  Preconditioner               = " << ToString(solver.PreconditionerType()) << "\n";
+      cout << "  No. of iterations            = " << solver.NumberOfIterations() << "\n";
+      cout << "  Estimated error              = " << solver.Error() << "\n";
+    } else if (solver.MixedPrecision()) {
+      cout << "  No. of refinement steps      = " << solver.NumberOfIterations() << "\n";
+      cout << "  Estimated error              = " << solver.Error() << "\n";
+    }
     cout.flush();
   }
 }
@@ -359,6 +361,11 @@ void LeastSquaresConformalSurfaceMapper::ComputeMap()
 // -----------------------------------------------------------------------------
 void LeastSquaresConformalSurfaceMapper::Finalize()
 {
+  // Convert IDs of points back to IDs of input surface points
+  OriginalPointIds(_FixedPoints);
+  OriginalPointIds(_FreePoints);
+  RestorePointOrder(_PointIndex);
+
   // Assemble surface map
   SharedPtr<PiecewiseLinearMap> map = NewShared<PiecewiseLinearMap>();
   vtkSmartPointer<vtkPolyData> domain;
@@ -372,6 +379,9 @@ void LeastSquaresConformalSurfaceMapper::Finalize()
 
   // Finalize base class
   FreeBoundarySurfaceMapper::Finalize();
+
+  // Map values in input point order
+  _Values = map->Values();
 }
 
 
@@ -20,19 +20,159 @@
 #include "mirtk/LinearFixedBoundarySurfaceMapper.h"
 
 #include "mirtk/Memory.h"
+#include "mirtk/EdgeTable.h"
 #include "mirtk/PiecewiseLinearMap.h"
+#include "mirtk/SparseSystemCache.h"
 
+#include "mirtk/Vtk.h"
 #include "vtkSmartPointer.h"
 #include "vtkPolyData.h"
+#include "vtkCellArray.h"
 #include "vtkPointData.h"
 #include "vtkCellData.h"
 #include "vtkFloatArray.h"
 #include "vtkDoubleArray.h"
+#include "vtkIdTypeArray.h"
+#include "vtkDecimatePro.h"
 
 
 namespace mirtk {
 
 
+// Global flags (cf. mirtk/Options.h)
+MIRTK_Common_EXPORT extern int verbose;
+
+
+// =============================================================================
+// Auxiliaries
+// =============================================================================
+
+namespace LinearFixedBoundarySurfaceMapperUtils {
+
+
+/// Name of point data array of coarse surface with IDs of finer surface points
+const char * const _FinePointIdsName = "FinePointIds";
+
+/// Minimum number of points of coarsest multiresolution level
+const vtkIdType _MinNumberOfLevelPoints = 100;
+
+// -----------------------------------------------------------------------------
+/// Decimate surface mesh while preserving its boundary and topology
+///
+/// The decimated surface has a point data array with the ID of the
+/// corresponding point of the input surface.
+vtkSmartPointer<vtkPolyData> Decimate(vtkPolyData *surface, double reduction)
+{
+  const vtkIdType npoints = surface->GetNumberOfPoints();
+
+  vtkSmartPointer<vtkIdTypeArray> ptIds = vtkSmartPointer<vtkIdTypeArray>::New();
+  ptIds->SetName(_FinePointIdsName);
+  ptIds->SetNumberOfComponents(1);
+  ptIds->SetNumberOfTuples(npoints);
+  for (vtkIdType ptId = 0; ptId < npoints; ++ptId) {
+    ptIds->SetValue(ptId, ptId);
+  }
+
+  vtkSmartPointer<vtkPolyData> input = vtkSmartPointer<vtkPolyData>::New();
+  input->CopyStructure(surface);
+  input->GetPointData()->AddArray(ptIds);
+
+  vtkSmartPointer<vtkDecimatePro> decimate = vtkSmartPointer<vtkDecimatePro>::New();
+  decimate->SetTargetReduction(reduction);
+  decimate->PreserveTopologyOn();
+  decimate->SplittingOff();
+  decimate->BoundaryVertexDeletionOff();
+  SetVTKInput(decimate, input);
+  decimate->Update();
+
+  vtkSmartPointer<vtkPolyData> output = decimate->GetOutput();
+  output->BuildLinks();
+  return output;
+}
+
+// -----------------------------------------------------------------------------
+/// Interpolate map values of coarse surface at points of finer surface
+///
+/// The values at points of the finer surface which were removed by the
+/// decimation are set to the average value of their adjacent points,
+/// proceeding from the points of the coarse surface in breadth-first order.
+///
+/// \param[in]  coarse  Map values at points of coarse surface.
+/// \param[in]  ptIds   IDs of finer surface points for each coarse point.
+/// \param[in]  edges   Edge table of finer surface.
+/// \param[out] fine    Map values at points of finer surface.
+void Prolongate(vtkDataArray *coarse, vtkDataArray *ptIds,
+                const mirtk::EdgeTable &edges, vtkDataArray *fine)
+{
+  const int n   = static_cast<int>(fine->GetNumberOfTuples());
+  const int dim = fine->GetNumberOfComponents();
+
+  int        nadj;
+  const int *adjPts;
+
+  Array<bool>   known(n, false), queued(n, false);
+  Array<int>    front, next;
+  Array<double> v(dim), w(dim);
+
+  for (int j = 0; j < dim; ++j) fine->FillComponent(j, 0.);
+  for (vtkIdType k = 0; k < coarse->GetNumberOfTuples(); ++k) {
+    const int i = static_cast<int>(ptIds->GetComponent(k, 0));
+    coarse->GetTuple(k, v.data());
+    fine->SetTuple(i, v.data());
+    known[i] = queued[i] = true;
+  }
+
+  // Points of next finer level adjacent to the known points
+  for (int i = 0; i < n; ++i) {
+    if (!known[i]) continue;
+    edges.GetAdjacentPoints(i, nadj, adjPts);
+    for (int k = 0; k < nadj; ++k) {
+      if (!queued[adjPts[k]]) {
+        queued[adjPts[k]] = true;
+        front.push_back(adjPts[k]);
+      }
+    }
+  }
+
+  // Average values of known adjacent points one ring at a time
+  while (!front.empty()) {
+    for (size_t f = 0; f < front.size(); ++f) {
+      const int i = front[f];
+      int num = 0;
+      for (int j = 0; j < dim; ++j) v[j] = 0.;
+      edges.GetAdjacentPoints(i, nadj, adjPts);
+      for (int k = 0; k < nadj; ++k) {
+        if (known[adjPts[k]]) {
+          fine->GetTuple(adjPts[k], w.data());
+          for (int j = 0; j < dim; ++j) v[j] += w[j];
+          ++num;
+        }
+      }
+      for (int j = 0; j < dim; ++j) v[j] /= num;
+      fine->SetTuple(i, v.data());
+    }
+    next.clear();
+    for (size_t f = 0; f < front.size(); ++f) {
+      known[front[f]] = true;
+    }
+    for (size_t f = 0; f < front.size(); ++f) {
+      edges.GetAdjacentPoints(front[f], nadj, adjPts);
+      for (int k = 0; k < nadj; ++k) {
+        if (!queued[adjPts[k]]) {
+          queued[adjPts[k]] = true;
+          next.push_back(adjPts[k]);
+        }
+      }
+    }
+    front.swap(next);
+  }
+}
+
+
+} // namespace LinearFixedBoundarySurfaceMapperUtils
+using namespace LinearFixedBoundarySurfaceMapperUtils;
+
+
 // =============================================================================
 // Construction/destruction
 // =============================================================================
@@ -41,12 +181,21 @@ namespace mirtk {
 void LinearFixedBoundarySurfaceMapper
 ::CopyAttributes(const LinearFixedBoundarySurfaceMapper &other)
 {
+  _LinearSolver       = other._LinearSolver;
+  _Preconditioner     = other._Preconditioner;
   _NumberOfIterations = other._NumberOfIterations;
   _Tolerance          = other._Tolerance;
+  _MixedPrecision     = other._MixedPrecision;
+  _InitialGuess       = other._InitialGuess;
+  _NumberOfLevels     = other._NumberOfLevels;
+  _LevelReduction     = other._LevelReduction;
   _PointIndex         = other._PointIndex;
   _FreePoints         = other._FreePoints;
   _FixedPoints        = other._FixedPoints;
 
+  _NumberOfSmoothingIterations = other._NumberOfSmoothingIterations;
+  _CacheSparseSystem           = other._CacheSparseSystem;
+
   if (other._Values) {
     _Values.TakeReference(other._Values->NewInstance());
     _Values->DeepCopy(other._Values);
@@ -58,8 +207,15 @@ void LinearFixedBoundarySurfaceMapper
 // -----------------------------------------------------------------------------
 LinearFixedBoundarySurfaceMapper::LinearFixedBoundarySurfaceMapper()
 :
+  _LinearSolver(LinearSolver_Default),
+  _Preconditioner(Preconditioner_Default),
   _NumberOfIterations(-1),
-  _Tolerance(-1.0)
+  _Tolerance(-1.0),
+  _MixedPrecision(false),
+  _NumberOfLevels(1),
+  _LevelReduction(.75),
+  _NumberOfSmoothingIterations(20),
+  _CacheSparseSystem(true)
 {
 }
 
@@ -88,10 +244,124 @@ LinearFixedBoundarySurfaceMapper::~LinearFixedBoundarySurfaceMapper()
 {
 }
 
+// -----------------------------------------------------------------------------
+LinearFixedBoundarySurfaceMapper *LinearFixedBoundarySurfaceMapper::NewCopy() const
+{
+  return nullptr;
+}
+
 // =============================================================================
 // Execution
 // =============================================================================
 
+// -----------------------------------------------------------------------------
+bool LinearFixedBoundarySurfaceMapper::GetBoundaryPointIds(Array<vtkIdType> &ids) const
+{
+  vtkDataSet   * const domain = _Input->Domain();
+  vtkDataArray * const values = _Input->Values();
+  if (!domain || !values || values->GetNumberOfComponents() != this->NumberOfComponents()) {
+    return false;
+  }
+  vtkDataArray * const surfPtIds = domain->GetPointData()->GetArray("SurfacePointIds");
+  if (!surfPtIds || surfPtIds->GetNumberOfTuples() != domain->GetNumberOfPoints()) {
+    return false;
+  }
+  const vtkIdType npoints = _Surface->GetNumberOfPoints();
+  double p[3], q[3];
+  ids.assign(static_cast<size_t>(npoints), -1);
+  for (vtkIdType i = 0; i < domain->GetNumberOfPoints(); ++i) {
+    vtkIdType ptId = static_cast<vtkIdType>(surfPtIds->GetComponent(i, 0));
+    if (ptId < 0 || ptId >= npoints) return false;
+    ptId = static_cast<vtkIdType>(ReorderedPointId(static_cast<int>(ptId)));
+    // Boundary map may have been computed for another surface
+    domain  ->GetPoint(i,    p);
+    _Surface->GetPoint(ptId, q);
+    if (p[0] != q[0] || p[1] != q[1] || p[2] != q[2]) return false;
+    ids[ptId] = i;
+  }
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+void LinearFixedBoundarySurfaceMapper
+::GetSparsityPattern(Array<int> &offsets, Array<int> &indices) const
+{
+  const int n = NumberOfFreePoints();
+
+  int        d_i, c;
+  const int *j;
+
+  // Count non-zero entries of each column
+  offsets.resize(n + 1);
+  offsets[0] = 0;
+  for (int r = 0; r < n; ++r) {
+    _EdgeTable->GetAdjacentPoints(FreePointId(r), d_i, j);
+    int nnz = 1;
+    for (int k = 0; k < d_i; ++k) {
+      if (IsFreePoint(j[k])) ++nnz;
+    }
+    offsets[r + 1] = offsets[r] + nnz;
+  }
+
+  // Insert row indices of non-zero entries in ascending order
+  indices.resize(offsets[n]);
+  for (c = 0; c < n; ++c) {
+    int * const begin = indices.data() + offsets[c];
+    int *       idx   = begin;
+    *idx++ = c;
+    _EdgeTable->GetAdjacentPoints(FreePointId(c), d_i, j);
+    for (int k = 0; k < d_i; ++k) {
+      const int r = FreePointIndex(j[k]);
+      if (r >= 0) *idx++ = r;
+    }
+    sort(begin, idx);
+  }
+}
+
+// -----------------------------------------------------------------------------
+int LinearFixedBoundarySurfaceMapper::NumberOfNonZeros() const
+{
+  const int n = NumberOfFreePoints();
+
+  int        d_i;
+  const int *j;
+
+  int nnz = n;
+  for (int r = 0; r < n; ++r) {
+    _EdgeTable->GetAdjacentPoints(FreePointId(r), d_i, j);
+    for (int k = 0; k < d_i; ++k) {
+      if (IsFreePoint(j[k])) ++nnz;
+    }
+  }
+  return nnz;
+}
+
+// -----------------------------------------------------------------------------
+size_t LinearFixedBoundarySurfaceMapper::TopologyStamp() const
+{
+  // Surface set by user, the reordered surface is a new mesh each time
+  vtkPolyData  * const surface = (_InputSurface ? _InputSurface.GetPointer() : _Surface.GetPointer());
+  vtkCellArray * const polys   = surface->GetPolys();
+
+  const unsigned long long stamp[4] = {
+    static_cast<unsigned long long>(surface->GetNumberOfPoints()),
+    static_cast<unsigned long long>(surface->GetNumberOfCells()),
+    static_cast<unsigned long long>(reinterpret_cast<size_t>(polys)),
+    static_cast<unsigned long long>(polys->GetMTime())
+  };
+  return SparseSystemCache::Hash(stamp, 4);
+}
+
+// -----------------------------------------------------------------------------
+SharedPtr<SparseSystemCache::Entry>
+LinearFixedBoundarySurfaceMapper::GetSparseSystemCacheEntry() const
+{
+  if (!_CacheSparseSystem) {
+    return NewShared<SparseSystemCache::Entry>(size_t(0), NumberOfFreePoints(), NumberOfNonZeros(), _PointIndex);
+  }
+  return SparseSystemCache::Get(TopologyStamp(), NumberOfFreePoints(), NumberOfNonZeros(), _PointIndex);
+}
+
 // -----------------------------------------------------------------------------
 void LinearFixedBoundarySurfaceMapper::Initialize()
 {
@@ -118,29 +388,152 @@ void LinearFixedBoundarySurfaceMapper::Initialize()
   _Values->SetNumberOfComponents(dim);
   _Values->SetNumberOfTuples(static_cast<vtkIdType>(num));
 
+  _FreePoints .clear();
+  _FixedPoints.clear();
   _FreePoints .reserve(num);
   _FixedPoints.reserve(num);
   _PointIndex .resize (num);
 
   double p[3], *v = reinterpret_cast<double *>(_Values->GetVoidPointer(0));
-  for (int i = 0; i < num; ++i, v += dim) {
-    _Surface->GetPoint(static_cast<vtkIdType>(i), p);
-    if (_Input->Evaluate(v, p)) {
-      _PointIndex[i] = -(static_cast<int>(_FixedPoints.size()) + 1);
-      _FixedPoints.push_back(i);
-    } else {
-      _PointIndex[i] = static_cast<int>(_FreePoints.size());
-      _FreePoints.push_back(i);
+
+  // Get boundary map values directly by surface point ID if possible
+  Array<vtkIdType> fixedIds;
+  if (GetBoundaryPointIds(fixedIds)) {
+    vtkDataArray * const values = _Input->Values();
+    for (int i = 0; i < num; ++i, v += dim) {
+      if (fixedIds[i] >= 0) {
+        values->GetTuple(fixedIds[i], v);
+        _PointIndex[i] = -(static_cast<int>(_FixedPoints.size()) + 1);
+        _FixedPoints.push_back(i);
+      } else {
+        for (int j = 0; j < dim; ++j) v[j] = _Input->OutsideValue();
+        _PointIndex[i] = static_cast<int>(_FreePoints.size());
+        _FreePoints.push_back(i);
+      }
+    }
+  } else {
+    for (int i = 0; i < num; ++i, v += dim) {
+      _Surface->GetPoint(static_cast<vtkIdType>(i), p);
+      if (_Input->Evaluate(v, p)) {
+        _PointIndex[i] = -(static_cast<int>(_FixedPoints.size()) + 1);
+        _FixedPoints.push_back(i);
+      } else {
+        _PointIndex[i] = static_cast<int>(_FreePoints.size());
+        _FreePoints.push_back(i);
+      }
     }
   }
 
   _FixedPoints.shrink_to_fit();
   _FreePoints .shrink_to_fit();
+
+  // Initial guess of free map values used by iterative solver
+  SparseLinearSolver solver(_LinearSolver);
+  solver.MaxNumberOfIterations(_NumberOfIterations);
+  if (solver.IsIterative()) {
+    vtkSmartPointer<vtkDataArray> guess;
+    if (_NumberOfLevels > 1) guess = ComputeInitialGuess();
+    if (!guess) guess = _InitialGuess;
+    if (guess) {
+      // Initial guess of user is given in input surface point order
+      if (_Reordering && guess == _InitialGuess &&
+          guess->GetNumberOfTuples() == static_cast<vtkIdType>(num)) {
+        guess = _Reordering->ApplyPointOrder(guess);
+      }
+      if (guess->GetNumberOfTuples() != static_cast<vtkIdType>(num) ||
+          guess->GetNumberOfComponents() != dim) {
+        cerr << this->NameOfType() << "::Initialize: Initial guess must have one tuple per surface point"
+                                      " and " << dim << " component(s)" << endl;
+        exit(1);
+      }
+      for (int r = 0; r < NumberOfFreePoints(); ++r) {
+        const int i = FreePointId(r);
+        for (int j = 0; j < dim; ++j) {
+          _Values->SetComponent(i, j, guess->GetComponent(i, j));
+        }
+      }
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+vtkSmartPointer<vtkDataArray> LinearFixedBoundarySurfaceMapper::ComputeInitialGuess() const
+{
+  // Mapper used to solve for map of each level
+  UniquePtr<LinearFixedBoundarySurfaceMapper> mapper(this->NewCopy());
+  if (!mapper) return nullptr;
+  mapper->NumberOfLevels(1);
+  mapper->Ordering(MeshOrdering_None);
+  mapper->_CacheSparseSystem = false;
+
+  // Build multiresolution hierarchy of surface meshes
+  Array<vtkSmartPointer<vtkPolyData> > surfaces;
+  surfaces.push_back(_Surface);
+  for (int l = 1; l < _NumberOfLevels; ++l) {
+    vtkPolyData * const fine = surfaces.back();
+    vtkSmartPointer<vtkPolyData> coarse = Decimate(fine, _LevelReduction);
+    if (coarse->GetNumberOfPoints() < _MinNumberOfLevelPoints ||
+        coarse->GetNumberOfPoints() >= fine->GetNumberOfPoints()) {
+      break;
+    }
+    surfaces.push_back(coarse);
+  }
+  const int nlevels = static_cast<int>(surfaces.size());
+  if (nlevels < 2) return nullptr;
+
+  // Solve for map of each level from coarse to fine except the finest
+  vtkSmartPointer<vtkDataArray> values;
+  for (int l = nlevels - 1; l > 0; --l) {
+    if (l == nlevels - 1 || _NumberOfSmoothingIterations > 0) {
+      if (l == nlevels - 1) {
+        mapper->LinearSolver(LinearSolver_Default);
+        mapper->NumberOfIterations(-1);
+        mapper->InitialGuess(nullptr);
+      } else {
+        mapper->LinearSolver(_LinearSolver);
+        mapper->NumberOfIterations(_NumberOfSmoothingIterations);
+        mapper->InitialGuess(values);
+      }
+      mapper->Surface(surfaces[l]);
+      mapper->EdgeTable(nullptr);
+      mapper->Boundary(nullptr);
+      if (verbose) {
+        cout << "\n  Multiresolution level        = " << l;
+        cout << "\n  No. of level points          = " << surfaces[l]->GetNumberOfPoints();
+        cout.flush();
+      }
+      mapper->Run();
+      values = mapper->_Values;
+    }
+
+    // Interpolate map values at points of next finer level
+    vtkPolyData * const fine = surfaces[l-1];
+    SharedPtr<mirtk::EdgeTable> edges = _EdgeTable;
+    if (l > 1) edges = NewShared<mirtk::EdgeTable>(fine);
+    vtkSmartPointer<vtkDataArray> finer;
+    finer.TakeReference(values->NewInstance());
+    finer->SetName(values->GetName());
+    finer->SetNumberOfComponents(values->GetNumberOfComponents());
+    finer->SetNumberOfTuples(fine->GetNumberOfPoints());
+    Prolongate(values, surfaces[l]->GetPointData()->GetArray(_FinePointIdsName), *edges, finer);
+    values = finer;
+  }
+
+  if (verbose) {
+    cout << "\n  Multiresolution level        = 0";
+    cout.flush();
+  }
+  return values;
 }
 
 // -----------------------------------------------------------------------------
 void LinearFixedBoundarySurfaceMapper::Finalize()
 {
+  // Convert IDs of points back to IDs of input surface points
+  OriginalPointIds(_FixedPoints);
+  OriginalPointIds(_FreePoints);
+  RestorePointOrder(_PointIndex);
+
   // Assemble surface map
   SharedPtr<PiecewiseLinearMap> map = NewShared<PiecewiseLinearMap>();
   vtkSmartPointer<vtkPolyData> domain;
@@ -154,6 +547,9 @@ void LinearFixedBoundarySurfaceMapper::Finalize()
 
   // Finalize base class
   FixedBoundarySurfaceMapper::Finalize();
+
+  // Map values in input point order
+  _Values = map->Values();
 }
 
 
@@ -23,6 +23,7 @@
 #include "mirtk/Parallel.h"
 #include "mirtk/Matrix3x3.h"
 #include "mirtk/VtkMath.h"
+#include "mirtk/SparseLinearSolver.h"
 
 #include "vtkSmartPointer.h"
 #include "vtkPointSet.h"
@@ -31,7 +32,6 @@
 #include "vtkTetra.h"
 
 #include "Eigen/SparseCore"
-#include "Eigen/IterativeLinearSolvers"
 
 
 namespace mirtk {
@@ -205,8 +205,11 @@ using namespace LinearTetrahedralMeshMapperUtils;
 void LinearTetrahedralMeshMapper
 ::CopyAttributes(const LinearTetrahedralMeshMapper &other)
 {
+  _LinearSolver       = other._LinearSolver;
+  _Preconditioner     = other._Preconditioner;
   _NumberOfIterations = other._NumberOfIterations;
   _Tolerance          = other._Tolerance;
+  _MixedPrecision     = other._MixedPrecision;
   _RelaxationFactor   = other._RelaxationFactor;
   _InteriorPointId    = other._InteriorPointId;
   _InteriorPointPos   = other._InteriorPointPos;
@@ -215,8 +218,11 @@ void LinearTetrahedralMeshMapper
 // -----------------------------------------------------------------------------
 LinearTetrahedralMeshMapper::LinearTetrahedralMeshMapper()
 :
+  _LinearSolver(LinearSolver_Default),
+  _Preconditioner(Preconditioner_Default),
   _NumberOfIterations(0),
   _Tolerance(.0),
+  _MixedPrecision(false),
   _RelaxationFactor(1.0)
 {
 }
@@ -305,7 +311,6 @@ void LinearTetrahedralMeshMapper
   typedef double                                   Scalar;
   typedef Eigen::Matrix<Scalar, Eigen::Dynamic, 1> Vector;
   typedef Eigen::SparseMatrix<Scalar>              Matrix;
-  typedef Eigen::DiagonalPreconditioner<Scalar>    Preconditioner;
 
   const int dim = 3;                             // Dimension of output domain
   const int n   = dim * _NumberOfInteriorPoints; // Size of linear system
@@ -327,16 +332,28 @@ void LinearTetrahedralMeshMapper
   if (verbose) cout << " done" << endl;
 
   // Solve linear system
-  if (verbose) cout << "Solve system using conjugate gradient...", cout.flush();
-  Eigen::ConjugateGradient<Matrix, Eigen::Upper|Eigen::Lower, Preconditioner> solver(A);
-  if (_NumberOfIterations >  0) solver.setMaxIterations(_NumberOfIterations);
-  if (_Tolerance          > .0) solver.setTolerance(_Tolerance);
-  x = solver.solveWithGuess(b, x);
+  SparseLinearSolver solver(_LinearSolver, true);
+  if (_LinearSolver == LinearSolver_Default) solver.Type(LinearSolver_CG);
+  solver.Preconditioner(_Preconditioner);
+  solver.MaxNumberOfIterations(_NumberOfIterations);
+  solver.Tolerance(_Tolerance);
+  solver.MixedPrecision(_MixedPrecision);
+  if (verbose) cout << "Solve system using " << ToString(solver.SolverType()) << " solver...", cout.flush();
+  if (!solver.Solve(A, b, x)) {
+    cerr << this->NameOfType() << "::Solve: Failed to solve linear system" << endl;
+    exit(1);
+  }
   if (verbose) {
     cout << " done" << endl;
-    cout << "\nNo. of iterations = " << solver.iterations();
-    cout << "\nEstimated error   = " << solver.error();
-    cout << endl;
+    if (IsIterativeLinearSolver(solver.UsedType())) {
+      cout << "\nNo. of iterations = " << solver.NumberOfIterations();
+      cout << "\nEstimated error   = " << solver.Error();
+      cout << endl;
+    } else if (solver.MixedPrecision()) {
+      cout << "\nRefinement steps  = " << solver.NumberOfIterations();
+      cout << "\nEstimated error   = " << solver.Error();
+      cout << endl;
+    }
   }
 
   // Update parameterization of interior points
@@ -23,8 +23,8 @@
 #include "mirtk/Math.h"
 #include "mirtk/Memory.h"
 #include "mirtk/Cfstream.h"
-#include "mirtk/BaseImage.h"
-#include "mirtk/VoxelFunction.h"
+#include "mirtk/Parallel.h"
+#include "mirtk/GenericImage.h"
 #include "mirtk/PointSetUtils.h"
 
 #include "vtkSmartPointer.h"
@@ -77,44 +77,63 @@ namespace MappingUtils {
 
 
 // -----------------------------------------------------------------------------
-/// Evaluate map at lattice points
-class EvaluateMap : public VoxelFunction
+/// Evaluate map at lattice points, one row of voxels at a time
+template <class TVoxel>
+class EvaluateMap
 {
-  const Mapping   *_Map;
-  vtkImageData    *_Domain;
-  const BaseImage *_Output;
-  const int        _NumberOfVoxels;
-  const int        _l1, _l2;
+  const Mapping        *_Map;
+  vtkImageData         *_Domain;
+  GenericImage<TVoxel> *_Output;
+  const int             _l1, _l2;
 
 public:
 
-  EvaluateMap(const Mapping   *map,
-              vtkImageData    *domain,
-              const BaseImage *output,
+  EvaluateMap(const Mapping        *map,
+              vtkImageData         *domain,
+              GenericImage<TVoxel> *output,
               int l1, int l2)
   :
     _Map(map),
     _Domain(domain),
     _Output(output),
-    _NumberOfVoxels(output->NumberOfSpatialVoxels()),
     _l1(l1), _l2(l2)
   {}
 
-  template <class T>
-  void operator ()(int i, int j, int k, int, T *v) const
+  void operator ()(const blocked_range<int> &rows) const
   {
-    if (!_Domain || _Domain->GetScalarComponentAsFloat(i, j, k, 0) != .0) {
-      double x = i, y = j, z = k;
-      _Output->ImageToWorld(x, y, z);
-      double *f = new double[_Map->NumberOfComponents()];
-      _Map->Evaluate(f, x, y, z);
-      for (int l = _l1; l < _l2; ++l, v += _NumberOfVoxels) {
-        *v = f[l];
+    const int    nx  = _Output->X();
+    const int    ny  = _Output->Y();
+    const int    dim = _Map->NumberOfComponents();
+    const TVoxel nan = numeric_limits<TVoxel>::quiet_NaN();
+
+    Array<double> x(nx), y(nx), z(nx), f(nx * dim);
+    Array<int>    idx(nx);
+
+    int i, j, k, n;
+    for (int r = rows.begin(); r != rows.end(); ++r) {
+      j = r % ny;
+      k = r / ny;
+      n = 0;
+      for (i = 0; i < nx; ++i) {
+        if (!_Domain || _Domain->GetScalarComponentAsFloat(i, j, k, 0) != .0) {
+          x[n] = i, y[n] = j, z[n] = k;
+          _Output->ImageToWorld(x[n], y[n], z[n]);
+          idx[n] = i;
+          ++n;
+        } else {
+          for (int l = _l1; l < _l2; ++l) {
+            _Output->Put(i, j, k, l - _l1, nan);
+          }
+        }
       }
-      delete[] f;
-    } else {
-      for (int l = _l1; l < _l2; ++l, v += _NumberOfVoxels) {
-        *v = numeric_limits<T>::quiet_NaN();
+      if (n > 0) {
+        _Map->Evaluate(f.data(), n, x.data(), y.data(), z.data());
+        for (int l = _l1; l < _l2; ++l) {
+          const double *v = f.data() + l * n;
+          for (i = 0; i < n; ++i) {
+            _Output->Put(idx[i], j, k, l - _l1, static_cast<TVoxel>(v[i]));
+          }
+        }
       }
     }
   }
@@ -257,6 +276,27 @@ ImageAttributes Mapping::Attributes(double dx, double dy, double dz) const
 // Evaluation
 // =============================================================================
 
+// -----------------------------------------------------------------------------
+int Mapping::Evaluate(double *v, int n, const double *x, const double *y,
+                      const double *z, bool *inside) const
+{
+  const int dim = this->NumberOfComponents();
+  double    buf[3];
+  double   *f = (dim <= 3 ? buf : new double[dim]);
+  bool      is_inside;
+  int       count = 0;
+  for (int i = 0; i < n; ++i) {
+    is_inside = this->Evaluate(f, x[i], y[i], z ? z[i] : .0);
+    for (int l = 0; l < dim; ++l) {
+      v[l * n + i] = f[l];
+    }
+    if (inside) inside[i] = is_inside;
+    if (is_inside) ++count;
+  }
+  if (f != buf) delete[] f;
+  return count;
+}
+
 // -----------------------------------------------------------------------------
 void Mapping::Evaluate(GenericImage<float> &f, int l, vtkSmartPointer<vtkPointSet> m) const
 {
@@ -274,7 +314,8 @@ void Mapping::Evaluate(GenericImage<float> &f, int l, vtkSmartPointer<vtkPointSe
     ImageStencilToMask(ImageStencil(mask, WorldToImage(m, &f)), mask);
   }
 
-  ParallelForEachVoxel(EvaluateMap(this, mask, &f, l, l + lattice._t), lattice, f);
+  EvaluateMap<float> eval(this, mask, &f, l, l + lattice._t);
+  parallel_for(blocked_range<int>(0, lattice._y * lattice._z), eval);
 }
 
 // -----------------------------------------------------------------------------
@@ -294,7 +335,8 @@ void Mapping::Evaluate(GenericImage<double> &f, int l, vtkSmartPointer<vtkPointS
     ImageStencilToMask(ImageStencil(mask, WorldToImage(m, &f)), mask);
   }
 
-  ParallelForEachVoxel(EvaluateMap(this, mask, &f, l, l + lattice._t), lattice, f);
+  EvaluateMap<double> eval(this, mask, &f, l, l + lattice._t);
+  parallel_for(blocked_range<int>(0, lattice._y * lattice._z), eval);
 }
 
 // =============================================================================
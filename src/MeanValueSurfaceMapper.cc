@@ -22,6 +22,7 @@
 #include "mirtk/Math.h"
 #include "mirtk/VtkMath.h"
 #include "mirtk/PointSetUtils.h"
+#include "mirtk/EdgeTable.h"
 
 #include "vtkSmartPointer.h"
 #include "vtkIdList.h"
@@ -68,6 +69,12 @@ MeanValueSurfaceMapper::~MeanValueSurfaceMapper()
 {
 }
 
+// -----------------------------------------------------------------------------
+LinearFixedBoundarySurfaceMapper *MeanValueSurfaceMapper::NewCopy() const
+{
+  return new MeanValueSurfaceMapper(*this);
+}
+
 // =============================================================================
 // Execution
 // =============================================================================
@@ -75,40 +82,78 @@ MeanValueSurfaceMapper::~MeanValueSurfaceMapper()
 // -----------------------------------------------------------------------------
 // The following uses the equality tan(alpha/2) = (1 - cos(alpha)) / sin(alpha)
 // to compute the required tangens weights using only inner and outer vector products
-double MeanValueSurfaceMapper::Weight(int i, int j) const
+void MeanValueSurfaceMapper::EdgeWeights(const double a[3], const double b[3],
+                                         const double c[3], const double *d, double w[2])
 {
-  double a[3], b[3], c[3], ab[3], ac[3], n[3], d_ab, d_ac, n_norm, w;
-
-  int k, l;
-  if (GetEdgeNeighborPoints(i, j, k, l) > 2 || k < 0) {
-    cerr << this->NameOfType() << "::Weight: Surface mesh must be triangulated!" << endl;
-    exit(1);
-  }
+  double ab[3], ac[3], bc[3], n[3], d_ab, d_ac, d_bc, n_norm;
 
-  _Surface->GetPoint(static_cast<vtkIdType>(i), a);
-  _Surface->GetPoint(static_cast<vtkIdType>(j), b);
   vtkMath::Subtract(b, a, ab);
   d_ab = vtkMath::Norm(ab);
 
-  _Surface->GetPoint(static_cast<vtkIdType>(k), c);
+  // Tangents of half the angles at a and b of triangle (a, b, c), where
+  // the norm of the cross product is the same for both corners
   vtkMath::Subtract(c, a, ac);
+  vtkMath::Subtract(c, b, bc);
   vtkMath::Cross(ab, ac, n);
   d_ac   = vtkMath::Norm(ac);
+  d_bc   = vtkMath::Norm(bc);
   n_norm = vtkMath::Norm(n);
+  w[0] = (d_ab * d_ac - vtkMath::Dot(ab, ac)) / n_norm;
+  w[1] = (d_ab * d_bc + vtkMath::Dot(ab, bc)) / n_norm;
 
-  w = (d_ab * d_ac - vtkMath::Dot(ab, ac)) / n_norm;
-
-  if (l >= 0) {
-    _Surface->GetPoint(static_cast<vtkIdType>(l), c);
-    vtkMath::Subtract(c, a, ac);
+  if (d) {
+    vtkMath::Subtract(d, a, ac);
+    vtkMath::Subtract(d, b, bc);
     vtkMath::Cross(ab, ac, n);
     d_ac   = vtkMath::Norm(ac);
+    d_bc   = vtkMath::Norm(bc);
     n_norm = vtkMath::Norm(n);
-    w += (d_ab * d_ac - vtkMath::Dot(ab, ac)) / n_norm;
+    w[0] += (d_ab * d_ac - vtkMath::Dot(ab, ac)) / n_norm;
+    w[1] += (d_ab * d_bc + vtkMath::Dot(ab, bc)) / n_norm;
   }
 
-  return w / d_ab;
+  w[0] /= d_ab;
+  w[1] /= d_ab;
 }
 
+// -----------------------------------------------------------------------------
+void MeanValueSurfaceMapper::ComputeWeights(Array<double> &w) const
+{
+  CheckTriangulated("ComputeWeights");
+
+  double a[3], b[3], c[3], d[3];
+  int    i, j, edgeId;
+
+  w.resize(2 * _EdgeTable->NumberOfEdges());
+  EdgeIterator edgeIt(*_EdgeTable);
+  for (edgeIt.InitTraversal(); (edgeId = edgeIt.GetNextEdge(i, j)) != -1;) {
+    const int * const entry = _EdgeNeighborPoints.data() + 3 * edgeId;
+    _Surface->GetPoint(static_cast<vtkIdType>(min(i, j)), a);
+    _Surface->GetPoint(static_cast<vtkIdType>(max(i, j)), b);
+    _Surface->GetPoint(static_cast<vtkIdType>(entry[1]), c);
+    if (entry[2] >= 0) _Surface->GetPoint(static_cast<vtkIdType>(entry[2]), d);
+    EdgeWeights(a, b, c, entry[2] >= 0 ? d : nullptr, w.data() + 2 * edgeId);
+  }
+}
+
+// -----------------------------------------------------------------------------
+double MeanValueSurfaceMapper::Weight(int i, int j) const
+{
+  double a[3], b[3], c[3], d[3], w[2];
+
+  int k, l;
+  if (GetEdgeNeighborPoints(i, j, k, l) > 2 || k < 0) {
+    cerr << this->NameOfType() << "::Weight: Surface mesh must be triangulated!" << endl;
+    exit(1);
+  }
+
+  _Surface->GetPoint(static_cast<vtkIdType>(i), a);
+  _Surface->GetPoint(static_cast<vtkIdType>(j), b);
+  _Surface->GetPoint(static_cast<vtkIdType>(k), c);
+  if (l >= 0) _Surface->GetPoint(static_cast<vtkIdType>(l), d);
+  EdgeWeights(a, b, c, l >= 0 ? d : nullptr, w);
+
+  return w[0];
+}
 
 } // namespace mirtk
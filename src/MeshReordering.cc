@@ -0,0 +1,485 @@
+/*
+ * Medical Image Registration ToolKit (MIRTK)
+ *
+ * Copyright 2013-2016 Imperial College London
+ * Copyright 2013-2016 Andreas Schuh
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mirtk/MeshReordering.h"
+
+#include "mirtk/Pair.h"
+#include "mirtk/Algorithm.h"
+
+#include "vtkNew.h"
+#include "vtkIdList.h"
+#include "vtkPoints.h"
+#include "vtkCellType.h"
+#include "vtkPointData.h"
+#include "vtkCellData.h"
+#include "vtkFieldData.h"
+#include "vtkAbstractArray.h"
+#include "vtkDataSetAttributes.h"
+#include "vtkPolyData.h"
+#include "vtkUnstructuredGrid.h"
+
+
+namespace mirtk {
+
+
+// =============================================================================
+// Auxiliaries
+// =============================================================================
+
+namespace MeshReorderingUtils {
+
+
+/// Maximum number of breadth-first searches to find a pseudo-peripheral point
+const int _MaxPseudoPeripheralIterations = 10;
+
+// -----------------------------------------------------------------------------
+/// Build adjacency lists of points connected by an edge of a mesh cell
+///
+/// The neighbors of point i are adj[offsets[i]] to adj[offsets[i+1]-1].
+void GetPointGraph(vtkPointSet *mesh, Array<int> &offsets, Array<int> &adj)
+{
+  const int n = static_cast<int>(mesh->GetNumberOfPoints());
+  Array<Pair<int, int> > edges;
+  vtkNew<vtkIdList> ptIds;
+  int i, j;
+  for (vtkIdType cellId = 0; cellId < mesh->GetNumberOfCells(); ++cellId) {
+    mesh->GetCellPoints(cellId, ptIds.GetPointer());
+    for (vtkIdType a = 0; a < ptIds->GetNumberOfIds(); ++a)
+    for (vtkIdType b = a + 1; b < ptIds->GetNumberOfIds(); ++b) {
+      i = static_cast<int>(ptIds->GetId(a));
+      j = static_cast<int>(ptIds->GetId(b));
+      if (i != j) {
+        edges.push_back(Pair<int, int>(i, j));
+        edges.push_back(Pair<int, int>(j, i));
+      }
+    }
+  }
+  sort(edges.begin(), edges.end());
+  edges.erase(unique(edges.begin(), edges.end()), edges.end());
+  offsets.resize(n + 1);
+  adj.resize(edges.size());
+  size_t k = 0;
+  for (i = 0; i < n; ++i) {
+    offsets[i] = static_cast<int>(k);
+    while (k < edges.size() && edges[k].first == i) {
+      adj[k] = edges[k].second;
+      ++k;
+    }
+  }
+  offsets[n] = static_cast<int>(k);
+}
+
+// -----------------------------------------------------------------------------
+/// Breadth-first search of connected component containing start point
+///
+/// \param[in]     start   Start point.
+/// \param[in]     offsets Offsets of adjacency lists.
+/// \param[in]     adj     Adjacency lists.
+/// \param[in,out] dist    Distance of points to start point. Must be -1 for
+///                        all points of the component on input.
+/// \param[out]    queue   Points of the component in breadth-first order.
+///
+/// \returns Eccentricity of start point, i.e., distance of last level.
+int BreadthFirstSearch(int start, const Array<int> &offsets, const Array<int> &adj,
+                       Array<int> &dist, Array<int> &queue)
+{
+  queue.clear();
+  queue.push_back(start);
+  dist[start] = 0;
+  for (size_t q = 0; q < queue.size(); ++q) {
+    const int i = queue[q];
+    for (int k = offsets[i]; k < offsets[i+1]; ++k) {
+      if (dist[adj[k]] < 0) {
+        dist[adj[k]] = dist[i] + 1;
+        queue.push_back(adj[k]);
+      }
+    }
+  }
+  return dist[queue.back()];
+}
+
+// -----------------------------------------------------------------------------
+/// Find pseudo-peripheral point of connected component (George and Liu, 1979)
+int PseudoPeripheralPoint(int start, const Array<int> &offsets, const Array<int> &adj,
+                          Array<int> &dist, Array<int> &queue)
+{
+  int root = start;
+  int ecc  = BreadthFirstSearch(root, offsets, adj, dist, queue);
+  for (int iter = 0; iter < _MaxPseudoPeripheralIterations; ++iter) {
+    // Point of minimum degree in last level
+    int next = -1, degree, min_degree = 0;
+    for (size_t q = 0; q < queue.size(); ++q) {
+      const int i = queue[q];
+      if (dist[i] == ecc) {
+        degree = offsets[i+1] - offsets[i];
+        if (next == -1 || degree < min_degree) {
+          next       = i;
+          min_degree = degree;
+        }
+      }
+    }
+    for (size_t q = 0; q < queue.size(); ++q) dist[queue[q]] = -1;
+    const int next_ecc = BreadthFirstSearch(next, offsets, adj, dist, queue);
+    if (next_ecc <= ecc) break;
+    root = next;
+    ecc  = next_ecc;
+  }
+  for (size_t q = 0; q < queue.size(); ++q) dist[queue[q]] = -1;
+  return root;
+}
+
+// -----------------------------------------------------------------------------
+/// Insert two zero bits between each of the lower 10 bits of an integer
+inline unsigned int SpreadBits(unsigned int v)
+{
+  v &= 0x000003FFu;
+  v = (v | (v << 16)) & 0xFF0000FFu;
+  v = (v | (v <<  8)) & 0x0300F00Fu;
+  v = (v | (v <<  4)) & 0x030C30C3u;
+  v = (v | (v <<  2)) & 0x09249249u;
+  return v;
+}
+
+// -----------------------------------------------------------------------------
+/// Rank of cell type in the cell order of vtkPolyData
+///
+/// The cells of a vtkPolyData are numbered by type, i.e., vertices first,
+/// followed by lines, polygons, and triangle strips.
+int PolyDataCellTypeRank(int type)
+{
+  switch (type) {
+    case VTK_VERTEX:
+    case VTK_POLY_VERTEX:     return 0;
+    case VTK_LINE:
+    case VTK_POLY_LINE:       return 1;
+    case VTK_TRIANGLE_STRIP:  return 3;
+    default:                  return 2;
+  }
+}
+
+// -----------------------------------------------------------------------------
+/// Copy data arrays with permuted tuples
+///
+/// \param[in]  in  Input data arrays.
+/// \param[out] out Output data arrays.
+/// \param[in]  ids Input tuple index of each output tuple.
+void PermuteData(vtkDataSetAttributes *in, vtkDataSetAttributes *out, const Array<int> &ids)
+{
+  const vtkIdType n = static_cast<vtkIdType>(ids.size());
+  out->Initialize();
+  for (int i = 0; i < in->GetNumberOfArrays(); ++i) {
+    vtkAbstractArray *array = in->GetAbstractArray(i);
+    vtkSmartPointer<vtkAbstractArray> copy;
+    copy.TakeReference(array->NewInstance());
+    copy->SetName(array->GetName());
+    copy->SetNumberOfComponents(array->GetNumberOfComponents());
+    copy->SetNumberOfTuples(n);
+    for (vtkIdType id = 0; id < n; ++id) {
+      copy->SetTuple(id, static_cast<vtkIdType>(ids[id]), array);
+    }
+    out->AddArray(copy);
+  }
+  for (int attr = 0; attr < vtkDataSetAttributes::NUM_ATTRIBUTES; ++attr) {
+    vtkAbstractArray *array = in->GetAbstractAttribute(attr);
+    for (int i = 0; array && i < in->GetNumberOfArrays(); ++i) {
+      if (in->GetAbstractArray(i) == array) {
+        out->SetActiveAttribute(i, attr);
+        break;
+      }
+    }
+  }
+}
+
+
+} // namespace MeshReorderingUtils
+using namespace MeshReorderingUtils;
+
+// =============================================================================
+// Construction/destruction
+// =============================================================================
+
+// -----------------------------------------------------------------------------
+void MeshReordering::CopyAttributes(const MeshReordering &other)
+{
+  _Input             = other._Input;
+  _Ordering          = other._Ordering;
+  _Output            = other._Output;
+  _OriginalPointIds  = other._OriginalPointIds;
+  _ReorderedPointIds = other._ReorderedPointIds;
+  _OriginalCellIds   = other._OriginalCellIds;
+  _ReorderedCellIds  = other._ReorderedCellIds;
+}
+
+// -----------------------------------------------------------------------------
+MeshReordering::MeshReordering(MeshOrdering ordering)
+:
+  _Ordering(ordering)
+{
+}
+
+// -----------------------------------------------------------------------------
+MeshReordering::MeshReordering(const MeshReordering &other)
+:
+  Object(other)
+{
+  CopyAttributes(other);
+}
+
+// -----------------------------------------------------------------------------
+MeshReordering &MeshReordering::operator =(const MeshReordering &other)
+{
+  if (this != &other) {
+    Object::operator =(other);
+    CopyAttributes(other);
+  }
+  return *this;
+}
+
+// -----------------------------------------------------------------------------
+MeshReordering::~MeshReordering()
+{
+}
+
+// =============================================================================
+// Execution
+// =============================================================================
+
+// -----------------------------------------------------------------------------
+void MeshReordering::Run()
+{
+  // Check input
+  if (!_Input) {
+    cerr << this->NameOfType() << "::Run: Missing input mesh" << endl;
+    exit(1);
+  }
+  if (!vtkPolyData::SafeDownCast(_Input) && !vtkUnstructuredGrid::SafeDownCast(_Input)) {
+    cerr << this->NameOfType() << "::Run: Input mesh must be either vtkPolyData or vtkUnstructuredGrid" << endl;
+    exit(1);
+  }
+
+  // Compute new order of points
+  const int npoints = static_cast<int>(_Input->GetNumberOfPoints());
+  switch (_Ordering) {
+    case MeshOrdering_None: {
+      _OriginalPointIds.resize(npoints);
+      for (int ptId = 0; ptId < npoints; ++ptId) {
+        _OriginalPointIds[ptId] = ptId;
+      }
+    } break;
+    case MeshOrdering_RCM: {
+      ComputeCuthillMcKeeOrder(_OriginalPointIds);
+    } break;
+    case MeshOrdering_SFC: {
+      ComputeMortonOrder(_OriginalPointIds);
+    } break;
+    default: {
+      cerr << this->NameOfType() << "::Run: Unknown mesh ordering: " << ToString(_Ordering) << endl;
+      exit(1);
+    }
+  }
+  _ReorderedPointIds.resize(npoints);
+  for (int ptId = 0; ptId < npoints; ++ptId) {
+    _ReorderedPointIds[_OriginalPointIds[ptId]] = ptId;
+  }
+
+  // Compute new order of cells
+  const int ncells = static_cast<int>(_Input->GetNumberOfCells());
+  ComputeCellOrder(_OriginalCellIds);
+  _ReorderedCellIds.resize(ncells);
+  for (int cellId = 0; cellId < ncells; ++cellId) {
+    _ReorderedCellIds[_OriginalCellIds[cellId]] = cellId;
+  }
+
+  // Create output mesh
+  CreateOutput();
+}
+
+// -----------------------------------------------------------------------------
+void MeshReordering::ComputeCuthillMcKeeOrder(Array<int> &order) const
+{
+  const int n = static_cast<int>(_Input->GetNumberOfPoints());
+
+  Array<int> offsets, adj;
+  GetPointGraph(_Input, offsets, adj);
+
+  Array<int>  dist(n, -1), queue;
+  Array<bool> visited(n, false);
+  Array<Pair<int, int> > nbrs;
+
+  order.clear();
+  order.reserve(n);
+  for (int start = 0; start < n; ++start) {
+    if (visited[start]) continue;
+    // Cuthill-McKee ordering of connected component, where the neighbors
+    // of each point are visited in order of increasing degree
+    const int root = PseudoPeripheralPoint(start, offsets, adj, dist, queue);
+    size_t q = order.size();
+    order.push_back(root);
+    visited[root] = true;
+    for (; q < order.size(); ++q) {
+      const int i = order[q];
+      nbrs.clear();
+      for (int k = offsets[i]; k < offsets[i+1]; ++k) {
+        const int j = adj[k];
+        if (!visited[j]) {
+          nbrs.push_back(Pair<int, int>(offsets[j+1] - offsets[j], j));
+          visited[j] = true;
+        }
+      }
+      sort(nbrs.begin(), nbrs.end());
+      for (size_t k = 0; k < nbrs.size(); ++k) {
+        order.push_back(nbrs[k].second);
+      }
+    }
+  }
+  reverse(order.begin(), order.end());
+}
+
+// -----------------------------------------------------------------------------
+void MeshReordering::ComputeMortonOrder(Array<int> &order) const
+{
+  const int n = static_cast<int>(_Input->GetNumberOfPoints());
+  order.resize(n);
+  if (n == 0) return;
+
+  double bounds[6], s[3], p[3];
+  _Input->GetPoints()->GetBounds(bounds);
+  for (int c = 0; c < 3; ++c) {
+    const double extent = bounds[2*c+1] - bounds[2*c];
+    s[c] = (extent > .0 ? 1023. / extent : .0);
+  }
+  Array<Pair<unsigned int, int> > code(n);
+  for (int i = 0; i < n; ++i) {
+    _Input->GetPoint(static_cast<vtkIdType>(i), p);
+    code[i].first  = (SpreadBits(static_cast<unsigned int>((p[0] - bounds[0]) * s[0]))     ) |
+                     (SpreadBits(static_cast<unsigned int>((p[1] - bounds[2]) * s[1])) << 1) |
+                     (SpreadBits(static_cast<unsigned int>((p[2] - bounds[4]) * s[2])) << 2);
+    code[i].second = i;
+  }
+  sort(code.begin(), code.end());
+  for (int i = 0; i < n; ++i) {
+    order[i] = code[i].second;
+  }
+}
+
+// -----------------------------------------------------------------------------
+void MeshReordering::ComputeCellOrder(Array<int> &order) const
+{
+  const int  n    = static_cast<int>(_Input->GetNumberOfCells());
+  const bool poly = (vtkPolyData::SafeDownCast(_Input) != nullptr);
+
+  // Sort cells by smallest new point ID, keeping cells of a vtkPolyData
+  // grouped by type such that the output cell IDs match the sorted order
+  Array<Pair<Pair<int, int>, int> > key(n);
+  vtkNew<vtkIdList> ptIds;
+  int rank, minId;
+  for (int cellId = 0; cellId < n; ++cellId) {
+    _Input->GetCellPoints(static_cast<vtkIdType>(cellId), ptIds.GetPointer());
+    rank  = (poly ? PolyDataCellTypeRank(_Input->GetCellType(cellId)) : 0);
+    minId = static_cast<int>(_ReorderedPointIds.size());
+    for (vtkIdType i = 0; i < ptIds->GetNumberOfIds(); ++i) {
+      minId = min(minId, _ReorderedPointIds[ptIds->GetId(i)]);
+    }
+    key[cellId] = Pair<Pair<int, int>, int>(Pair<int, int>(rank, minId), cellId);
+  }
+  sort(key.begin(), key.end());
+  order.resize(n);
+  for (int cellId = 0; cellId < n; ++cellId) {
+    order[cellId] = key[cellId].second;
+  }
+}
+
+// -----------------------------------------------------------------------------
+void MeshReordering::CreateOutput()
+{
+  const vtkIdType npoints = _Input->GetNumberOfPoints();
+  const vtkIdType ncells  = _Input->GetNumberOfCells();
+
+  // Permute points
+  vtkPoints *input_points = _Input->GetPoints();
+  vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+  if (input_points) points->SetDataType(input_points->GetDataType());
+  points->SetNumberOfPoints(npoints);
+  for (vtkIdType ptId = 0; ptId < npoints; ++ptId) {
+    points->SetPoint(ptId, input_points->GetPoint(_OriginalPointIds[ptId]));
+  }
+  _Output.TakeReference(_Input->NewInstance());
+  _Output->SetPoints(points);
+
+  // Permute cells and relabel their points
+  vtkPolyData         *poly = vtkPolyData::SafeDownCast(_Output);
+  vtkUnstructuredGrid *grid = vtkUnstructuredGrid::SafeDownCast(_Output);
+  if (poly) poly->Allocate(ncells);
+  else      grid->Allocate(ncells);
+  vtkNew<vtkIdList> ptIds;
+  vtkIdType cellId;
+  int       type;
+  for (vtkIdType i = 0; i < ncells; ++i) {
+    cellId = static_cast<vtkIdType>(_OriginalCellIds[i]);
+    type   = _Input->GetCellType(cellId);
+    _Input->GetCellPoints(cellId, ptIds.GetPointer());
+    for (vtkIdType j = 0; j < ptIds->GetNumberOfIds(); ++j) {
+      ptIds->SetId(j, static_cast<vtkIdType>(_ReorderedPointIds[ptIds->GetId(j)]));
+    }
+    if (poly) poly->InsertNextCell(type, ptIds.GetPointer());
+    else      grid->InsertNextCell(type, ptIds.GetPointer());
+  }
+
+  // Permute point and cell data
+  PermuteData(_Input->GetPointData(), _Output->GetPointData(), _OriginalPointIds);
+  PermuteData(_Input->GetCellData(),  _Output->GetCellData(),  _OriginalCellIds);
+  _Output->GetFieldData()->ShallowCopy(_Input->GetFieldData());
+}
+
+// =============================================================================
+// Auxiliaries
+// =============================================================================
+
+// -----------------------------------------------------------------------------
+vtkSmartPointer<vtkDataArray> MeshReordering::ApplyPointOrder(vtkDataArray *values) const
+{
+  const vtkIdType n = static_cast<vtkIdType>(_OriginalPointIds.size());
+  vtkSmartPointer<vtkDataArray> reordered;
+  reordered.TakeReference(values->NewInstance());
+  reordered->SetName(values->GetName());
+  reordered->SetNumberOfComponents(values->GetNumberOfComponents());
+  reordered->SetNumberOfTuples(n);
+  for (vtkIdType ptId = 0; ptId < n; ++ptId) {
+    reordered->SetTuple(ptId, static_cast<vtkIdType>(_OriginalPointIds[ptId]), values);
+  }
+  return reordered;
+}
+
+// -----------------------------------------------------------------------------
+vtkSmartPointer<vtkDataArray> MeshReordering::RestorePointOrder(vtkDataArray *values) const
+{
+  const vtkIdType n = static_cast<vtkIdType>(_OriginalPointIds.size());
+  vtkSmartPointer<vtkDataArray> restored;
+  restored.TakeReference(values->NewInstance());
+  restored->SetName(values->GetName());
+  restored->SetNumberOfComponents(values->GetNumberOfComponents());
+  restored->SetNumberOfTuples(n);
+  for (vtkIdType ptId = 0; ptId < n; ++ptId) {
+    restored->SetTuple(static_cast<vtkIdType>(_OriginalPointIds[ptId]), ptId, values);
+  }
+  return restored;
+}
+
+
+} // namespace mirtk
@@ -69,6 +69,10 @@ void MeshlessBiharmonicMap::Initialize()
     cerr << this->NameOfType() << "::Initialize: Number of coefficients must be twice the number of source points" << endl;
     exit(1);
   }
+
+  // Copy source points and coefficients used for direct summation
+  _Treecode      = nullptr;
+  _KernelSources = NewKernelSources();
 }
 
 // -----------------------------------------------------------------------------
@@ -82,6 +86,29 @@ MeshlessBiharmonicMap::~MeshlessBiharmonicMap()
 {
 }
 
+// =============================================================================
+// Kernel summation
+// =============================================================================
+
+// -----------------------------------------------------------------------------
+SharedPtr<MeshlessHarmonicMap::KernelSources> MeshlessBiharmonicMap::NewKernelSources() const
+{
+  SharedPtr<KernelSources> src = MeshlessHarmonicMap::NewKernelSources();
+  const int m   = src->NumberOfSources;
+  const int dim = src->NumberOfComponents;
+
+  // Copy coefficients premultiplied by constant factor of kernel function
+  src->B.resize(dim * m);
+  for (int j = 0; j < dim; ++j) {
+    const double *a = _Coefficients.RawPointer(0, j);
+    for (int k = 0; k < m; ++k) {
+      src->B[j * m + k] = B(1.) * a[k + m];
+    }
+  }
+
+  return src;
+}
+
 // =============================================================================
 // Evaluation
 // =============================================================================
@@ -117,6 +144,13 @@ bool MeshlessBiharmonicMap::Evaluate(double *v, double x, double y, double z) co
   return true;
 }
 
+// -----------------------------------------------------------------------------
+int MeshlessBiharmonicMap::Evaluate(double *v, int n, const double *x, const double *y,
+                                    const double *z, bool *inside) const
+{
+  return EvaluateKernels(v, n, x, y, z, inside, *GetKernelSources());
+}
+
 // -----------------------------------------------------------------------------
 double MeshlessBiharmonicMap::Evaluate(double x, double y, double z, int l) const
 {
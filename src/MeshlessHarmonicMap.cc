@@ -25,12 +25,380 @@
 namespace mirtk {
 
 
+// =============================================================================
+// Treecode
+// =============================================================================
+
+// -----------------------------------------------------------------------------
+struct MeshlessHarmonicMap::Treecode
+{
+  /// Node of octree
+  struct Node
+  {
+    double Center[3]; ///< Center of octree cell
+    double Radius;    ///< Maximum distance of source points from center
+    int    Begin;     ///< Index of first source point in octree cell
+    int    End;       ///< Index after last source point in octree cell
+    int    Next;      ///< Index of next node after subtree rooted at this node
+    bool   Leaf;      ///< Whether this node has no child nodes
+  };
+
+  int           NumberOfSources;    ///< Number of source points
+  int           NumberOfComponents; ///< Number of map components
+  Array<Node>   Nodes;              ///< Octree nodes in depth-first order
+  Array<double> X, Y, Z;            ///< Source points in octree order
+  Array<double> C;                  ///< Coefficients, where C[j * n + i] is j-th coefficient of i-th source
+  Array<double> Moments;            ///< Monopole and dipole moments of each node
+};
+
+namespace MeshlessHarmonicMapUtils {
+
+typedef MeshlessHarmonicMap::Treecode Treecode;
+
+/// Maximum number of source points in leaf node of octree
+const int MaxTreecodeLeafSize = 16;
+
+/// Maximum depth of octree
+const int MaxTreecodeDepth = 32;
+
+/// Number of points for which kernel functions are summed in one pass
+const int KernelBlockSize = 64;
+
+// -----------------------------------------------------------------------------
+/// Recursively subdivide octree cell
+void BuildTreecodeNode(Treecode &tree, Array<int> &order, Array<int> &tmp,
+                       const double center[3], double h, int begin, int end, int depth)
+{
+  const int index = static_cast<int>(tree.Nodes.size());
+  tree.Nodes.push_back(Treecode::Node());
+  {
+    Treecode::Node &node = tree.Nodes.back();
+    memcpy(node.Center, center, 3 * sizeof(double));
+    node.Begin  = begin;
+    node.End    = end;
+    node.Leaf   = (end - begin <= MaxTreecodeLeafSize || depth >= MaxTreecodeDepth);
+    node.Radius = .0;
+    for (int i = begin; i < end; ++i) {
+      const int k = order[i];
+      const double dx = tree.X[k] - center[0];
+      const double dy = tree.Y[k] - center[1];
+      const double dz = tree.Z[k] - center[2];
+      node.Radius = max(node.Radius, dx * dx + dy * dy + dz * dz);
+    }
+    node.Radius = sqrt(node.Radius);
+  }
+  if (!tree.Nodes[index].Leaf) {
+    // Sort source points by octant
+    int count[8] = {0}, offset[9];
+    for (int i = begin; i < end; ++i) {
+      const int k = order[i];
+      ++count[(tree.X[k] >= center[0] ? 1 : 0) |
+              (tree.Y[k] >= center[1] ? 2 : 0) |
+              (tree.Z[k] >= center[2] ? 4 : 0)];
+    }
+    offset[0] = begin;
+    for (int o = 0; o < 8; ++o) {
+      offset[o+1] = offset[o] + count[o];
+    }
+    for (int i = begin; i < end; ++i) {
+      const int k = order[i];
+      const int o = (tree.X[k] >= center[0] ? 1 : 0) |
+                    (tree.Y[k] >= center[1] ? 2 : 0) |
+                    (tree.Z[k] >= center[2] ? 4 : 0);
+      tmp[offset[o]++] = k;
+    }
+    for (int i = begin; i < end; ++i) {
+      order[i] = tmp[i];
+    }
+    // Subdivide non-empty octants
+    double c[3];
+    for (int o = 0, b = begin; o < 8; b += count[o], ++o) {
+      if (count[o] == 0) continue;
+      c[0] = center[0] + ((o & 1) ? .5 * h : -.5 * h);
+      c[1] = center[1] + ((o & 2) ? .5 * h : -.5 * h);
+      c[2] = center[2] + ((o & 4) ? .5 * h : -.5 * h);
+      BuildTreecodeNode(tree, order, tmp, c, .5 * h, b, b + count[o], depth + 1);
+    }
+  }
+  tree.Nodes[index].Next = static_cast<int>(tree.Nodes.size());
+}
+
+
+} // namespace MeshlessHarmonicMapUtils
+using namespace MeshlessHarmonicMapUtils;
+
+// -----------------------------------------------------------------------------
+void MeshlessHarmonicMap::BuildTreecode()
+{
+  const int n   = _SourcePoints.Size();
+  const int dim = _Coefficients.Cols();
+
+  SharedPtr<Treecode> tree = NewShared<Treecode>();
+  tree->NumberOfSources    = n;
+  tree->NumberOfComponents = dim;
+
+  // Copy source points and determine cubic bounding box
+  Array<double> x(n), y(n), z(n);
+  double bounds[6] = {inf, -inf, inf, -inf, inf, -inf};
+  for (int i = 0; i < n; ++i) {
+    const Point &q = _SourcePoints(i);
+    x[i] = q._x, y[i] = q._y, z[i] = q._z;
+    bounds[0] = min(bounds[0], q._x), bounds[1] = max(bounds[1], q._x);
+    bounds[2] = min(bounds[2], q._y), bounds[3] = max(bounds[3], q._y);
+    bounds[4] = min(bounds[4], q._z), bounds[5] = max(bounds[5], q._z);
+  }
+  const double center[3] = {.5 * (bounds[0] + bounds[1]),
+                            .5 * (bounds[2] + bounds[3]),
+                            .5 * (bounds[4] + bounds[5])};
+  const double h = .5 * max(max(bounds[1] - bounds[0], bounds[3] - bounds[2]), bounds[5] - bounds[4]);
+
+  // Build octree
+  Array<int> order(n), tmp(n);
+  for (int i = 0; i < n; ++i) order[i] = i;
+  tree->X.swap(x);
+  tree->Y.swap(y);
+  tree->Z.swap(z);
+  BuildTreecodeNode(*tree, order, tmp, center, h, 0, n, 0);
+
+  // Store source points and coefficients in octree order
+  x.resize(n), y.resize(n), z.resize(n);
+  tree->C.resize(dim * n);
+  for (int i = 0; i < n; ++i) {
+    const int k = order[i];
+    x[i] = tree->X[k];
+    y[i] = tree->Y[k];
+    z[i] = tree->Z[k];
+    for (int j = 0; j < dim; ++j) {
+      tree->C[j * n + i] = _Coefficients(k, j);
+    }
+  }
+  tree->X.swap(x);
+  tree->Y.swap(y);
+  tree->Z.swap(z);
+
+  // Compute monopole and dipole moments of each node w.r.t. its center
+  const int stride = 4 * dim;
+  tree->Moments.resize(tree->Nodes.size() * stride);
+  for (size_t idx = 0; idx < tree->Nodes.size(); ++idx) {
+    const Treecode::Node &node = tree->Nodes[idx];
+    double * const m0 = tree->Moments.data() + idx * stride;
+    double * const m1 = m0 + dim;
+    for (int j = 0; j < stride; ++j) m0[j] = .0;
+    for (int i = node.Begin; i < node.End; ++i) {
+      const double dx = tree->X[i] - node.Center[0];
+      const double dy = tree->Y[i] - node.Center[1];
+      const double dz = tree->Z[i] - node.Center[2];
+      for (int j = 0; j < dim; ++j) {
+        const double c = tree->C[j * n + i];
+        m0[j] += c;
+        m1[3 * j    ] += c * dx;
+        m1[3 * j + 1] += c * dy;
+        m1[3 * j + 2] += c * dz;
+      }
+    }
+  }
+
+  _Treecode = tree;
+}
+
+// -----------------------------------------------------------------------------
+bool MeshlessHarmonicMap::EvaluateTreecode(double *v, int s, const double p[3]) const
+{
+  const Treecode &tree   = *_Treecode;
+  const int       n      = tree.NumberOfSources;
+  const int       dim    = tree.NumberOfComponents;
+  const int       stride = 4 * dim;
+  const double    theta2 = _OpeningAngle * _OpeningAngle;
+
+  double dx, dy, dz, d2, h, h3;
+
+  for (int j = 0; j < dim; ++j) {
+    v[j * s] = .0;
+  }
+
+  int idx = 0;
+  const int nnodes = static_cast<int>(tree.Nodes.size());
+  while (idx < nnodes) {
+    const Treecode::Node &node = tree.Nodes[idx];
+    dx = p[0] - node.Center[0];
+    dy = p[1] - node.Center[1];
+    dz = p[2] - node.Center[2];
+    d2 = dx * dx + dy * dy + dz * dz;
+    if (node.Radius * node.Radius < theta2 * d2) {
+      // Far field approximation by monopole and dipole moments
+      h  = 1. / sqrt(d2);
+      h3 = h * h * h;
+      const double * const m0 = tree.Moments.data() + idx * stride;
+      const double * const m1 = m0 + dim;
+      for (int j = 0; j < dim; ++j) {
+        v[j * s] += h * m0[j] + h3 * (dx * m1[3 * j] + dy * m1[3 * j + 1] + dz * m1[3 * j + 2]);
+      }
+      idx = node.Next;
+    } else if (node.Leaf) {
+      // Direct summation over source points in near field
+      for (int i = node.Begin; i < node.End; ++i) {
+        dx = p[0] - tree.X[i];
+        dy = p[1] - tree.Y[i];
+        dz = p[2] - tree.Z[i];
+        d2 = dx * dx + dy * dy + dz * dz;
+        if (d2 < 1e-24) {
+          for (int j = 0; j < dim; ++j) {
+            v[j * s] = _OutsideValue;
+          }
+          return false;
+        }
+        h = 1. / sqrt(d2);
+        for (int j = 0; j < dim; ++j) {
+          v[j * s] += h * tree.C[j * n + i];
+        }
+      }
+      idx = node.Next;
+    } else {
+      idx = idx + 1;
+    }
+  }
+
+  for (int j = 0; j < dim; ++j) {
+    v[j * s] *= .25 / pi;
+  }
+  return true;
+}
+
+// =============================================================================
+// Kernel summation
+// =============================================================================
+
+// -----------------------------------------------------------------------------
+SharedPtr<MeshlessHarmonicMap::KernelSources> MeshlessHarmonicMap::NewKernelSources() const
+{
+  const int m   = _SourcePoints.Size();
+  const int dim = _Coefficients.Cols();
+
+  SharedPtr<KernelSources> src = NewShared<KernelSources>();
+  src->NumberOfSources    = m;
+  src->NumberOfComponents = dim;
+
+  // Copy source points to contiguous coordinate arrays
+  src->X.resize(m), src->Y.resize(m), src->Z.resize(m);
+  for (int k = 0; k < m; ++k) {
+    const Point &q = _SourcePoints(k);
+    src->X[k] = q._x, src->Y[k] = q._y, src->Z[k] = q._z;
+  }
+
+  // Copy coefficients premultiplied by constant factor of kernel function
+  src->H.resize(dim * m);
+  for (int j = 0; j < dim; ++j) {
+    const double *a = _Coefficients.RawPointer(0, j);
+    for (int k = 0; k < m; ++k) {
+      src->H[j * m + k] = H(1.) * a[k];
+    }
+  }
+
+  return src;
+}
+
+// -----------------------------------------------------------------------------
+SharedPtr<MeshlessHarmonicMap::KernelSources> MeshlessHarmonicMap::GetKernelSources() const
+{
+  if (_KernelSources && _KernelSources->NumberOfSources    == _SourcePoints.Size()
+                     && _KernelSources->NumberOfComponents == _Coefficients.Cols()) {
+    return _KernelSources;
+  }
+  return NewKernelSources();
+}
+
+// -----------------------------------------------------------------------------
+int MeshlessHarmonicMap::EvaluateKernels(double *v, int n, const double *x,
+                                         const double *y, const double *z,
+                                         bool *inside, const KernelSources &src) const
+{
+  const int m   = src.NumberOfSources;
+  const int dim = src.NumberOfComponents;
+
+  const double * const sx = src.X.data();
+  const double * const sy = src.Y.data();
+  const double * const sz = src.Z.data();
+  const double * const h  = src.H.data();
+  const double * const b  = (src.B.empty() ? nullptr : src.B.data());
+
+  Array<double> zero;
+  if (z == nullptr) {
+    zero.resize(n, .0);
+    z = zero.data();
+  }
+
+  // Sum kernel functions for blocks of points at a time such that the partial
+  // sums of a block stay in cache while looping over all source points, and
+  // the inner loops over the points of a block have no branches
+  double r[KernelBlockSize], d[KernelBlockSize], dx, dy, dz, d2;
+  int    near[KernelBlockSize];
+  int    count = 0;
+
+  for (int i1 = 0; i1 < n; i1 += KernelBlockSize) {
+    const int nb = min(KernelBlockSize, n - i1);
+    const double * const bx = x + i1;
+    const double * const by = y + i1;
+    const double * const bz = z + i1;
+    for (int j = 0; j < dim; ++j) {
+      double * const vj = v + j * n + i1;
+      for (int i = 0; i < nb; ++i) vj[i] = .0;
+    }
+    for (int i = 0; i < nb; ++i) near[i] = 0;
+    for (int k = 0; k < m; ++k) {
+      for (int i = 0; i < nb; ++i) {
+        dx = bx[i] - sx[k];
+        dy = by[i] - sy[k];
+        dz = bz[i] - sz[k];
+        d2 = dx * dx + dy * dy + dz * dz;
+        near[i] |= (d2 < 1e-24 ? 1 : 0);
+        d[i] = sqrt(d2);
+        r[i] = 1. / max(d[i], 1e-12);
+      }
+      for (int j = 0; j < dim; ++j) {
+        double * const vj = v + j * n + i1;
+        const double hk = h[j * m + k];
+        for (int i = 0; i < nb; ++i) {
+          vj[i] += hk * r[i];
+        }
+        if (b) {
+          const double bk = b[j * m + k];
+          for (int i = 0; i < nb; ++i) {
+            vj[i] += bk * d[i];
+          }
+        }
+      }
+    }
+    for (int i = 0; i < nb; ++i) {
+      if (near[i]) {
+        for (int j = 0; j < dim; ++j) {
+          v[j * n + i1 + i] = _OutsideValue;
+        }
+      } else {
+        ++count;
+      }
+      if (inside) inside[i1 + i] = (near[i] == 0);
+    }
+  }
+
+  return count;
+}
+
 // =============================================================================
 // Construction/destruction
 // =============================================================================
 
+// -----------------------------------------------------------------------------
+void MeshlessHarmonicMap::CopyAttributes(const MeshlessHarmonicMap &other)
+{
+  _OpeningAngle  = other._OpeningAngle;
+  _Treecode      = other._Treecode;
+  _KernelSources = other._KernelSources;
+}
+
 // -----------------------------------------------------------------------------
 MeshlessHarmonicMap::MeshlessHarmonicMap()
+:
+  _OpeningAngle(.0)
 {
 }
 
@@ -39,6 +407,7 @@ MeshlessHarmonicMap::MeshlessHarmonicMap(const MeshlessHarmonicMap &other)
 :
   MeshlessMap(other)
 {
+  CopyAttributes(other);
 }
 
 // -----------------------------------------------------------------------------
@@ -46,10 +415,33 @@ MeshlessHarmonicMap &MeshlessHarmonicMap::operator =(const MeshlessHarmonicMap &
 {
   if (this != &other) {
     MeshlessMap::operator =(other);
+    CopyAttributes(other);
   }
   return *this;
 }
 
+// -----------------------------------------------------------------------------
+void MeshlessHarmonicMap::Initialize()
+{
+  // Initialize base class
+  MeshlessMap::Initialize();
+
+  // Build octree of source points
+  _Treecode = nullptr;
+  if (_OpeningAngle > .0) BuildTreecode();
+
+  // Copy source points and coefficients used for direct summation
+  _KernelSources = (_Treecode ? nullptr : NewKernelSources());
+}
+
+// -----------------------------------------------------------------------------
+void MeshlessHarmonicMap::SourcePointsModified()
+{
+  MeshlessMap::SourcePointsModified();
+  _Treecode      = nullptr;
+  _KernelSources = nullptr;
+}
+
 // -----------------------------------------------------------------------------
 Mapping *MeshlessHarmonicMap::NewCopy() const
 {
@@ -68,6 +460,11 @@ MeshlessHarmonicMap::~MeshlessHarmonicMap()
 // -----------------------------------------------------------------------------
 bool MeshlessHarmonicMap::Evaluate(double *v, double x, double y, double z) const
 {
+  if (_Treecode) {
+    const double p[3] = {x, y, z};
+    return EvaluateTreecode(v, 1, p);
+  }
+
   Point  p(x, y, z);
   double d, h;
 
@@ -92,9 +489,30 @@ bool MeshlessHarmonicMap::Evaluate(double *v, double x, double y, double z) cons
   return true;
 }
 
+// -----------------------------------------------------------------------------
+int MeshlessHarmonicMap::Evaluate(double *v, int n, const double *x, const double *y,
+                                  const double *z, bool *inside) const
+{
+  if (_Treecode) {
+    double p[3];
+    int    count = 0;
+    for (int i = 0; i < n; ++i) {
+      p[0] = x[i], p[1] = y[i], p[2] = (z ? z[i] : .0);
+      const bool is_inside = EvaluateTreecode(v + i, n, p);
+      if (inside) inside[i] = is_inside;
+      if (is_inside) ++count;
+    }
+    return count;
+  }
+
+  return EvaluateKernels(v, n, x, y, z, inside, *GetKernelSources());
+}
+
 // -----------------------------------------------------------------------------
 double MeshlessHarmonicMap::Evaluate(double x, double y, double z, int l) const
 {
+  if (_Treecode) return MeshlessMap::Evaluate(x, y, z, l);
+
   Point p(x, y, z);
   double    d, v = .0;
 
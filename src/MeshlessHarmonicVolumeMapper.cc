@@ -204,6 +204,35 @@ bool MeshlessHarmonicVolumeMapper::AddSourcePoint(double q[3])
   return true;
 }
 
+// -----------------------------------------------------------------------------
+int MeshlessHarmonicVolumeMapper::AddSourcePoints(const PointSet &points)
+{
+  const int n0 = NumberOfSourcePoints();
+  const int k  = MeshlessVolumeMapper::AddSourcePoints(points);
+  if (k == 0) return 0;
+
+  const int m = NumberOfBoundaryPoints();
+  const int n = NumberOfSourcePoints();
+
+  _Kernel.Resize(m, n);
+
+  MeshlessHarmonicMap *map = dynamic_cast<MeshlessHarmonicMap *>(_Output.get());
+  const PointSet &sources = map->SourcePoints();
+
+  double p[3], q[3], dist, *c = _Kernel.RawPointer(0, n0);
+  for (int j = n0; j < n; ++j) {
+    const Point &s = sources(j);
+    q[0] = s._x, q[1] = s._y, q[2] = s._z;
+    for (int i = 0; i < m; ++i, ++c) {
+      _Boundary->GetPoint(i, p);
+      dist = sqrt(vtkMath::Distance2BetweenPoints(p, q));
+      *c = MeshlessHarmonicMap::H(dist);
+    }
+  }
+
+  return k;
+}
+
 // -----------------------------------------------------------------------------
 void MeshlessHarmonicVolumeMapper::Solve()
 {
@@ -303,14 +332,17 @@ void MeshlessHarmonicVolumeMapper::Solve()
     // high residual error onto the offset surface (cf. Xu et al., 2013)
     if (verbose) cout << "Insert new source points...", cout.flush();
     const int n = NumberOfSourcePoints();
+    PointSet new_points;
+    new_points.Reserve(static_cast<int>(_Boundary->GetNumberOfPoints()));
     for (vtkIdType ptId = 0; ptId < _Boundary->GetNumberOfPoints(); ++ptId) {
       _ResidualMap->GetTuple(ptId, df);
       if ((df[0]*df[0] + df[1]*df[1] + df[2]*df[2]) > (error + 1.5 * std_error)) {
         _Boundary->GetPoint(ptId, p);
         GetClosestPointOnOffsetSurface(p, q);
-        this->AddSourcePoint(q);
+        new_points.Add(q);
       }
     }
+    this->AddSourcePoints(new_points);
     if (verbose) {
       cout << " done: #points = " << NumberOfSourcePoints()
            << " (+" << (NumberOfSourcePoints() - n) << ")" << endl;
@@ -20,10 +20,68 @@
 #include "mirtk/MeshlessMap.h"
 
 #include "mirtk/Point.h"
+#include "mirtk/Array.h"
+#include "mirtk/UnorderedMap.h"
 
 
 namespace mirtk {
 
+
+// =============================================================================
+// Hash grid of source points
+// =============================================================================
+
+// -----------------------------------------------------------------------------
+struct MeshlessMap::SourcePointGrid
+{
+  typedef UnorderedMap<size_t, Array<int> > BucketMap;
+
+  double    CellSize;       ///< Size of grid cells, i.e., point distance tolerance
+  int       NumberOfPoints; ///< Number of source points inserted into grid
+  BucketMap Buckets;        ///< Indices of source points in each grid cell
+
+  SourcePointGrid(double tol) : CellSize(tol), NumberOfPoints(0) {}
+
+  size_t Key(long long i, long long j, long long k) const
+  {
+    return static_cast<size_t>(i * 73856093LL) ^
+           static_cast<size_t>(j * 19349663LL) ^
+           static_cast<size_t>(k * 83492791LL);
+  }
+
+  long long Cell(double x) const
+  {
+    return static_cast<long long>(floor(x / CellSize));
+  }
+
+  /// Insert next source point into grid
+  void Insert(const Point &p)
+  {
+    Buckets[Key(Cell(p._x), Cell(p._y), Cell(p._z))].push_back(NumberOfPoints++);
+  }
+
+  /// Whether a source point lies within the tolerance of a given point
+  bool Contains(const PointSet &points, const Point &p) const
+  {
+    const long long ci = Cell(p._x), cj = Cell(p._y), ck = Cell(p._z);
+    for (long long k = ck - 1; k <= ck + 1; ++k)
+    for (long long j = cj - 1; j <= cj + 1; ++j)
+    for (long long i = ci - 1; i <= ci + 1; ++i) {
+      const auto bucket = Buckets.find(Key(i, j, k));
+      if (bucket == Buckets.end()) continue;
+      for (auto idx : bucket->second) {
+        const Point &q = points(idx);
+        if (fequal(p._x, q._x, CellSize) &&
+            fequal(p._y, q._y, CellSize) &&
+            fequal(p._z, q._z, CellSize)) {
+          return true;
+        }
+      }
+    }
+    return false;
+  }
+};
+
 // =============================================================================
 // Construction/destruction
 // =============================================================================
@@ -31,8 +89,9 @@ namespace mirtk {
 // -----------------------------------------------------------------------------
 void MeshlessMap::CopyAttributes(const MeshlessMap &other)
 {
-  _SourcePoints = other._SourcePoints;
-  _Coefficients = other._Coefficients;
+  _SourcePoints    = other._SourcePoints;
+  _Coefficients    = other._Coefficients;
+  _SourcePointGrid = nullptr;
 }
 
 // -----------------------------------------------------------------------------
@@ -111,6 +170,87 @@ void MeshlessMap::BoundingBox(double &x1, double &y1, double &z1,
   }
 }
 
+// =============================================================================
+// Source points
+// =============================================================================
+
+// -----------------------------------------------------------------------------
+MeshlessMap::SourcePointGrid &MeshlessMap::UpdateSourcePointGrid(double tol)
+{
+  // Rebuild grid when tolerance changed or source points were removed
+  if (!_SourcePointGrid || _SourcePointGrid->CellSize != tol ||
+      _SourcePointGrid->NumberOfPoints > _SourcePoints.Size()) {
+    _SourcePointGrid = NewShared<SourcePointGrid>(tol);
+    _SourcePointGrid->Buckets.reserve(_SourcePoints.Size());
+  }
+  // Insert source points which were added since last update
+  SourcePointGrid &grid = *_SourcePointGrid;
+  while (grid.NumberOfPoints < _SourcePoints.Size()) {
+    grid.Insert(_SourcePoints(grid.NumberOfPoints));
+  }
+  return grid;
+}
+
+// -----------------------------------------------------------------------------
+void MeshlessMap::ReserveSourcePoints(int m)
+{
+  const int n = _SourcePoints.Size();
+  _SourcePoints.Reserve(max(n + m, max(2 * n, 16)));
+}
+
+// -----------------------------------------------------------------------------
+bool MeshlessMap::AddSourcePoint(double p[3], double tol)
+{
+  const Point q(p);
+  if (tol > .0 && UpdateSourcePointGrid(tol).Contains(_SourcePoints, q)) {
+    return false;
+  }
+  // Grow capacity geometrically, i.e., double it when the number of points
+  // reaches a power of two, assuming Reserve leaves a larger capacity as is
+  const int n = _SourcePoints.Size();
+  if ((n & (n - 1)) == 0) ReserveSourcePoints(1);
+  _SourcePoints.Add(q);
+  if (tol > .0) _SourcePointGrid->Insert(q);
+  _Coefficients.Resize(_SourcePoints.Size(), _Coefficients.Cols());
+  SourcePointsModified();
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+int MeshlessMap::AddSourcePoints(const PointSet &points, double tol)
+{
+  const int n = _SourcePoints.Size();
+
+  ReserveSourcePoints(points.Size());
+  if (tol > .0) {
+    // Select source points which are not too close to existing points
+    SourcePointGrid &grid = UpdateSourcePointGrid(tol);
+    for (int i = 0; i < points.Size(); ++i) {
+      const Point &p = points(i);
+      if (!grid.Contains(_SourcePoints, p)) {
+        _SourcePoints.Add(p);
+        grid.Insert(p);
+      }
+    }
+  } else {
+    for (int i = 0; i < points.Size(); ++i) {
+      _SourcePoints.Add(points(i));
+    }
+  }
+
+  // Resize coefficients matrix only once
+  if (_SourcePoints.Size() > n) {
+    _Coefficients.Resize(_SourcePoints.Size(), _Coefficients.Cols());
+    SourcePointsModified();
+  }
+  return _SourcePoints.Size() - n;
+}
+
+// -----------------------------------------------------------------------------
+void MeshlessMap::SourcePointsModified()
+{
+}
+
 // =============================================================================
 // I/O
 // =============================================================================
@@ -119,7 +259,9 @@ void MeshlessMap::BoundingBox(double &x1, double &y1, double &z1,
 void MeshlessMap::ReadMap(Cifstream &is)
 {
   _SourcePoints.Clear();
+  _SourcePointGrid = nullptr;
   is >> _SourcePoints >> _Coefficients;
+  SourcePointsModified();
 }
 
 // -----------------------------------------------------------------------------
@@ -22,6 +22,7 @@
 #include "mirtk/CommonExport.h"
 
 #include "mirtk/Math.h"
+#include "mirtk/Array.h"
 #include "mirtk/Assert.h"
 #include "mirtk/Parallel.h"
 #include "mirtk/MeshSmoothing.h"
@@ -113,14 +114,20 @@ struct ComputeResidualMap
 
   void operator ()(const blocked_range<vtkIdType> &re)
   {
+    // Evaluate map at all boundary points of this range at once
+    const int n = static_cast<int>(re.end() - re.begin());
+    Array<double> x(n), y(n), z(n), f(n * _OutputDimension);
     double p[3], dist2;
-    double *f  = new double[_OutputDimension];
+    for (int i = 0; i < n; ++i) {
+      _BoundarySet->GetPoint(re.begin() + i, p);
+      x[i] = p[0], y[i] = p[1], z[i] = p[2];
+    }
+    _OutputMap->Evaluate(f.data(), n, x.data(), y.data(), z.data());
     double *df = new double[_OutputDimension];
     for (vtkIdType ptId = re.begin(); ptId != re.end(); ++ptId) {
-      _BoundarySet->GetPoint(ptId, p);
-      _OutputMap->Evaluate(f, p);
-      for (int i = 0; i < _OutputDimension; ++i) {
-        df[i] = _BoundaryMap->GetComponent(ptId, i) - f[i];
+      const int i = static_cast<int>(ptId - re.begin());
+      for (int l = 0; l < _OutputDimension; ++l) {
+        df[l] = _BoundaryMap->GetComponent(ptId, l) - f[l * n + i];
       }
       _ResidualMap->SetTuple(ptId, df);
       dist2 = Dot(df, df);
@@ -129,7 +136,6 @@ struct ComputeResidualMap
       if (dist2 < _MinSquaredError) _MinSquaredError = dist2;
       if (dist2 > _MaxSquaredError) _MaxSquaredError = dist2;
     }
-    delete[] f;
     delete[] df;
   }
 };
@@ -453,6 +459,13 @@ bool MeshlessVolumeMapper::AddSourcePoint(double q[3])
   return map->AddSourcePoint(q, 1e-9);
 }
 
+// -----------------------------------------------------------------------------
+int MeshlessVolumeMapper::AddSourcePoints(const PointSet &points)
+{
+  MeshlessMap *map = dynamic_cast<MeshlessMap *>(_Output.get());
+  return map->AddSourcePoints(points, 1e-9);
+}
+
 // -----------------------------------------------------------------------------
 void MeshlessVolumeMapper::PartitionSourcePoints()
 {
@@ -645,14 +658,17 @@ void MeshlessVolumeMapper::Solve()
     // high residual error onto the offset surface (cf. Xu et al., 2013)
     if (verbose) cout << "Insert new source points...", cout.flush();
     const int n = NumberOfSourcePoints();
+    PointSet new_points;
+    new_points.Reserve(static_cast<int>(_Boundary->GetNumberOfPoints()));
     for (vtkIdType ptId = 0; ptId < _Boundary->GetNumberOfPoints(); ++ptId) {
       _ResidualMap->GetTuple(ptId, df);
       if ((df[0]*df[0] + df[1]*df[1] + df[2]*df[2]) > (error + 1.5 * std_error)) {
         _Boundary->GetPoint(ptId, p);
         GetClosestPointOnOffsetSurface(p, q);
-        this->AddSourcePoint(q);
+        new_points.Add(q);
       }
     }
+    this->AddSourcePoints(new_points);
     if (verbose) {
       cout << " done: #points = " << NumberOfSourcePoints()
            << " (+" << (NumberOfSourcePoints() - n) << ")" << endl;
@@ -46,10 +46,13 @@ MIRTK_Common_EXPORT extern int verbose;
 void NearOptimalIntrinsicSurfaceMapper
 ::CopyAttributes(const NearOptimalIntrinsicSurfaceMapper &other)
 {
+  _ExactSolution = other._ExactSolution;
 }
 
 // -----------------------------------------------------------------------------
 NearOptimalIntrinsicSurfaceMapper::NearOptimalIntrinsicSurfaceMapper()
+:
+  _ExactSolution(false)
 {
 }
 
@@ -91,11 +94,14 @@ void NearOptimalIntrinsicSurfaceMapper::ComputeMap()
   vtkSmartPointer<vtkDataArray> u0; // Authalic  map, i.e., lambda=0
   vtkSmartPointer<vtkDataArray> u1; // Conformal map, i.e., lambda=1
 
+  // Compute conformal and authalic edge weights shared by all linear systems
+  ComputeWeightComponents();
+
   // Compute discrete authalic map
   if (verbose > 0) {
     cout << "\n  Computing discrete authalic map...";
   }
-  _Lambda = 0., IntrinsicSurfaceMapper::ComputeMap();
+  _Lambda = 0., NonSymmetricWeightsSurfaceMapper::ComputeMap();
   u0.TakeReference(_Values->NewInstance());
   u0->DeepCopy(_Values);
   if (verbose > 0) {
@@ -106,7 +112,7 @@ void NearOptimalIntrinsicSurfaceMapper::ComputeMap()
   if (verbose > 0) {
     cout << "\n  Computing discrete conformal map...";
   }
-  _Lambda = 1., IntrinsicSurfaceMapper::ComputeMap();
+  _Lambda = 1., NonSymmetricWeightsSurfaceMapper::ComputeMap();
   u1 = _Values;
   if (verbose > 0) {
     cout << "  Computing discrete conformal map... done\n\n";
@@ -125,6 +131,20 @@ void NearOptimalIntrinsicSurfaceMapper::ComputeMap()
   for (int       j = 0; j < m; ++j) {
     _Values->SetComponent(i, j, mu * u0->GetComponent(i, j) + _Lambda * u1->GetComponent(i, j));
   }
+
+  // Solve linear system with near-optimal edge weights
+  if (_ExactSolution && _Lambda != 0. && _Lambda != 1.) {
+    if (verbose > 0) {
+      cout << "\n  Computing near-optimal intrinsic map...";
+    }
+    NonSymmetricWeightsSurfaceMapper::ComputeMap();
+    if (verbose > 0) {
+      cout << "  Computing near-optimal intrinsic map... done\n";
+    }
+  }
+
+  _ConformalWeights.clear();
+  _AuthalicWeights.clear();
 }
 
 // =============================================================================
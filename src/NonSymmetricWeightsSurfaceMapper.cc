@@ -19,10 +19,11 @@
 
 #include "mirtk/NonSymmetricWeightsSurfaceMapper.h"
 
+#include "mirtk/EdgeTable.h"
+#include "mirtk/Parallel.h"
+#include "mirtk/SparseSystemCache.h"
+
 #include "Eigen/SparseCore"
-#include "Eigen/SparseLU"
-#include "Eigen/OrderingMethods"
-#include "Eigen/IterativeLinearSolvers"
 
 
 namespace mirtk {
@@ -32,6 +33,90 @@ namespace mirtk {
 MIRTK_Common_EXPORT extern int verbose;
 
 
+// =============================================================================
+// Auxiliary functors
+// =============================================================================
+
+// -----------------------------------------------------------------------------
+/// Weight policy which calls the virtual Weights function of the filter
+struct NonSymmetricWeightsSurfaceMapper::VirtualWeights
+{
+  const NonSymmetricWeightsSurfaceMapper *_Filter;
+
+  void operator ()(int i, const int *j, double *w, int d) const
+  {
+    _Filter->Weights(i, j, w, d);
+  }
+};
+
+// -----------------------------------------------------------------------------
+/// Weight policy which looks up precomputed weights of directed edges
+struct NonSymmetricWeightsSurfaceMapper::DirectedEdgeWeightArray
+{
+  const mirtk::EdgeTable *_EdgeTable;
+  const double           *_Weights;
+
+  void operator ()(int i, const int *j, double *w, int d) const
+  {
+    for (int k = 0; k < d; ++k) {
+      w[k] = _Weights[2 * _EdgeTable->EdgeId(i, j[k]) + (i < j[k] ? 0 : 1)];
+    }
+  }
+};
+
+// -----------------------------------------------------------------------------
+/// Set coefficients and right-hand side of linear equations of free points,
+/// where the edge weight policy is inlined into the loop over free points
+template <class TWeights>
+struct NonSymmetricWeightsSurfaceMapper::AssembleLinearSystem
+{
+  const NonSymmetricWeightsSurfaceMapper *_Filter;
+  TWeights                                _Weights;
+  Eigen::SparseMatrix<double>            *_Matrix;
+  Eigen::MatrixXd                        *_RightHandSide;
+
+  void operator ()(const blocked_range<int> &rows) const
+  {
+    const mirtk::EdgeTable &edgeTable = *_Filter->_EdgeTable;
+    const int               m         = static_cast<int>(_RightHandSide->cols());
+    const int              *offsets   = _Matrix->outerIndexPtr();
+    const int              *indices   = _Matrix->innerIndexPtr();
+    double                 *values    = _Matrix->valuePtr();
+
+    int        i, c, d_i;
+    const int *j;
+    double     w_ii;
+
+    // Fixed-capacity scratch memory for edge weights of each row
+    double        buffer[64];
+    Array<double> heap;
+    double       *w_i = buffer;
+    if (edgeTable.MaxNumberOfAdjacentPoints() > 64) {
+      heap.resize(edgeTable.MaxNumberOfAdjacentPoints());
+      w_i = heap.data();
+    }
+
+    for (int r = rows.begin(); r != rows.end(); ++r) {
+      i = _Filter->FreePointId(r);
+      edgeTable.GetAdjacentPoints(i, d_i, j);
+      _Weights(i, j, w_i, d_i);
+      w_ii = .0;
+      for (int k = 0; k < d_i; ++k) {
+        c = _Filter->FreePointIndex(j[k]);
+        if (c >= 0) {
+          values[NonZeroIndex(offsets, indices, r, c)] = -w_i[k];
+        } else {
+          for (int l = 0; l < m; ++l) {
+            (*_RightHandSide)(r, l) += w_i[k] * _Filter->GetValue(j[k], l);
+          }
+        }
+        w_ii += w_i[k];
+      }
+      values[NonZeroIndex(offsets, indices, r, r)] = w_ii;
+    }
+  }
+};
+
 // =============================================================================
 // Construction/destruction
 // =============================================================================
@@ -76,6 +161,12 @@ NonSymmetricWeightsSurfaceMapper::~NonSymmetricWeightsSurfaceMapper()
 // Execution
 // =============================================================================
 
+// -----------------------------------------------------------------------------
+void NonSymmetricWeightsSurfaceMapper::ComputeWeights(Array<double> &w) const
+{
+  w.clear();
+}
+
 // -----------------------------------------------------------------------------
 void NonSymmetricWeightsSurfaceMapper
 ::Weights(int i, const int *j, double *w_i, int d_i) const
@@ -95,56 +186,51 @@ double NonSymmetricWeightsSurfaceMapper::Weight(int i, int j) const
 // -----------------------------------------------------------------------------
 void NonSymmetricWeightsSurfaceMapper::ComputeMap()
 {
-  const bool use_direct_solver = (_NumberOfIterations < 0 || _NumberOfIterations == 1);
-
   typedef Eigen::MatrixXd             Values;
   typedef Eigen::SparseMatrix<double> Matrix;
-  typedef Eigen::Triplet<double>      NZEntry;
 
-  const int N = NumberOfPoints();
   const int n = NumberOfFreePoints();
   const int m = NumberOfComponents();
 
-  int i, k, l, r, c;
-  const int *j;
+  int i, r, l;
+
+  // Get cached non-zero pattern and solver of linear systems with same topology
+  SharedPtr<SparseSystemCache::Entry> cache = GetSparseSystemCacheEntry();
+  std::lock_guard<std::mutex> lock(cache->Mutex);
+  if (cache->Offsets.empty()) {
+    GetSparsityPattern(cache->Offsets, cache->Indices);
+  }
 
   Matrix A(n, n);
   Values b(n, m);
   {
-    Array<NZEntry> w;
-    Array<double>  w_ii(n, .0);
-
+    // Allocate non-zero entries of system matrix
+    const Array<int> &offsets = cache->Offsets;
+    const Array<int> &indices = cache->Indices;
+    A.resizeNonZeros(offsets[n]);
+    memcpy(A.outerIndexPtr(), offsets.data(), offsets.size() * sizeof(int));
+    memcpy(A.innerIndexPtr(), indices.data(), indices.size() * sizeof(int));
     b.setZero();
-    w.reserve(2 * _EdgeTable->NumberOfEdges() + n);
-
-    int     d_i;
-    double *w_i = new double[_EdgeTable->MaxNumberOfAdjacentPoints()];
-
-    EdgeIterator edgeIt(*_EdgeTable);
-    for (i = 0; i < N; ++i) {
-      r = FreePointIndex(i);
-      if (r >= 0) {
-        _EdgeTable->GetAdjacentPoints(i, d_i, j);
-        this->Weights(i, j, w_i, d_i);
-        for (k = 0; k < d_i; ++k) {
-          c = FreePointIndex(j[k]);
-          if (c >= 0) {
-            w.push_back(NZEntry(r, c, -w_i[k]));
-          } else {
-            for (l = 0; l < m; ++l) {
-              b(r, l) += w_i[k] * GetValue(j[k], l);
-            }
-          }
-          w_ii[r] += w_i[k];
-        }
-      }
-    }
-    for (r = 0; r < n; ++r) {
-      w.push_back(NZEntry(r, r, w_ii[r]));
-    }
-    delete[] w_i;
 
-    A.setFromTriplets(w.begin(), w.end());
+    // Compute edge weights and set coefficients of each row in parallel
+    Array<double> weights;
+    this->ComputeWeights(weights);
+    if (weights.empty()) {
+      AssembleLinearSystem<VirtualWeights> assemble;
+      assemble._Filter          = this;
+      assemble._Weights._Filter = this;
+      assemble._Matrix          = &A;
+      assemble._RightHandSide   = &b;
+      parallel_for(blocked_range<int>(0, n), assemble);
+    } else {
+      AssembleLinearSystem<DirectedEdgeWeightArray> assemble;
+      assemble._Filter             = this;
+      assemble._Weights._EdgeTable = _EdgeTable.get();
+      assemble._Weights._Weights   = weights.data();
+      assemble._Matrix             = &A;
+      assemble._RightHandSide      = &b;
+      parallel_for(blocked_range<int>(0, n), assemble);
+    }
   }
 
   if (verbose) {
@@ -156,28 +242,27 @@ void NonSymmetricWeightsSurfaceMapper::ComputeMap()
     cout.flush();
   }
 
+  // Solve linear system, where system matrix is non-symmetric
+  SparseLinearSolver &solver = cache->Solver;
+  solver.Type(_LinearSolver);
+  solver.Preconditioner(_Preconditioner);
+  solver.Symmetric(false);
+  solver.MaxNumberOfIterations(_NumberOfIterations);
+  solver.Tolerance(_Tolerance);
+  solver.MixedPrecision(_MixedPrecision);
+
   Values x(n, m);
-  int    niter = 0;
-  double error = nan;
-
-  if (use_direct_solver) {
-    Eigen::SparseLU<Matrix> solver;
-    solver.analyzePattern(A);
-    solver.factorize(A);
-    x = solver.solve(b);
-  } else {
-    Eigen::BiCGSTAB<Matrix> solver(A);
-    if (_NumberOfIterations > 0 ) solver.setMaxIterations(_NumberOfIterations);
-    if (_Tolerance          > 0.) solver.setTolerance(_Tolerance);
+  if (solver.IsIterative()) {
     for (r = 0; r < n; ++r) {
       i = FreePointId(r);
       for (l = 0; l < m; ++l) {
         x(r, l) = GetValue(i, l);
       }
     }
-    x = solver.solveWithGuess(b, x);
-    niter = solver.iterations();
-    error = solver.error();
+  }
+  if (!solver.Solve(A, b, x)) {
+    cerr << this->NameOfType() << "::ComputeMap: Failed to solve linear system" << endl;
+    exit(1);
   }
 
   for (r = 0; r < n; ++r) {
@@ -187,9 +272,16 @@ void NonSymmetricWeightsSurfaceMapper::ComputeMap()
     }
   }
 
-  if (verbose && !use_direct_solver) {
-    cout << "  No. of iterations            = " << niter << "\n";
-    cout << "  Estimated error              = " << error << "\n";
+  if (verbose) {
+    cout << "  Linear solver                = " << ToString(solver.UsedType()) << "\n";
+    if (IsIterativeLinearSolver(solver.UsedType())) {
+      cout << "  Preconditioner               = " << ToString(solver.PreconditionerType()) << "\n";
+      cout << "  No. of iterations            = " << solver.NumberOfIterations() << "\n";
+      cout << "  Estimated error              = " << solver.Error() << "\n";
+    } else if (solver.MixedPrecision()) {
+      cout << "  No. of refinement steps      = " << solver.NumberOfIterations() << "\n";
+      cout << "  Estimated error              = " << solver.Error() << "\n";
+    }
     cout.flush();
   }
 }
@@ -18,11 +18,16 @@
  */
 
 #include "mirtk/PiecewiseLinearMap.h"
+#include "mirtk/SimplexLocator.h"
 
 #include "mirtk/Vtk.h"
 #include "mirtk/Path.h"
 #include "mirtk/PointSetIO.h"
 #include "mirtk/PointSetUtils.h"
+#include "mirtk/GenericImage.h"
+#include "mirtk/Parallel.h"
+#include "mirtk/Pair.h"
+#include "mirtk/Algorithm.h"
 
 #include "vtkPoints.h"
 #include "vtkImageData.h"
@@ -31,6 +36,9 @@
 #include "vtkGenericCell.h"
 #include "vtkIdList.h"
 #include "vtkCellLocator.h"
+#include "vtkCellType.h"
+#include "vtkPolyData.h"
+#include "vtkUnstructuredGrid.h"
 
 #include "vtkXMLImageDataWriter.h"
 #include "vtkXMLImageDataReader.h"
@@ -39,6 +47,299 @@
 namespace mirtk {
 
 
+// =============================================================================
+// Auxiliary functors
+// =============================================================================
+
+namespace PiecewiseLinearMapUtils {
+
+
+// -----------------------------------------------------------------------------
+/// Triangle or tetrahedron of the map domain in lattice coordinates
+struct LatticeSimplex
+{
+  vtkIdType _PointId[4]; ///< IDs of simplex vertices
+  double    _Origin[3];  ///< Lattice coordinates of first vertex
+  double    _Inverse[9]; ///< Maps offset from first vertex to barycentric coordinates
+  int       _Bounds[6];  ///< Index bounds of lattice points within bounding box
+};
+
+// -----------------------------------------------------------------------------
+/// Invert 2x2 or 3x3 matrix stored in row-major order
+///
+/// \returns Whether matrix is non-singular.
+bool InvertSimplexMatrix(int dim, const double m[9], double inv[9])
+{
+  if (dim == 2) {
+    const double det = m[0] * m[4] - m[1] * m[3];
+    if (fequal(det, .0, 1e-12)) return false;
+    inv[0] =  m[4] / det, inv[1] = -m[1] / det;
+    inv[3] = -m[3] / det, inv[4] =  m[0] / det;
+  } else {
+    const double c0 = m[4] * m[8] - m[5] * m[7];
+    const double c1 = m[5] * m[6] - m[3] * m[8];
+    const double c2 = m[3] * m[7] - m[4] * m[6];
+    const double det = m[0] * c0 + m[1] * c1 + m[2] * c2;
+    if (fequal(det, .0, 1e-12)) return false;
+    inv[0] = c0 / det;
+    inv[1] = (m[2] * m[7] - m[1] * m[8]) / det;
+    inv[2] = (m[1] * m[5] - m[2] * m[4]) / det;
+    inv[3] = c1 / det;
+    inv[4] = (m[0] * m[8] - m[2] * m[6]) / det;
+    inv[5] = (m[2] * m[3] - m[0] * m[5]) / det;
+    inv[6] = c2 / det;
+    inv[7] = (m[1] * m[6] - m[0] * m[7]) / det;
+    inv[8] = (m[0] * m[4] - m[1] * m[3]) / det;
+  }
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+/// Interpolate map values at lattice points covered by simplices
+///
+/// Each task processes one or more lattice slices (rows for 2D lattices)
+/// such that no two threads write to the same voxel.
+template <class TVoxel>
+class RasterizeSimplices
+{
+  const Array<LatticeSimplex> *_Simplices;
+  const Array<Array<int> >    *_Buckets;
+  vtkDataArray                *_Values;
+  GenericImage<TVoxel>        *_Output;
+  const int                    _Dimension;
+  const int                    _l1, _l2;
+  const double                 _Tolerance;
+
+public:
+
+  RasterizeSimplices(const Array<LatticeSimplex> *simplices,
+                     const Array<Array<int> >    *buckets,
+                     vtkDataArray                *values,
+                     GenericImage<TVoxel>        *output,
+                     int dim, int l1, int l2, double tol)
+  :
+    _Simplices(simplices),
+    _Buckets(buckets),
+    _Values(values),
+    _Output(output),
+    _Dimension(dim),
+    _l1(l1), _l2(l2),
+    _Tolerance(tol)
+  {}
+
+  void operator ()(const blocked_range<int> &re) const
+  {
+    const double eps = _Tolerance;
+    int    i1, i2, j1, j2, k1, k2, n;
+    double w[4], d[3];
+    bool   inside;
+
+    for (int s = re.begin(); s != re.end(); ++s) {
+      for (auto idx : (*_Buckets)[s]) {
+        const LatticeSimplex &cell = (*_Simplices)[idx];
+        i1 = cell._Bounds[0], i2 = cell._Bounds[1];
+        if (_Dimension == 3) {
+          j1 = cell._Bounds[2], j2 = cell._Bounds[3];
+          k1 = k2 = s;
+        } else {
+          j1 = j2 = s;
+          k1 = k2 = 0;
+        }
+        for (int k = k1; k <= k2; ++k)
+        for (int j = j1; j <= j2; ++j)
+        for (int i = i1; i <= i2; ++i) {
+          d[0] = i - cell._Origin[0];
+          d[1] = j - cell._Origin[1];
+          d[2] = k - cell._Origin[2];
+          w[0] = 1.;
+          inside = true;
+          for (n = 1; n <= _Dimension; ++n) {
+            const double *r = cell._Inverse + 3 * (n - 1);
+            w[n] = r[0] * d[0] + r[1] * d[1] + (_Dimension == 3 ? r[2] * d[2] : .0);
+            w[0] -= w[n];
+            if (w[n] < -eps) {
+              inside = false;
+              break;
+            }
+          }
+          if (!inside || w[0] < -eps) continue;
+          for (int l = _l1; l < _l2; ++l) {
+            double v = .0;
+            for (n = 0; n <= _Dimension; ++n) {
+              v += w[n] * _Values->GetComponent(cell._PointId[n], l);
+            }
+            _Output->Put(i, j, k, l - _l1, static_cast<TVoxel>(v));
+          }
+        }
+      }
+    }
+  }
+};
+
+// -----------------------------------------------------------------------------
+/// Insert two zero bits between each of the lower 10 bits of an integer
+inline unsigned int SpreadBits(unsigned int v)
+{
+  v &= 0x000003FFu;
+  v = (v | (v << 16)) & 0xFF0000FFu;
+  v = (v | (v <<  8)) & 0x0300F00Fu;
+  v = (v | (v <<  4)) & 0x030C30C3u;
+  v = (v | (v <<  2)) & 0x09249249u;
+  return v;
+}
+
+// -----------------------------------------------------------------------------
+/// Whether values are in non-decreasing or non-increasing order
+bool IsMonotone(int n, const double *a)
+{
+  int i = 1;
+  while (i < n && a[i] == a[i-1]) ++i;
+  if (i < n) {
+    if (a[i] > a[i-1]) {
+      for (++i; i < n; ++i) {
+        if (a[i] < a[i-1]) return false;
+      }
+    } else {
+      for (++i; i < n; ++i) {
+        if (a[i] > a[i-1]) return false;
+      }
+    }
+  }
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+/// Whether consecutive query points are nearby, e.g., along a row of a lattice
+bool IsCoherent(int n, const double *x, const double *y, const double *z)
+{
+  return IsMonotone(n, x) && IsMonotone(n, y) && (z == nullptr || IsMonotone(n, z));
+}
+
+// -----------------------------------------------------------------------------
+/// Get order of query points along Morton (Z-order) space-filling curve
+void MortonOrder(int n, const double *x, const double *y, const double *z, Array<int> &order)
+{
+  double bmin[3] = {x[0], y[0], z ? z[0] : .0};
+  double bmax[3] = {bmin[0], bmin[1], bmin[2]};
+  for (int i = 1; i < n; ++i) {
+    bmin[0] = min(bmin[0], x[i]), bmax[0] = max(bmax[0], x[i]);
+    bmin[1] = min(bmin[1], y[i]), bmax[1] = max(bmax[1], y[i]);
+    if (z) bmin[2] = min(bmin[2], z[i]), bmax[2] = max(bmax[2], z[i]);
+  }
+  double s[3];
+  for (int c = 0; c < 3; ++c) {
+    s[c] = (bmax[c] > bmin[c] ? 1023. / (bmax[c] - bmin[c]) : .0);
+  }
+  Array<Pair<unsigned int, int> > code(n);
+  for (int i = 0; i < n; ++i) {
+    code[i].first  = (SpreadBits(static_cast<unsigned int>((x[i] - bmin[0]) * s[0]))     ) |
+                     (SpreadBits(static_cast<unsigned int>((y[i] - bmin[1]) * s[1])) << 1);
+    if (z) {
+      code[i].first |= (SpreadBits(static_cast<unsigned int>((z[i] - bmin[2]) * s[2])) << 2);
+    }
+    code[i].second = i;
+  }
+  sort(code.begin(), code.end());
+  order.resize(n);
+  for (int i = 0; i < n; ++i) {
+    order[i] = code[i].second;
+  }
+}
+
+// -----------------------------------------------------------------------------
+/// Evaluate piecewise linear map at lattice points by scan-converting its cells
+///
+/// The map domain must be either a tetrahedral mesh and the lattice 3D, or a
+/// triangulated planar surface and the lattice 2D. A lattice point is inside
+/// a cell when none of its barycentric coordinates is less than -tol.
+template <class TVoxel>
+void RasterizeCells(const PiecewiseLinearMap *map, GenericImage<TVoxel> &f, int l,
+                    vtkImageData *mask, double tol)
+{
+  vtkDataSet   * const domain = map->Domain();
+  vtkDataArray * const values = map->Values();
+
+  const ImageAttributes &lattice = f.Attributes();
+  const int dim = (lattice._z > 1 ? 3 : 2);
+  const int nbuckets = (dim == 3 ? lattice._z : lattice._y);
+  const vtkIdType ncells = domain->GetNumberOfCells();
+
+  // Transform cells to lattice coordinates
+  Array<LatticeSimplex> simplices;
+  Array<Array<int> >    buckets(nbuckets);
+  simplices.reserve(static_cast<size_t>(ncells));
+
+  const double eps = 1e-6;
+  const int    n[3] = {lattice._x, lattice._y, lattice._z};
+  double       p[4][3], m[9], bmin, bmax;
+  bool         valid;
+
+  LatticeSimplex cell;
+  vtkNew<vtkIdList> ptIds;
+  for (vtkIdType cellId = 0; cellId < ncells; ++cellId) {
+    domain->GetCellPoints(cellId, ptIds.GetPointer());
+    for (int i = 0; i <= dim; ++i) {
+      cell._PointId[i] = ptIds->GetId(i);
+      domain->GetPoint(cell._PointId[i], p[i]);
+      f.WorldToImage(p[i][0], p[i][1], p[i][2]);
+    }
+    valid = true;
+    for (int c = 0; c < 3; ++c) {
+      bmin = bmax = p[0][c];
+      for (int i = 1; i <= dim; ++i) {
+        bmin = min(bmin, p[i][c]);
+        bmax = max(bmax, p[i][c]);
+      }
+      if (c < dim) {
+        cell._Bounds[2*c  ] = max(0,        static_cast<int>(ceil (bmin - eps)));
+        cell._Bounds[2*c+1] = min(n[c] - 1, static_cast<int>(floor(bmax + eps)));
+        if (cell._Bounds[2*c] > cell._Bounds[2*c+1]) valid = false;
+      } else if (bmin < -eps || bmax > eps) {
+        // Triangle not contained in plane of 2D lattice
+        valid = false;
+      } else {
+        cell._Bounds[2*c] = cell._Bounds[2*c+1] = 0;
+      }
+    }
+    if (!valid) continue;
+    for (int r = 0; r < dim; ++r)
+    for (int c = 0; c < dim; ++c) {
+      m[3 * r + c] = p[c + 1][r] - p[0][r];
+    }
+    if (!InvertSimplexMatrix(dim, m, cell._Inverse)) continue;
+    memcpy(cell._Origin, p[0], 3 * sizeof(double));
+    const int s = static_cast<int>(simplices.size());
+    for (int b = cell._Bounds[2*dim-2]; b <= cell._Bounds[2*dim-1]; ++b) {
+      buckets[b].push_back(s);
+    }
+    simplices.push_back(cell);
+  }
+
+  // Interpolate map values at lattice points inside the map domain
+  f = static_cast<TVoxel>(map->OutsideValue());
+  RasterizeSimplices<TVoxel> eval(&simplices, &buckets, values, &f, dim, l, l + lattice._t, tol);
+  parallel_for(blocked_range<int>(0, nbuckets), eval);
+
+  // Set values of lattice points outside the mask to NaN
+  if (mask) {
+    const TVoxel nan = numeric_limits<TVoxel>::quiet_NaN();
+    for (int k = 0; k < lattice._z; ++k)
+    for (int j = 0; j < lattice._y; ++j)
+    for (int i = 0; i < lattice._x; ++i) {
+      if (mask->GetScalarComponentAsFloat(i, j, k, 0) == .0) {
+        for (int t = 0; t < lattice._t; ++t) {
+          f.Put(i, j, k, t, nan);
+        }
+      }
+    }
+  }
+}
+
+
+} // namespace PiecewiseLinearMapUtils
+using namespace PiecewiseLinearMapUtils;
+
+
 // =============================================================================
 // Construction/Destruction
 // =============================================================================
@@ -48,23 +349,20 @@ const double PiecewiseLinearMap::_Tolerance2 = 1e-9;
 // -----------------------------------------------------------------------------
 void PiecewiseLinearMap::CopyAttributes(const PiecewiseLinearMap &other)
 {
-  _Domain      = other._Domain;
-  _Values      = other._Values;
-  _MaxCellSize = other._MaxCellSize;
+  _Domain       = other._Domain;
+  _Values       = other._Values;
+  _MaxCellSize  = other._MaxCellSize;
+  _MaxWalkSteps = other._MaxWalkSteps;
 
-  if (other._Locator) {
-    _Locator = vtkSmartPointer<vtkCellLocator>::New();
-    _Locator->SetDataSet(_Domain);
-    _Locator->BuildLocator();
-  } else {
-    _Locator = nullptr;
-  }
+  // Share cell locator with other map, which is not modified after it was built
+  _Locator = other._Locator;
 }
 
 // -----------------------------------------------------------------------------
 PiecewiseLinearMap::PiecewiseLinearMap()
 :
-  _MaxCellSize(0)
+  _MaxCellSize(0),
+  _MaxWalkSteps(32)
 {
 }
 
@@ -105,10 +403,40 @@ void PiecewiseLinearMap::Initialize()
   // Determine maximum number of cell points
   _MaxCellSize = _Domain->GetMaxCellSize();
 
+  // Build links from points to cells used to find cell neighbors. This is
+  // done here rather than by BuildLocator, which may be called concurrently
+  // by multiple threads, because the domain mesh may be shared with other
+  // objects that are not guarded by the mutex of the cell locator.
+  vtkPolyData *polydata = vtkPolyData::SafeDownCast(_Domain);
+  if (polydata) polydata->BuildLinks();
+  vtkUnstructuredGrid *grid = vtkUnstructuredGrid::SafeDownCast(_Domain);
+  if (grid) grid->BuildLinks();
+
+  // Cell locator is built on first query of a map value at an arbitrary point
+  _Locator = NewShared<CellLocator>();
+}
+
+// -----------------------------------------------------------------------------
+void PiecewiseLinearMap::BuildLocator() const
+{
+  CellLocator &locator = *_Locator;
+  if (locator.Built.load(std::memory_order_acquire)) return;
+  std::lock_guard<std::mutex> lock(locator.Mutex);
+  if (locator.Built.load(std::memory_order_relaxed)) return;
+
   // Build cell locator
-  _Locator = vtkSmartPointer<vtkCellLocator>::New();
-  _Locator->SetDataSet(_Domain);
-  _Locator->BuildLocator();
+  if (SimplexLocator::IsSimplicial(_Domain)) {
+    locator.Simplex = NewShared<SimplexLocator>();
+    locator.Simplex->DataSet(_Domain);
+    locator.Simplex->Tolerance2(_Tolerance2);
+    locator.Simplex->Initialize();
+  } else {
+    locator.Generic = vtkSmartPointer<vtkCellLocator>::New();
+    locator.Generic->SetDataSet(_Domain);
+    locator.Generic->BuildLocator();
+  }
+
+  locator.Built.store(true, std::memory_order_release);
 }
 
 // -----------------------------------------------------------------------------
@@ -179,50 +507,252 @@ vtkSmartPointer<vtkDataSet> PiecewiseLinearMap::Codomain() const
 // =============================================================================
 
 // -----------------------------------------------------------------------------
-bool PiecewiseLinearMap::Evaluate(double *v, double x, double y, double z) const
+PiecewiseLinearMap::EvaluationContext::EvaluationContext()
+:
+  Cell(vtkSmartPointer<vtkGenericCell>::New()),
+  CellId(-1),
+  Domain(nullptr),
+  Locator(nullptr),
+  FacePointIds(vtkSmartPointer<vtkIdList>::New()),
+  NeighborIds(vtkSmartPointer<vtkIdList>::New())
+{
+}
+
+// -----------------------------------------------------------------------------
+PiecewiseLinearMap::EvaluationContext::~EvaluationContext()
+{
+}
+
+// -----------------------------------------------------------------------------
+/// Get evaluation context of calling thread
+static PiecewiseLinearMap::EvaluationContext &ThreadLocalContext()
 {
-  vtkSmartPointer<vtkGenericCell> cell = vtkSmartPointer<vtkGenericCell>::New();
-  double p[3] = {x, y, z}, pcoords[3];
-  double *weight = new double[_MaxCellSize];
-  if (_Locator->FindCell(p, _Tolerance2, cell, pcoords, weight) == -1) {
-      for (int j = 0; j < _Values->GetNumberOfComponents(); ++j) {
-        v[j] = _OutsideValue;
+  static thread_local PiecewiseLinearMap::EvaluationContext ctx;
+  return ctx;
+}
+
+// -----------------------------------------------------------------------------
+vtkIdType PiecewiseLinearMap::FindCell(EvaluationContext &ctx, double p[3]) const
+{
+  if (ctx.Domain != _Domain.GetPointer() || ctx.Locator != _Locator.get()) {
+    ctx.Domain  = _Domain.GetPointer();
+    ctx.Locator = _Locator.get();
+    ctx.CellId  = -1;
+  }
+  if (static_cast<int>(ctx.Weights.size()) < max(_MaxCellSize, 4)) {
+    ctx.Weights.resize(max(_MaxCellSize, 4));
+  }
+  double * const weight = ctx.Weights.data();
+  int npts, m;
+
+  BuildLocator();
+
+  // Locate simplex using bounding volume hierarchy
+  if (_Locator->Simplex) {
+    const SimplexLocator &tree = *_Locator->Simplex;
+    const vtkIdType *cellPtIds;
+    npts = tree.NumberOfCellPoints();
+    // Walk from cell containing previous query point towards query point
+    if (ctx.CellId != -1) {
+      for (int step = 0; step <= _MaxWalkSteps; ++step) {
+        cellPtIds = tree.CellPointIds(ctx.CellId);
+        if (cellPtIds == nullptr) break;
+        if (tree.Weights(ctx.CellId, p, weight)) {
+          ctx.PointIds.assign(cellPtIds, cellPtIds + npts);
+          return ctx.CellId;
+        }
+        if (step == _MaxWalkSteps) break;
+        m = 0;
+        for (int i = 1; i < npts; ++i) {
+          if (weight[i] < weight[m]) m = i;
+        }
+        if (weight[m] >= .0) break;
+        ctx.FacePointIds->Reset();
+        for (int i = 0; i < npts; ++i) {
+          if (i != m) ctx.FacePointIds->InsertNextId(cellPtIds[i]);
+        }
+        _Domain->GetCellNeighbors(ctx.CellId, ctx.FacePointIds, ctx.NeighborIds);
+        if (ctx.NeighborIds->GetNumberOfIds() == 0) break;
+        ctx.CellId = ctx.NeighborIds->GetId(0);
       }
-      delete[] weight;
-      return false;
+    }
+    ctx.CellId = tree.FindCell(p, weight);
+    if (ctx.CellId != -1) {
+      cellPtIds = tree.CellPointIds(ctx.CellId);
+      ctx.PointIds.assign(cellPtIds, cellPtIds + npts);
+    }
+    return ctx.CellId;
+  }
+
+  // Locate cell using VTK cell locator
+  double pcoords[3];
+  if (ctx.CellId != -1) {
+    double closest[3], dist2;
+    int    subId;
+    for (int step = 0; step <= _MaxWalkSteps; ++step) {
+      const int inside = ctx.Cell->EvaluatePosition(p, closest, subId, pcoords, dist2, weight);
+      if (inside == 1 && dist2 <= _Tolerance2) break;
+      if (inside == -1 || step == _MaxWalkSteps) {
+        ctx.CellId = -1;
+        break;
+      }
+      // Cross face opposite to vertex with most negative barycentric coordinate
+      if      (ctx.Cell->GetCellType() == VTK_TRIANGLE) npts = 3;
+      else if (ctx.Cell->GetCellType() == VTK_TETRA)    npts = 4;
+      else npts = 0;
+      m = 0;
+      for (int i = 1; i < npts; ++i) {
+        if (weight[i] < weight[m]) m = i;
+      }
+      if (npts == 0 || weight[m] >= .0) {
+        ctx.CellId = -1;
+        break;
+      }
+      ctx.FacePointIds->Reset();
+      for (int i = 0; i < npts; ++i) {
+        if (i != m) ctx.FacePointIds->InsertNextId(ctx.Cell->GetPointId(i));
+      }
+      _Domain->GetCellNeighbors(ctx.CellId, ctx.FacePointIds, ctx.NeighborIds);
+      if (ctx.NeighborIds->GetNumberOfIds() == 0) {
+        ctx.CellId = -1;
+        break;
+      }
+      ctx.CellId = ctx.NeighborIds->GetId(0);
+      _Domain->GetCell(ctx.CellId, ctx.Cell);
+    }
+  }
+  if (ctx.CellId == -1) {
+    ctx.CellId = _Locator->Generic->FindCell(p, _Tolerance2, ctx.Cell, pcoords, weight);
   }
-  for (int j = 0; j < _Values->GetNumberOfComponents(); ++j) {
+  if (ctx.CellId != -1) {
+    vtkIdList * const ptIds = ctx.Cell->GetPointIds();
+    ctx.PointIds.resize(static_cast<size_t>(ptIds->GetNumberOfIds()));
+    for (vtkIdType i = 0; i < ptIds->GetNumberOfIds(); ++i) {
+      ctx.PointIds[i] = ptIds->GetId(i);
+    }
+  }
+  return ctx.CellId;
+}
+
+// -----------------------------------------------------------------------------
+bool PiecewiseLinearMap::Evaluate(EvaluationContext &ctx, double *v, double x, double y, double z) const
+{
+  const int dim = _Values->GetNumberOfComponents();
+  double p[3] = {x, y, z};
+  if (FindCell(ctx, p) == -1) {
+    for (int j = 0; j < dim; ++j) {
+      v[j] = _OutsideValue;
+    }
+    return false;
+  }
+  for (int j = 0; j < dim; ++j) {
     v[j] = .0;
   }
-  vtkIdList * const ptIds = cell->GetPointIds();
-  for (vtkIdType i = 0; i < ptIds->GetNumberOfIds(); ++i) {
-    for (int j = 0; j < _Values->GetNumberOfComponents(); ++j) {
-      v[j] += weight[i] * _Values->GetComponent(ptIds->GetId(i), j);
+  const double * const weight = ctx.Weights.data();
+  for (size_t i = 0; i < ctx.PointIds.size(); ++i) {
+    for (int j = 0; j < dim; ++j) {
+      v[j] += weight[i] * _Values->GetComponent(ctx.PointIds[i], j);
     }
   }
-  delete[] weight;
   return true;
 }
 
+// -----------------------------------------------------------------------------
+bool PiecewiseLinearMap::Evaluate(double *v, double x, double y, double z) const
+{
+  EvaluationContext &ctx = ThreadLocalContext();
+  return Evaluate(ctx, v, x, y, z);
+}
+
+// -----------------------------------------------------------------------------
+int PiecewiseLinearMap::Evaluate(double *v, int n, const double *x, const double *y,
+                                 const double *z, bool *inside) const
+{
+  EvaluationContext ctx;
+  const int dim = _Values->GetNumberOfComponents();
+  const double * weight;
+  vtkIdType      ptId;
+  double         p[3];
+  int            i, count = 0;
+  Array<int>     order;
+  if (n >= 64 && !IsCoherent(n, x, y, z)) MortonOrder(n, x, y, z, order);
+  for (int o = 0; o < n; ++o) {
+    i = (order.empty() ? o : order[o]);
+    p[0] = x[i], p[1] = y[i], p[2] = (z ? z[i] : .0);
+    if (FindCell(ctx, p) == -1) {
+      for (int j = 0; j < dim; ++j) {
+        v[j * n + i] = _OutsideValue;
+      }
+      if (inside) inside[i] = false;
+    } else {
+      for (int j = 0; j < dim; ++j) {
+        v[j * n + i] = .0;
+      }
+      weight = ctx.Weights.data();
+      for (size_t k = 0; k < ctx.PointIds.size(); ++k) {
+        ptId = ctx.PointIds[k];
+        for (int j = 0; j < dim; ++j) {
+          v[j * n + i] += weight[k] * _Values->GetComponent(ptId, j);
+        }
+      }
+      if (inside) inside[i] = true;
+      ++count;
+    }
+  }
+  return count;
+}
+
 // -----------------------------------------------------------------------------
 double PiecewiseLinearMap::Evaluate(double x, double y, double z, int l) const
 {
-  vtkSmartPointer<vtkGenericCell> cell = vtkSmartPointer<vtkGenericCell>::New();
-  double p[3] = {x, y, z}, pcoords[3];
-  double *weight = new double[_MaxCellSize];
-  if (_Locator->FindCell(p, _Tolerance2, cell, pcoords, weight) == -1) {
-      delete[] weight;
-      return _OutsideValue;
+  EvaluationContext &ctx = ThreadLocalContext();
+  double p[3] = {x, y, z};
+  if (FindCell(ctx, p) == -1) {
+    return _OutsideValue;
   }
   double value = .0;
-  vtkIdList * const ptIds = cell->GetPointIds();
-  for (vtkIdType i = 0; i < ptIds->GetNumberOfIds(); ++i) {
-    value += weight[i] * _Values->GetComponent(ptIds->GetId(i), l);
+  const double * const weight = ctx.Weights.data();
+  for (size_t i = 0; i < ctx.PointIds.size(); ++i) {
+    value += weight[i] * _Values->GetComponent(ctx.PointIds[i], l);
   }
-  delete[] weight;
   return value;
 }
 
+// -----------------------------------------------------------------------------
+template <class TVoxel>
+void PiecewiseLinearMap::EvaluateLattice(GenericImage<TVoxel> &f, int l, vtkSmartPointer<vtkPointSet> m) const
+{
+  const ImageAttributes &lattice = f.Attributes();
+  if (l >= NumberOfComponents() || l + lattice._t > NumberOfComponents()) {
+    cerr << this->NameOfType() << "::Evaluate: Component index out of range" << endl;
+    exit(1);
+  }
+  BuildLocator();
+  const int dim = (lattice._z > 1 ? 3 : 2);
+  if (!_Locator->Simplex || _Locator->Simplex->Dimension() != dim) {
+    Mapping::Evaluate(f, l, m);
+    return;
+  }
+  vtkSmartPointer<vtkImageData> mask;
+  if (m) {
+    mask = NewVtkMask(lattice._x, lattice._y, lattice._z);
+    ImageStencilToMask(ImageStencil(mask, WorldToImage(m, &f)), mask);
+  }
+  RasterizeCells(this, f, l, mask, _Locator->Simplex->Tolerance());
+}
+
+// -----------------------------------------------------------------------------
+void PiecewiseLinearMap::Evaluate(GenericImage<float> &f, int l, vtkSmartPointer<vtkPointSet> m) const
+{
+  EvaluateLattice(f, l, m);
+}
+
+// -----------------------------------------------------------------------------
+void PiecewiseLinearMap::Evaluate(GenericImage<double> &f, int l, vtkSmartPointer<vtkPointSet> m) const
+{
+  EvaluateLattice(f, l, m);
+}
+
 // =============================================================================
 // I/O
 // =============================================================================
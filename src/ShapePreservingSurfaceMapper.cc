@@ -20,14 +20,28 @@
 #include "mirtk/ShapePreservingSurfaceMapper.h"
 
 #include "mirtk/Math.h"
-#include "mirtk/Matrix.h"
-#include "mirtk/Vector3D.h"
+#include "mirtk/VtkMath.h"
 #include "mirtk/Triangle.h"
+#include "mirtk/TriangleMeshGeometry.h"
 
 
 namespace mirtk {
 
 
+// =============================================================================
+// Auxiliaries
+// =============================================================================
+
+namespace ShapePreservingSurfaceMapperUtils {
+
+
+/// Maximum node degree for which the scratch memory of Weights is on the stack
+const int _MaxStackDegree = 32;
+
+
+} // namespace ShapePreservingSurfaceMapperUtils
+using namespace ShapePreservingSurfaceMapperUtils;
+
 // =============================================================================
 // Construction/destruction
 // =============================================================================
@@ -67,10 +81,26 @@ ShapePreservingSurfaceMapper::~ShapePreservingSurfaceMapper()
 {
 }
 
+// -----------------------------------------------------------------------------
+LinearFixedBoundarySurfaceMapper *ShapePreservingSurfaceMapper::NewCopy() const
+{
+  return new ShapePreservingSurfaceMapper(*this);
+}
+
 // =============================================================================
 // Execution
 // =============================================================================
 
+// -----------------------------------------------------------------------------
+void ShapePreservingSurfaceMapper::ComputeMap()
+{
+  _Geometry = NewShared<TriangleMeshGeometry>(_Surface, _EdgeTable);
+  _Geometry->TriangleGeometry(false);
+  _Geometry->Run();
+  NonSymmetricWeightsSurfaceMapper::ComputeMap();
+  _Geometry = nullptr;
+}
+
 // -----------------------------------------------------------------------------
 void ShapePreservingSurfaceMapper
 ::Weights(int i, const int *j, double *w_i, int d_i) const
@@ -80,38 +110,51 @@ void ShapePreservingSurfaceMapper
     exit(1);
   }
 
+  // Scratch memory for side lengths, arcs, and projected points, where
+  // stack memory is used unless the node degree is unusually high
+  double        buffer[4 * _MaxStackDegree];
+  Array<double> heap;
+  double       *l = buffer;
+  if (d_i > _MaxStackDegree) {
+    heap.resize(4 * d_i);
+    l = heap.data();
+  }
+  double * const a = l + d_i;
+  double * const p = a + d_i;
+
   // Compute side lengths and arcs
-  Vector l(d_i);
-  Vector a(d_i);
+  double sum = 0.;
   {
-    const class Point q = Point(i);
-    class Point       p0, p1, p2;
-    Vector3D<double>  e0, e1, e2;
-    p0 = Point(j[0]);
-    e0 = Vector3D<double>(p0 - q);
-    e0.Normalize();
-    p1 = p0, e1 = e0;
+    const TriangleMeshGeometry &geometry = *_Geometry;
+    const double * const x = geometry.X().data();
+    const double * const y = geometry.Y().data();
+    const double * const z = geometry.Z().data();
+    double e0[3], e1[3], e2[3];
+    e0[0] = x[j[0]] - x[i], e0[1] = y[j[0]] - y[i], e0[2] = z[j[0]] - z[i];
+    vtkMath::Normalize(e0);
+    e1[0] = e0[0], e1[1] = e0[1], e1[2] = e0[2];
     for (int k = 1; k < d_i; ++k) {
-      p2 = Point(j[k]);
-      e2 = Vector3D<double>(p2 - q);
-      e2.Normalize();
-      l(k-1) = p1.Distance(p2);
-      a(k-1) = acos(clamp(e1.DotProduct(e2), -1., 1.));
-      p1 = p2, e1 = e2;
+      e2[0] = x[j[k]] - x[i], e2[1] = y[j[k]] - y[i], e2[2] = z[j[k]] - z[i];
+      vtkMath::Normalize(e2);
+      l[k-1] = sqrt(geometry.Distance2(j[k-1], j[k]));
+      a[k-1] = acos(clamp(vtkMath::Dot(e1, e2), -1., 1.));
+      sum += a[k-1];
+      e1[0] = e2[0], e1[1] = e2[1], e1[2] = e2[2];
     }
-    l(d_i-1) = p1.Distance(p0);
-    a(d_i-1) = acos(clamp(e1.DotProduct(e0), -1., 1.));
+    l[d_i-1] = sqrt(geometry.Distance2(j[d_i-1], j[0]));
+    a[d_i-1] = acos(clamp(vtkMath::Dot(e1, e0), -1., 1.));
+    sum += a[d_i-1];
   }
 
   // Step i) Project subgraph into plane
-  Matrix p(2, d_i);
   {
     double alpha = 0.;
-    a *= two_pi / a.Sum();
+    const double scale = two_pi / sum;
     for (int k = 0; k < d_i; ++k) {
-      p.Col(k)[0] = l(k) * cos(alpha);
-      p.Col(k)[1] = l(k) * sin(alpha);
-      alpha += a(k);
+      a[k] *= scale;
+      p[2*k  ] = l[k] * cos(alpha);
+      p[2*k+1] = l[k] * sin(alpha);
+      alpha += a[k];
     }
   }
 
@@ -122,17 +165,20 @@ void ShapePreservingSurfaceMapper
     w_i[k] = 0.;
   }
   for (int c1 = 0, c2, c3; c1 < d_i; ++c1) {
-    alpha = a(c1);
+    alpha = a[c1];
     c3 = (c1 + 1) % d_i;
     while (alpha < pi) {
-      alpha += a(c3);
+      alpha += a[c3];
       c3 = (c3 + 1) % d_i;
     }
     c2 = (c3 == 0 ? d_i : c3) - 1;
-    area  = Triangle::Area2D(p.Col(c1), p.Col(c2), p.Col(c3));
-    area1 = Triangle::Area2D(center,    p.Col(c2), p.Col(c3));
-    area2 = Triangle::Area2D(p.Col(c1), center,    p.Col(c3));
-    area3 = Triangle::Area2D(p.Col(c1), p.Col(c2), center);
+    const double * const p1 = p + 2 * c1;
+    const double * const p2 = p + 2 * c2;
+    const double * const p3 = p + 2 * c3;
+    area  = Triangle::Area2D(p1,     p2,     p3);
+    area1 = Triangle::Area2D(center, p2,     p3);
+    area2 = Triangle::Area2D(p1,     center, p3);
+    area3 = Triangle::Area2D(p1,     p2,     center);
     w_i[c1] += area1 / area;
     w_i[c2] += area2 / area;
     w_i[c3] += area3 / area;
@@ -142,5 +188,4 @@ void ShapePreservingSurfaceMapper
   }
 }
 
-
 } // namespace mirtk
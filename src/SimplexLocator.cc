@@ -0,0 +1,335 @@
+/*
+ * Medical Image Registration ToolKit (MIRTK)
+ *
+ * Copyright 2013-2016 Imperial College London
+ * Copyright 2013-2016 Andreas Schuh
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mirtk/SimplexLocator.h"
+
+#include "mirtk/Math.h"
+#include "mirtk/Algorithm.h"
+
+#include "vtkNew.h"
+#include "vtkIdList.h"
+#include "vtkCellType.h"
+
+
+namespace mirtk {
+
+
+// =============================================================================
+// Auxiliaries
+// =============================================================================
+
+namespace SimplexLocatorUtils {
+
+
+// -----------------------------------------------------------------------------
+/// Simplex attributes used during construction of the hierarchy
+struct SimplexInfo
+{
+  vtkIdType CellId;
+  double    Bounds[6];
+  double    Center[3];
+};
+
+// -----------------------------------------------------------------------------
+/// Compare simplices by coordinate of their center along a given axis
+struct CompareCenter
+{
+  int _Axis;
+
+  bool operator ()(const SimplexInfo &a, const SimplexInfo &b) const
+  {
+    return a.Center[_Axis] < b.Center[_Axis];
+  }
+};
+
+// -----------------------------------------------------------------------------
+/// Invert 3x3 matrix stored in row-major order
+///
+/// \returns Whether matrix is non-singular.
+bool Invert3x3(const double m[9], double inv[9])
+{
+  const double c0  = m[4] * m[8] - m[5] * m[7];
+  const double c1  = m[5] * m[6] - m[3] * m[8];
+  const double c2  = m[3] * m[7] - m[4] * m[6];
+  const double det = m[0] * c0 + m[1] * c1 + m[2] * c2;
+  if (det == .0 || IsNaN(det)) return false;
+  inv[0] = c0 / det;
+  inv[1] = (m[2] * m[7] - m[1] * m[8]) / det;
+  inv[2] = (m[1] * m[5] - m[2] * m[4]) / det;
+  inv[3] = c1 / det;
+  inv[4] = (m[0] * m[8] - m[2] * m[6]) / det;
+  inv[5] = (m[2] * m[3] - m[0] * m[5]) / det;
+  inv[6] = c2 / det;
+  inv[7] = (m[1] * m[6] - m[0] * m[7]) / det;
+  inv[8] = (m[0] * m[4] - m[1] * m[3]) / det;
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+/// Recursively build subtree of bounding volume hierarchy
+///
+/// \returns Index of root node of subtree.
+int BuildNode(Array<SimplexLocator::Node> &nodes, Array<SimplexInfo> &cells,
+              int begin, int end, int max_size, double margin)
+{
+  const int index = static_cast<int>(nodes.size());
+  nodes.push_back(SimplexLocator::Node());
+
+  double bounds[6], center[6];
+  for (int c = 0; c < 3; ++c) {
+    bounds[2*c] = center[2*c] = + inf;
+    bounds[2*c+1] = center[2*c+1] = - inf;
+  }
+  for (int i = begin; i < end; ++i) {
+    const SimplexInfo &cell = cells[i];
+    for (int c = 0; c < 3; ++c) {
+      bounds[2*c  ] = min(bounds[2*c  ], cell.Bounds[2*c  ]);
+      bounds[2*c+1] = max(bounds[2*c+1], cell.Bounds[2*c+1]);
+      center[2*c  ] = min(center[2*c  ], cell.Center[c]);
+      center[2*c+1] = max(center[2*c+1], cell.Center[c]);
+    }
+  }
+  for (int c = 0; c < 3; ++c) {
+    nodes[index].Bounds[2*c  ] = bounds[2*c  ] - margin;
+    nodes[index].Bounds[2*c+1] = bounds[2*c+1] + margin;
+  }
+  nodes[index].Begin = begin;
+  nodes[index].End   = end;
+  nodes[index].Right = -1;
+
+  if (end - begin > max_size) {
+    // Split at median of simplex centers along longest axis
+    CompareCenter cmp;
+    cmp._Axis = 0;
+    for (int c = 1; c < 3; ++c) {
+      if (center[2*c+1] - center[2*c] > center[2*cmp._Axis+1] - center[2*cmp._Axis]) {
+        cmp._Axis = c;
+      }
+    }
+    const int mid = begin + (end - begin) / 2;
+    nth_element(cells.begin() + begin, cells.begin() + mid, cells.begin() + end, cmp);
+    BuildNode(nodes, cells, begin, mid, max_size, margin);
+    const int right = BuildNode(nodes, cells, mid, end, max_size, margin);
+    nodes[index].Right = right;
+  }
+
+  return index;
+}
+
+
+} // namespace SimplexLocatorUtils
+using namespace SimplexLocatorUtils;
+
+// =============================================================================
+// Construction/Destruction
+// =============================================================================
+
+// -----------------------------------------------------------------------------
+void SimplexLocator::CopyAttributes(const SimplexLocator &other)
+{
+  _DataSet         = other._DataSet;
+  _MaxCellsPerNode = other._MaxCellsPerNode;
+  _Tolerance       = other._Tolerance;
+  _Tolerance2      = other._Tolerance2;
+  _Dimension       = other._Dimension;
+  _Nodes           = other._Nodes;
+  _CellIds         = other._CellIds;
+  _CellIndex       = other._CellIndex;
+  _PointIds        = other._PointIds;
+  for (int c = 0; c < 12; ++c) {
+    _Coefficients[c] = other._Coefficients[c];
+  }
+}
+
+// -----------------------------------------------------------------------------
+SimplexLocator::SimplexLocator()
+:
+  _MaxCellsPerNode(4),
+  _Tolerance(1e-3),
+  _Tolerance2(1e-9),
+  _Dimension(0)
+{
+}
+
+// -----------------------------------------------------------------------------
+SimplexLocator::SimplexLocator(const SimplexLocator &other)
+:
+  Object(other)
+{
+  CopyAttributes(other);
+}
+
+// -----------------------------------------------------------------------------
+SimplexLocator &SimplexLocator::operator =(const SimplexLocator &other)
+{
+  if (this != &other) {
+    Object::operator =(other);
+    CopyAttributes(other);
+  }
+  return *this;
+}
+
+// -----------------------------------------------------------------------------
+SimplexLocator::~SimplexLocator()
+{
+}
+
+// -----------------------------------------------------------------------------
+bool SimplexLocator::IsSimplicial(vtkDataSet *dataset)
+{
+  const vtkIdType ncells = dataset->GetNumberOfCells();
+  if (ncells == 0) return false;
+  const int type = dataset->GetCellType(0);
+  if (type != VTK_TRIANGLE && type != VTK_TETRA) return false;
+  for (vtkIdType cellId = 1; cellId < ncells; ++cellId) {
+    if (dataset->GetCellType(cellId) != type) return false;
+  }
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+void SimplexLocator::Initialize()
+{
+  if (!_DataSet) {
+    cerr << this->NameOfType() << "::Initialize: No dataset set" << endl;
+    exit(1);
+  }
+  if (!IsSimplicial(_DataSet)) {
+    cerr << this->NameOfType() << "::Initialize: Dataset must consist of either only triangles or only tetrahedra" << endl;
+    exit(1);
+  }
+  if (_MaxCellsPerNode < 1) _MaxCellsPerNode = 1;
+
+  const vtkIdType ncells = _DataSet->GetNumberOfCells();
+  _Dimension = (_DataSet->GetCellType(0) == VTK_TETRA ? 3 : 2);
+
+  // Compute affine map to barycentric coordinates of non-degenerate simplices
+  Array<SimplexInfo> cells;
+  Array<double>      coeffs(12 * ncells);
+  cells.reserve(static_cast<size_t>(ncells));
+
+  vtkNew<vtkIdList> ptIds;
+  SimplexInfo       info;
+  double            p[4][3], m[9], len;
+  for (vtkIdType cellId = 0; cellId < ncells; ++cellId) {
+    _DataSet->GetCellPoints(cellId, ptIds.GetPointer());
+    for (int i = 0; i <= _Dimension; ++i) {
+      _DataSet->GetPoint(ptIds->GetId(i), p[i]);
+    }
+    for (int r = 0; r < 3; ++r)
+    for (int c = 0; c < _Dimension; ++c) {
+      m[3 * r + c] = p[c + 1][r] - p[0][r];
+    }
+    if (_Dimension == 2) {
+      double n[3];
+      n[0] = m[3] * m[7] - m[6] * m[4];
+      n[1] = m[6] * m[1] - m[0] * m[7];
+      n[2] = m[0] * m[4] - m[3] * m[1];
+      len = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+      if (len == .0) continue;
+      m[2] = n[0] / len;
+      m[5] = n[1] / len;
+      m[8] = n[2] / len;
+    }
+    double * const a = coeffs.data() + 12 * cellId;
+    if (!Invert3x3(m, a + 3)) continue;
+    memcpy(a, p[0], 3 * sizeof(double));
+    info.CellId = cellId;
+    for (int c = 0; c < 3; ++c) {
+      info.Bounds[2*c] = info.Bounds[2*c+1] = info.Center[c] = p[0][c];
+      for (int i = 1; i <= _Dimension; ++i) {
+        info.Bounds[2*c  ] = min(info.Bounds[2*c  ], p[i][c]);
+        info.Bounds[2*c+1] = max(info.Bounds[2*c+1], p[i][c]);
+        info.Center[c] += p[i][c];
+      }
+      info.Center[c] /= _Dimension + 1;
+    }
+    // Enlarge bounds such that points within the barycentric tolerance are found
+    len = max(max(info.Bounds[1] - info.Bounds[0], info.Bounds[3] - info.Bounds[2]),
+                  info.Bounds[5] - info.Bounds[4]);
+    for (int c = 0; c < 3; ++c) {
+      info.Bounds[2*c  ] -= _Tolerance * len;
+      info.Bounds[2*c+1] += _Tolerance * len;
+    }
+    cells.push_back(info);
+  }
+
+  // Build bounding volume hierarchy
+  const double margin = sqrt(_Tolerance2);
+  _Nodes.clear();
+  if (!cells.empty()) {
+    _Nodes.reserve(4 * cells.size() / _MaxCellsPerNode + 1);
+    BuildNode(_Nodes, cells, 0, static_cast<int>(cells.size()), _MaxCellsPerNode, margin);
+  }
+
+  // Store simplex attributes in order of leaf nodes
+  const int n = static_cast<int>(cells.size());
+  _CellIds.resize(n);
+  _CellIndex.assign(static_cast<size_t>(ncells), -1);
+  _PointIds.resize(4 * n);
+  for (int c = 0; c < 12; ++c) {
+    _Coefficients[c].resize(n);
+  }
+  for (int i = 0; i < n; ++i) {
+    const vtkIdType cellId = cells[i].CellId;
+    _CellIds[i] = cellId;
+    _CellIndex[cellId] = i;
+    _DataSet->GetCellPoints(cellId, ptIds.GetPointer());
+    for (int j = 0; j < 4; ++j) {
+      _PointIds[4 * i + j] = (j <= _Dimension ? ptIds->GetId(j) : -1);
+    }
+    const double * const a = coeffs.data() + 12 * cellId;
+    for (int c = 0; c < 12; ++c) {
+      _Coefficients[c][i] = a[c];
+    }
+  }
+}
+
+// =============================================================================
+// Point location
+// =============================================================================
+
+// -----------------------------------------------------------------------------
+vtkIdType SimplexLocator::FindCell(const double p[3], double w[4]) const
+{
+  if (_Nodes.empty()) return -1;
+  int stack[128], n = 0, index;
+  stack[n++] = 0;
+  while (n > 0) {
+    index = stack[--n];
+    const Node &node = _Nodes[index];
+    if (p[0] < node.Bounds[0] || p[0] > node.Bounds[1] ||
+        p[1] < node.Bounds[2] || p[1] > node.Bounds[3] ||
+        p[2] < node.Bounds[4] || p[2] > node.Bounds[5]) {
+      continue;
+    }
+    if (node.Right == -1) {
+      for (int i = node.Begin; i < node.End; ++i) {
+        if (InsideSimplex(i, p, w)) return _CellIds[i];
+      }
+    } else {
+      stack[n++] = node.Right;
+      stack[n++] = index + 1;
+    }
+  }
+  return -1;
+}
+
+
+} // namespace mirtk
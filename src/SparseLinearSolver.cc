@@ -0,0 +1,690 @@
+/*
+ * Medical Image Registration ToolKit (MIRTK)
+ *
+ * Copyright 2013-2016 Imperial College London
+ * Copyright 2013-2016 Andreas Schuh
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mirtk/SparseLinearSolver.h"
+
+#include "mirtk/Math.h"
+#include "mirtk/Array.h"
+#include "mirtk/Parallel.h"
+
+#include "Eigen/IterativeLinearSolvers"
+
+
+namespace mirtk {
+
+
+// Global flags (cf. mirtk/Options.h)
+MIRTK_Common_EXPORT extern int verbose;
+
+
+// =============================================================================
+// Auxiliaries
+// =============================================================================
+
+namespace SparseLinearSolverUtils {
+
+
+/// Incomplete Cholesky preconditioner without reordering
+typedef Eigen::IncompleteCholesky<double, Eigen::Lower, Eigen::NaturalOrdering<int> > ICPreconditioner;
+
+/// Incomplete Cholesky preconditioner with fill-reducing reordering
+typedef Eigen::IncompleteCholesky<double, Eigen::Lower, Eigen::AMDOrdering<int> > ICAMDPreconditioner;
+
+/// Incomplete LU preconditioner with dual thresholding
+typedef Eigen::IncompleteLUT<double, int> ILUTPreconditioner;
+
+// -----------------------------------------------------------------------------
+/// Preconditioner computed and applied in single precision
+///
+/// The system matrix is converted to single precision before the computation
+/// of the preconditioner, and the preconditioner is applied to the residual
+/// converted to single precision. The iterative solver itself computes the
+/// residuals in double precision.
+template <class TPreconditioner>
+class SinglePrecisionPreconditioner
+{
+  TPreconditioner _Preconditioner;
+
+public:
+
+  typedef Eigen::SparseMatrix<float> FloatMatrix;
+
+  SinglePrecisionPreconditioner() {}
+
+  template <class MatrixType>
+  explicit SinglePrecisionPreconditioner(const MatrixType &A) { compute(A); }
+
+  TPreconditioner &Preconditioner() { return _Preconditioner; }
+
+  template <class MatrixType>
+  SinglePrecisionPreconditioner &analyzePattern(const MatrixType &A)
+  {
+    const FloatMatrix Af = A.template cast<float>();
+    _Preconditioner.analyzePattern(Af);
+    return *this;
+  }
+
+  template <class MatrixType>
+  SinglePrecisionPreconditioner &factorize(const MatrixType &A)
+  {
+    const FloatMatrix Af = A.template cast<float>();
+    _Preconditioner.factorize(Af);
+    return *this;
+  }
+
+  template <class MatrixType>
+  SinglePrecisionPreconditioner &compute(const MatrixType &A)
+  {
+    const FloatMatrix Af = A.template cast<float>();
+    _Preconditioner.compute(Af);
+    return *this;
+  }
+
+  template <class Rhs>
+  Eigen::VectorXd solve(const Rhs &b) const
+  {
+    const Eigen::VectorXf bf = b.template cast<float>();
+    const Eigen::VectorXf xf = _Preconditioner.solve(bf);
+    return xf.template cast<double>();
+  }
+
+  Eigen::ComputationInfo info() { return _Preconditioner.info(); }
+};
+
+/// Incomplete Cholesky preconditioner in single precision without reordering
+typedef SinglePrecisionPreconditioner<
+    Eigen::IncompleteCholesky<float, Eigen::Lower, Eigen::NaturalOrdering<int> >
+  > FloatICPreconditioner;
+
+/// Incomplete Cholesky preconditioner in single precision with fill-reducing reordering
+typedef SinglePrecisionPreconditioner<
+    Eigen::IncompleteCholesky<float, Eigen::Lower, Eigen::AMDOrdering<int> >
+  > FloatICAMDPreconditioner;
+
+/// Incomplete LU preconditioner in single precision with dual thresholding
+typedef SinglePrecisionPreconditioner<Eigen::IncompleteLUT<float, int> > FloatILUTPreconditioner;
+
+// -----------------------------------------------------------------------------
+/// Algebraic multigrid V-cycle with preconditioner interface of Eigen solvers
+class AMGPreconditioner
+{
+  const AlgebraicMultigrid *_Multigrid;
+
+public:
+
+  AMGPreconditioner() : _Multigrid(nullptr) {}
+
+  template <class MatrixType>
+  explicit AMGPreconditioner(const MatrixType &) : _Multigrid(nullptr) {}
+
+  void Multigrid(const AlgebraicMultigrid *amg) { _Multigrid = amg; }
+
+  template <class MatrixType>
+  AMGPreconditioner &analyzePattern(const MatrixType &) { return *this; }
+
+  template <class MatrixType>
+  AMGPreconditioner &factorize(const MatrixType &) { return *this; }
+
+  template <class MatrixType>
+  AMGPreconditioner &compute(const MatrixType &) { return *this; }
+
+  template <class Rhs>
+  AlgebraicMultigrid::Vector solve(const Rhs &b) const { return _Multigrid->Apply(b); }
+
+  Eigen::ComputationInfo info() { return Eigen::Success; }
+};
+
+// -----------------------------------------------------------------------------
+/// Both triangular parts of symmetric system matrix are stored
+const int UpLo = Eigen::Lower | Eigen::Upper;
+
+// -----------------------------------------------------------------------------
+/// Perform conjugate gradient iterations for a single right-hand side
+///
+/// \param[in]     solver Solver with computed preconditioner.
+/// \param[in]     A      System matrix.
+/// \param[in]     b      Right-hand side.
+/// \param[in,out] x      Initial guess and solution.
+/// \param[in,out] iters  Maximum number of iterations on input and
+///                       number of performed iterations on output.
+/// \param[in,out] error  Tolerance on input and estimated error on output.
+///
+/// \returns Whether the iterations converged or reached the maximum number of
+///          iterations with a finite solution. Stopping at the maximum number
+///          of iterations is not a failure, because callers limit the number
+///          of iterations to only smooth an initial guess. The estimated error
+///          is returned in either case.
+template <class TPreconditioner>
+bool Iterate(const Eigen::ConjugateGradient<SparseLinearSolver::Matrix, UpLo, TPreconditioner> &solver,
+             const SparseLinearSolver::Matrix &A, const Eigen::VectorXd &b, Eigen::VectorXd &x,
+             Eigen::Index &iters, double &error)
+{
+  const double       tol     = error;
+  const Eigen::Index maxiter = iters;
+  Eigen::internal::conjugate_gradient(A, b, x, solver.preconditioner(), iters, error);
+  return (error <= tol || iters >= maxiter) && x.allFinite();
+}
+
+// -----------------------------------------------------------------------------
+/// Perform BiCGSTAB iterations for a single right-hand side
+template <class TPreconditioner>
+bool Iterate(const Eigen::BiCGSTAB<SparseLinearSolver::Matrix, TPreconditioner> &solver,
+             const SparseLinearSolver::Matrix &A, const Eigen::VectorXd &b, Eigen::VectorXd &x,
+             Eigen::Index &iters, double &error)
+{
+  const double       tol     = error;
+  const Eigen::Index maxiter = iters;
+  // Numerical issue when BiCGSTAB breaks down before maximum number of iterations
+  if (!Eigen::internal::bicgstab(A, b, x, solver.preconditioner(), iters, error)) return false;
+  return (error <= tol || iters >= maxiter) && x.allFinite();
+}
+
+// -----------------------------------------------------------------------------
+/// Perform multigrid V-cycles for a single right-hand side
+bool Iterate(const AlgebraicMultigrid &amg,
+             const SparseLinearSolver::Matrix &, const Eigen::VectorXd &b, Eigen::VectorXd &x,
+             Eigen::Index &iters, double &error)
+{
+  const double       tol     = error;
+  const Eigen::Index maxiter = iters;
+  iters = amg.Solve(b, x, static_cast<int>(maxiter), tol, &error);
+  return (error <= tol || iters >= maxiter) && x.allFinite();
+}
+
+// -----------------------------------------------------------------------------
+/// Solve linear systems of the columns of the right-hand side in parallel
+///
+/// The preconditioner or multigrid hierarchy of the solver is shared by all
+/// threads, whereas each thread iterates on its own columns.
+template <class TSolver>
+struct SolveColumnsIteratively
+{
+  const TSolver                    *_Solver;
+  const SparseLinearSolver::Matrix *_Matrix;
+  const SparseLinearSolver::Values *_RightHandSide;
+  SparseLinearSolver::Values       *_Solution;
+  Eigen::Index                      _MaxNumberOfIterations;
+  double                            _Tolerance;
+  Array<int>                       *_NumberOfIterations;
+  Array<double>                    *_Error;
+  Array<int>                       *_Success;
+
+  void operator ()(const blocked_range<int> &cols) const
+  {
+    Eigen::VectorXd b, x;
+    Eigen::Index    iters;
+    double          error;
+    for (int j = cols.begin(); j != cols.end(); ++j) {
+      b     = _RightHandSide->col(j);
+      x     = _Solution->col(j);
+      iters = _MaxNumberOfIterations;
+      error = _Tolerance;
+      (*_Success)[j] = Iterate(*_Solver, *_Matrix, b, x, iters, error);
+      (*_NumberOfIterations)[j] = static_cast<int>(iters);
+      (*_Error)[j] = error;
+      _Solution->col(j) = x;
+    }
+  }
+};
+
+// -----------------------------------------------------------------------------
+/// Solve linear system with multiple right-hand sides iteratively
+///
+/// \returns Whether the iterations converged for all columns.
+template <class TSolver>
+bool SolveColumns(const TSolver &solver, const SparseLinearSolver::Matrix &A,
+                  const SparseLinearSolver::Values &b, SparseLinearSolver::Values &x,
+                  Eigen::Index maxiter, double tol, int &iters, double &error)
+{
+  const int m = static_cast<int>(b.cols());
+  Array<int>    niters(m, 0);
+  Array<double> errors(m, .0);
+  Array<int>    success(m, 1);
+
+  SolveColumnsIteratively<TSolver> solve;
+  solve._Solver                = &solver;
+  solve._Matrix                = &A;
+  solve._RightHandSide         = &b;
+  solve._Solution              = &x;
+  solve._MaxNumberOfIterations = maxiter;
+  solve._Tolerance             = tol;
+  solve._NumberOfIterations    = &niters;
+  solve._Error                 = &errors;
+  solve._Success               = &success;
+  parallel_for(blocked_range<int>(0, m), solve);
+
+  bool ok = true;
+  iters = 0, error = .0;
+  for (int j = 0; j < m; ++j) {
+    iters = max(iters, niters[j]);
+    error = max(error, errors[j]);
+    if (!success[j]) ok = false;
+  }
+  return ok;
+}
+
+
+} // namespace SparseLinearSolverUtils
+using namespace SparseLinearSolverUtils;
+
+// =============================================================================
+// Construction/destruction
+// =============================================================================
+
+// -----------------------------------------------------------------------------
+void SparseLinearSolver::CopyAttributes(const SparseLinearSolver &other)
+{
+  _Type                  = other._Type;
+  _Symmetric             = other._Symmetric;
+  _MaxNumberOfIterations = other._MaxNumberOfIterations;
+  _Tolerance             = other._Tolerance;
+  _Preconditioner        = other._Preconditioner;
+  _Reordering            = other._Reordering;
+  _DropTolerance         = other._DropTolerance;
+  _FillFactor            = other._FillFactor;
+  _MixedPrecision        = other._MixedPrecision;
+  _UsedType              = other._UsedType;
+  _NumberOfIterations    = other._NumberOfIterations;
+  _Error                 = other._Error;
+  Reset();
+}
+
+// -----------------------------------------------------------------------------
+SparseLinearSolver::SparseLinearSolver(LinearSolverType type, bool symmetric)
+:
+  _Type(type),
+  _Symmetric(symmetric),
+  _MaxNumberOfIterations(-1),
+  _Tolerance(-1.),
+  _Preconditioner(Preconditioner_Default),
+  _Reordering(true),
+  _DropTolerance(1e-4),
+  _FillFactor(10),
+  _MixedPrecision(false),
+  _UsedType(LinearSolver_Default),
+  _NumberOfIterations(0),
+  _Error(nan),
+  _AnalyzedLU(false),
+  _AnalyzedLDLT(false),
+  _AnalyzedLLT(false),
+  _AnalyzedFloatLU(false),
+  _AnalyzedFloatLDLT(false),
+  _AnalyzedFloatLLT(false),
+  _AnalyzedAMG(false)
+{
+}
+
+// -----------------------------------------------------------------------------
+SparseLinearSolver::SparseLinearSolver(const SparseLinearSolver &other)
+:
+  Object(other)
+{
+  CopyAttributes(other);
+}
+
+// -----------------------------------------------------------------------------
+SparseLinearSolver &SparseLinearSolver::operator =(const SparseLinearSolver &other)
+{
+  if (this != &other) {
+    Object::operator =(other);
+    CopyAttributes(other);
+  }
+  return *this;
+}
+
+// -----------------------------------------------------------------------------
+SparseLinearSolver::~SparseLinearSolver()
+{
+}
+
+// -----------------------------------------------------------------------------
+void SparseLinearSolver::Reset()
+{
+  _AnalyzedLU   = false;
+  _AnalyzedLDLT = false;
+  _AnalyzedLLT  = false;
+  _AnalyzedAMG  = false;
+
+  _AnalyzedFloatLU   = false;
+  _AnalyzedFloatLDLT = false;
+  _AnalyzedFloatLLT  = false;
+}
+
+// =============================================================================
+// Solver
+// =============================================================================
+
+// -----------------------------------------------------------------------------
+LinearSolverType SparseLinearSolver::SolverType() const
+{
+  if (_Type != LinearSolver_Default) return _Type;
+  if (_MaxNumberOfIterations < 0 || _MaxNumberOfIterations == 1) {
+    return (_Symmetric ? LinearSolver_LDLT : LinearSolver_LU);
+  }
+  return (_Symmetric ? LinearSolver_CG : LinearSolver_BiCGSTAB);
+}
+
+// -----------------------------------------------------------------------------
+LinearSolverPreconditioner SparseLinearSolver::PreconditionerType() const
+{
+  if (SolverType() == LinearSolver_AMG) return Preconditioner_None;
+  if (_Preconditioner == Preconditioner_Default) return Preconditioner_Jacobi;
+  return _Preconditioner;
+}
+
+// -----------------------------------------------------------------------------
+template <class TSolver>
+bool SparseLinearSolver
+::Factorize(TSolver &solver, bool &analyzed, const typename TSolver::MatrixType &A)
+{
+  if (!analyzed) {
+    solver.analyzePattern(A);
+    analyzed = true;
+  }
+  solver.factorize(A);
+  return solver.info() == Eigen::Success;
+}
+
+// -----------------------------------------------------------------------------
+template <class TSolver>
+bool SparseLinearSolver
+::SolveDirectly(TSolver &solver, bool &analyzed, const Matrix &A, const Values &b, Values &x)
+{
+  if (!Factorize(solver, analyzed, A)) return false;
+  x = solver.solve(b);
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+template <class TSolver>
+bool SparseLinearSolver
+::SolveByRefinement(TSolver &solver, bool &analyzed, const Matrix &A, const Values &b, Values &x)
+{
+  const FloatMatrix Af = A.cast<float>();
+  if (!Factorize(solver, analyzed, Af)) return false;
+
+  const int    maxiter = (_MaxNumberOfIterations > 1 ? _MaxNumberOfIterations : 20);
+  const double tol     = (_Tolerance > 0. ? _Tolerance : 1e-10);
+
+  Eigen::RowVectorXd bnorm = b.colwise().norm();
+  for (int j = 0; j < bnorm.size(); ++j) {
+    if (bnorm(j) == .0) bnorm(j) = 1.;
+  }
+
+  // Correct solution by solving for the error of the current residual,
+  // where the residual is computed in double precision
+  Values          r = b;
+  Eigen::MatrixXf rf, dx;
+  x.setZero(b.rows(), b.cols());
+  _Error = inf;
+  while (true) {
+    rf = r.cast<float>();
+    dx = solver.solve(rf);
+    x += dx.cast<double>();
+    r  = b - A * x;
+    const double error = r.colwise().norm().cwiseQuotient(bnorm).maxCoeff();
+    if (!(error < _Error)) {
+      // Discard correction which did not reduce the error
+      x -= dx.cast<double>();
+      break;
+    }
+    _Error = error;
+    if (_Error <= tol || _NumberOfIterations >= maxiter) break;
+    ++_NumberOfIterations;
+  }
+  return _Error <= tol;
+}
+
+// -----------------------------------------------------------------------------
+template <class TFloatSolver, class TSolver>
+bool SparseLinearSolver
+::SolveMixedPrecision(TFloatSolver &fsolver, bool &fanalyzed, TSolver &solver, bool &analyzed,
+                      const Matrix &A, const Values &b, Values &x)
+{
+  if (SolveByRefinement(fsolver, fanalyzed, A, b, x)) return true;
+  if (verbose) {
+    cout << "\n  Iterative refinement of single precision " << ToString(_UsedType)
+         << " factorization did not converge (error = " << _Error
+         << "), using double precision instead" << endl;
+  }
+  _NumberOfIterations = 0;
+  _Error              = nan;
+  return SolveDirectly(solver, analyzed, A, b, x);
+}
+
+// -----------------------------------------------------------------------------
+bool SparseLinearSolver::SetupAMG(const Matrix &A)
+{
+  bool ok;
+  if (_AnalyzedAMG) {
+    ok = _AMG.Update(A);
+  } else {
+    ok = _AMG.Setup(A);
+    _AnalyzedAMG = true;
+  }
+  if (!ok) {
+    cerr << NameOfType() << "::Solve: Failed to factorize coarsest level system of algebraic multigrid" << endl;
+    _AnalyzedAMG = false;
+    return false;
+  }
+  if (verbose > 1) {
+    cout << "  No. of multigrid levels      = " << _AMG.NumberOfLevels() << "\n";
+    cout << "  Operator complexity          = " << _AMG.OperatorComplexity() << "\n";
+    cout.flush();
+  }
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+template <class TSolver>
+bool SparseLinearSolver
+::SolveIteratively(TSolver &solver, const Matrix &A, const Values &b, Values &x)
+{
+  if (_MaxNumberOfIterations > 0 ) solver.setMaxIterations(_MaxNumberOfIterations);
+  if (_Tolerance             > 0.) solver.setTolerance(_Tolerance);
+  solver.compute(A);
+  if (solver.info() != Eigen::Success) {
+    cerr << NameOfType() << "::Solve: Failed to compute "
+         << ToString(PreconditionerType()) << " preconditioner" << endl;
+    return false;
+  }
+  return SolveColumns(solver, A, b, x, solver.maxIterations(), solver.tolerance(),
+                      _NumberOfIterations, _Error);
+}
+
+// -----------------------------------------------------------------------------
+bool SparseLinearSolver::Solve(const Matrix &A, const Values &b, Values &x)
+{
+  _UsedType           = SolverType();
+  _NumberOfIterations = 0;
+  _Error              = nan;
+
+  if (!_Symmetric && (_UsedType == LinearSolver_LDLT ||
+                      _UsedType == LinearSolver_LLT  ||
+                      _UsedType == LinearSolver_CG)) {
+    cerr << NameOfType() << "::Solve: " << ToString(_UsedType)
+         << " solver requires a symmetric system matrix" << endl;
+    exit(1);
+  }
+  if (!_Symmetric && _UsedType == LinearSolver_AMG) {
+    cerr << NameOfType() << "::Solve: AMG solver requires a symmetric system matrix" << endl;
+    exit(1);
+  }
+  if (!_Symmetric && IsIterativeLinearSolver(_UsedType) &&
+      (PreconditionerType() == Preconditioner_IC || PreconditionerType() == Preconditioner_AMG)) {
+    cerr << NameOfType() << "::Solve: " << ToString(PreconditionerType())
+         << " preconditioner requires a symmetric system matrix" << endl;
+    exit(1);
+  }
+  if (_UsedType == LinearSolver_CG && PreconditionerType() == Preconditioner_ILUT) {
+    cerr << NameOfType() << "::Solve: ILUT preconditioner is not symmetric, use BiCGSTAB solver instead of CG" << endl;
+    exit(1);
+  }
+
+  switch (_UsedType) {
+
+    // Sparse Cholesky factorization
+    case LinearSolver_LDLT:
+    case LinearSolver_LLT: {
+      bool ok;
+      if (_UsedType == LinearSolver_LLT) {
+        if (_MixedPrecision) ok = SolveMixedPrecision(_FloatLLT, _AnalyzedFloatLLT, _LLT, _AnalyzedLLT, A, b, x);
+        else                 ok = SolveDirectly      (_LLT, _AnalyzedLLT, A, b, x);
+      } else {
+        if (_MixedPrecision) ok = SolveMixedPrecision(_FloatLDLT, _AnalyzedFloatLDLT, _LDLT, _AnalyzedLDLT, A, b, x);
+        else                 ok = SolveDirectly      (_LDLT, _AnalyzedLDLT, A, b, x);
+      }
+      if (ok) return true;
+      if (verbose) {
+        cout << "\n  " << ToString(_UsedType) << " factorization failed, using LU factorization instead" << endl;
+      }
+      _UsedType = LinearSolver_LU;
+    } // fall through to LU factorization
+
+    // Sparse LU factorization
+    case LinearSolver_LU: {
+      if (_MixedPrecision) {
+        if (!SolveMixedPrecision(_FloatLU, _AnalyzedFloatLU, _LU, _AnalyzedLU, A, b, x)) {
+          cerr << NameOfType() << "::Solve: Sparse LU factorization failed: " << _LU.lastErrorMessage() << endl;
+          return false;
+        }
+      } else {
+        if (!SolveDirectly(_LU, _AnalyzedLU, A, b, x)) {
+          cerr << NameOfType() << "::Solve: Sparse LU factorization failed: " << _LU.lastErrorMessage() << endl;
+          return false;
+        }
+      }
+    } break;
+
+    // Conjugate gradient method
+    case LinearSolver_CG: {
+      switch (PreconditionerType()) {
+        case Preconditioner_None: {
+          Eigen::ConjugateGradient<Matrix, UpLo, Eigen::IdentityPreconditioner> solver;
+          return SolveIteratively(solver, A, b, x);
+        }
+        case Preconditioner_IC: {
+          if (_MixedPrecision) {
+            if (_Reordering) {
+              Eigen::ConjugateGradient<Matrix, UpLo, FloatICAMDPreconditioner> solver;
+              return SolveIteratively(solver, A, b, x);
+            } else {
+              Eigen::ConjugateGradient<Matrix, UpLo, FloatICPreconditioner> solver;
+              return SolveIteratively(solver, A, b, x);
+            }
+          }
+          if (_Reordering) {
+            Eigen::ConjugateGradient<Matrix, UpLo, ICAMDPreconditioner> solver;
+            return SolveIteratively(solver, A, b, x);
+          } else {
+            Eigen::ConjugateGradient<Matrix, UpLo, ICPreconditioner> solver;
+            return SolveIteratively(solver, A, b, x);
+          }
+        }
+        case Preconditioner_AMG: {
+          if (!SetupAMG(A)) return false;
+          Eigen::ConjugateGradient<Matrix, UpLo, AMGPreconditioner> solver;
+          solver.preconditioner().Multigrid(&_AMG);
+          return SolveIteratively(solver, A, b, x);
+        }
+        default: {
+          Eigen::ConjugateGradient<Matrix, UpLo, Eigen::DiagonalPreconditioner<double> > solver;
+          return SolveIteratively(solver, A, b, x);
+        }
+      }
+    } break;
+
+    // Bi-conjugate gradient stabilized method
+    case LinearSolver_BiCGSTAB: {
+      switch (PreconditionerType()) {
+        case Preconditioner_None: {
+          Eigen::BiCGSTAB<Matrix, Eigen::IdentityPreconditioner> solver;
+          return SolveIteratively(solver, A, b, x);
+        }
+        case Preconditioner_IC: {
+          if (_MixedPrecision) {
+            if (_Reordering) {
+              Eigen::BiCGSTAB<Matrix, FloatICAMDPreconditioner> solver;
+              return SolveIteratively(solver, A, b, x);
+            } else {
+              Eigen::BiCGSTAB<Matrix, FloatICPreconditioner> solver;
+              return SolveIteratively(solver, A, b, x);
+            }
+          }
+          if (_Reordering) {
+            Eigen::BiCGSTAB<Matrix, ICAMDPreconditioner> solver;
+            return SolveIteratively(solver, A, b, x);
+          } else {
+            Eigen::BiCGSTAB<Matrix, ICPreconditioner> solver;
+            return SolveIteratively(solver, A, b, x);
+          }
+        }
+        case Preconditioner_AMG: {
+          if (!SetupAMG(A)) return false;
+          Eigen::BiCGSTAB<Matrix, AMGPreconditioner> solver;
+          solver.preconditioner().Multigrid(&_AMG);
+          return SolveIteratively(solver, A, b, x);
+        }
+        case Preconditioner_ILUT: {
+          if (_MixedPrecision) {
+            Eigen::BiCGSTAB<Matrix, FloatILUTPreconditioner> solver;
+            solver.preconditioner().Preconditioner().setDroptol(static_cast<float>(_DropTolerance));
+            solver.preconditioner().Preconditioner().setFillfactor(_FillFactor);
+            return SolveIteratively(solver, A, b, x);
+          }
+          Eigen::BiCGSTAB<Matrix, ILUTPreconditioner> solver;
+          solver.preconditioner().setDroptol(_DropTolerance);
+          solver.preconditioner().setFillfactor(_FillFactor);
+          return SolveIteratively(solver, A, b, x);
+        }
+        default: {
+          Eigen::BiCGSTAB<Matrix, Eigen::DiagonalPreconditioner<double> > solver;
+          return SolveIteratively(solver, A, b, x);
+        }
+      }
+    } break;
+
+    // Algebraic multigrid V-cycles
+    case LinearSolver_AMG: {
+      if (!SetupAMG(A)) return false;
+      const int    maxiter = (_MaxNumberOfIterations > 0 ? _MaxNumberOfIterations : 100);
+      const double tol     = (_Tolerance > 0. ? _Tolerance : 1e-10);
+      return SolveColumns(_AMG, A, b, x, maxiter, tol, _NumberOfIterations, _Error);
+    } break;
+
+    default: {
+      cerr << NameOfType() << "::Solve: Invalid linear solver type: " << ToString(_UsedType) << endl;
+      exit(1);
+    }
+  }
+
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+bool SparseLinearSolver::Solve(const Matrix &A, const Eigen::VectorXd &b, Eigen::VectorXd &x)
+{
+  Values B = b, X = x;
+  const bool ok = Solve(A, B, X);
+  x = X.col(0);
+  return ok;
+}
+
+
+} // namespace mirtk
@@ -0,0 +1,106 @@
+/*
+ * Medical Image Registration ToolKit (MIRTK)
+ *
+ * Copyright 2013-2016 Imperial College London
+ * Copyright 2013-2016 Andreas Schuh
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mirtk/SparseSystemCache.h"
+
+#include "mirtk/Math.h"
+
+
+namespace mirtk {
+
+
+// =============================================================================
+// Auxiliaries
+// =============================================================================
+
+namespace SparseSystemCacheUtils {
+
+
+/// Mutex guarding access to list of cache entries
+std::mutex _Mutex;
+
+/// Cache entries ordered from most to least recently used
+Array<SharedPtr<SparseSystemCache::Entry> > _Entries;
+
+/// Maximum number of cache entries
+int _MaximumSize = 2;
+
+
+} // namespace SparseSystemCacheUtils
+using namespace SparseSystemCacheUtils;
+
+// =============================================================================
+// Cache
+// =============================================================================
+
+// -----------------------------------------------------------------------------
+SharedPtr<SparseSystemCache::Entry>
+SparseSystemCache::Get(size_t key, int n, int nnz, const Array<int> &index)
+{
+  std::lock_guard<std::mutex> lock(_Mutex);
+  if (_MaximumSize <= 0) {
+    return NewShared<Entry>(key, n, nnz, index);
+  }
+  for (auto it = _Entries.begin(); it != _Entries.end(); ++it) {
+    if ((*it)->Key == key) {
+      SharedPtr<Entry> entry = *it;
+      _Entries.erase(it);
+      // Discard entry of another linear system with colliding topology stamp,
+      // a client still using it keeps its own reference until it is done
+      if (!entry->Matches(key, n, nnz, index)) {
+        entry = NewShared<Entry>(key, n, nnz, index);
+      }
+      _Entries.insert(_Entries.begin(), entry);
+      return entry;
+    }
+  }
+  SharedPtr<Entry> entry = NewShared<Entry>(key, n, nnz, index);
+  _Entries.insert(_Entries.begin(), entry);
+  while (static_cast<int>(_Entries.size()) > _MaximumSize) {
+    _Entries.pop_back();
+  }
+  return entry;
+}
+
+// -----------------------------------------------------------------------------
+void SparseSystemCache::Clear()
+{
+  std::lock_guard<std::mutex> lock(_Mutex);
+  _Entries.clear();
+}
+
+// -----------------------------------------------------------------------------
+void SparseSystemCache::MaximumSize(int n)
+{
+  std::lock_guard<std::mutex> lock(_Mutex);
+  _MaximumSize = n;
+  while (static_cast<int>(_Entries.size()) > max(_MaximumSize, 0)) {
+    _Entries.pop_back();
+  }
+}
+
+// -----------------------------------------------------------------------------
+int SparseSystemCache::MaximumSize()
+{
+  std::lock_guard<std::mutex> lock(_Mutex);
+  return _MaximumSize;
+}
+
+
+} // namespace mirtk
@@ -20,7 +20,7 @@
 #include "mirtk/SpectralConformalSurfaceMapper.h"
 
 #include "mirtk/Algorithm.h"
-#include "mirtk/Triangle.h"
+#include "mirtk/CotangentLaplacian.h"
 #include "mirtk/PiecewiseLinearMap.h"
 #include "mirtk/ChordLengthBoundarySegmentParameterizer.h"
 
@@ -123,27 +123,13 @@ void SpectralConformalSurfaceMapper::AddFixedPoint(int i, double u, double v)
 // =============================================================================
 
 // -----------------------------------------------------------------------------
-double SpectralConformalSurfaceMapper::Weight(int i, int j) const
+void SpectralConformalSurfaceMapper::ComputeWeights(Array<double> &w) const
 {
-  int    k, l;
-  double a[3], b[3], c[3], w;
+  CheckTriangulated("ComputeWeights");
 
-  const int n = GetEdgeNeighborPoints(i, j, k, l);
-  if (n == 0 || n > 2) {
-    cerr << this->NameOfType() << "::Weight: Surface mesh must be triangulated!" << endl;
-    exit(1);
-  }
-
-  _Surface->GetPoint(static_cast<vtkIdType>(i), a);
-  _Surface->GetPoint(static_cast<vtkIdType>(k), b);
-  _Surface->GetPoint(static_cast<vtkIdType>(j), c);
-  w = Triangle::Cotangent(a, b, c);
-  if (n == 2) {
-    _Surface->GetPoint(static_cast<vtkIdType>(l), b);
-    w += Triangle::Cotangent(a, b, c);
-  }
-
-  return w;
+  CotangentLaplacian laplacian(_Surface, _EdgeTable);
+  laplacian.Run();
+  laplacian.GetEdgeWeights(w);
 }
 
 // -----------------------------------------------------------------------------
@@ -158,6 +144,11 @@ void SpectralConformalSurfaceMapper::Initialize()
     exit(1);
   }
 
+  // Convert IDs of fixed input surface points to IDs of reordered points
+  for (size_t i = 0; i < _FixedPoints.size(); ++i) {
+    _FixedPoints[i] = ReorderedPointId(_FixedPoints[i]);
+  }
+
   // Choose fixed points
   int s, i;
   if (NumberOfFixedPoints() == 0) {
@@ -240,7 +231,7 @@ void SpectralConformalSurfaceMapper::ComputeMap()
   const int n = NumberOfFreePoints();
   const int m = 2;
 
-  int i, j, ui, vi, uj, vj;
+  int i, j, edgeId, ui, vi, uj, vj;
 
   Matrix A(m * n, m * n);
   Vector b(m * n);
@@ -252,12 +243,15 @@ void SpectralConformalSurfaceMapper::ComputeMap()
     w.reserve(m * n * (_EdgeTable->MaxNumberOfAdjacentPoints() + 1));
     b.setZero();
 
+    Array<double> weights;
+    this->ComputeWeights(weights);
+
     EdgeIterator edgeIt(*_EdgeTable);
-    for (edgeIt.InitTraversal(); edgeIt.GetNextEdge(i, j) != -1;) {
+    for (edgeIt.InitTraversal(); (edgeId = edgeIt.GetNextEdge(i, j)) != -1;) {
       ui = FreePointIndex(i), vi = ui + n;
       uj = FreePointIndex(j), vj = uj + n;
       if (ui >= 0 || uj >= 0) {
-        w_ij  = - this->Weight(i, j);
+        w_ij  = - weights[edgeId];
         if (ui >= 0 && uj >= 0) {
           w.push_back(NZEntry(ui, uj, w_ij));
           w.push_back(NZEntry(uj, ui, w_ij));
@@ -359,6 +353,11 @@ void SpectralConformalSurfaceMapper::ComputeMap()
 // -----------------------------------------------------------------------------
 void SpectralConformalSurfaceMapper::Finalize()
 {
+  // Convert IDs of points back to IDs of input surface points
+  OriginalPointIds(_FixedPoints);
+  OriginalPointIds(_FreePoints);
+  RestorePointOrder(_PointIndex);
+
   // Assemble surface map
   SharedPtr<PiecewiseLinearMap> map = NewShared<PiecewiseLinearMap>();
   vtkSmartPointer<vtkPolyData> domain;
@@ -372,6 +371,9 @@ void SpectralConformalSurfaceMapper::Finalize()
 
   // Finalize base class
   FreeBoundarySurfaceMapper::Finalize();
+
+  // Map values in input point order
+  _Values = map->Values();
 }
 
 
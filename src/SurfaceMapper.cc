@@ -20,6 +20,10 @@
 #include "mirtk/SurfaceMapper.h"
 
 #include "mirtk/Assert.h"
+#include "mirtk/PiecewiseLinearMap.h"
+
+#include "vtkPointData.h"
+#include "vtkCellData.h"
 
 
 namespace mirtk {
@@ -35,6 +39,12 @@ void SurfaceMapper::CopyAttributes(const SurfaceMapper &other)
   _Surface   = other._Surface;
   _Boundary  = other._Boundary;
   _EdgeTable = other._EdgeTable;
+  _Ordering  = other._Ordering;
+  _Reordering     = other._Reordering;
+  _InputSurface   = other._InputSurface;
+  _InputEdgeTable = other._InputEdgeTable;
+  _InputBoundary  = other._InputBoundary;
+  _EdgeNeighborPoints = other._EdgeNeighborPoints;
 
   if (other._Output) {
     _Output = SharedPtr<Mapping>(other._Output->NewCopy());
@@ -45,6 +55,8 @@ void SurfaceMapper::CopyAttributes(const SurfaceMapper &other)
 
 // -----------------------------------------------------------------------------
 SurfaceMapper::SurfaceMapper()
+:
+  _Ordering(MeshOrdering_None)
 {
 }
 
@@ -97,6 +109,9 @@ void SurfaceMapper::Initialize()
     exit(1);
   }
 
+  // Renumber points and cells
+  this->InitializeOrdering();
+
   // Build links
   _Surface->BuildLinks();
 
@@ -109,6 +124,52 @@ void SurfaceMapper::Initialize()
   if (!_Boundary) {
     _Boundary = SharedPtr<SurfaceBoundary>(new SurfaceBoundary(_Surface, _EdgeTable));
   }
+
+  // Determine cells adjacent to each edge
+  this->InitializeEdgeNeighborPoints();
+}
+
+// -----------------------------------------------------------------------------
+void SurfaceMapper::InitializeOrdering()
+{
+  _Reordering = nullptr;
+  if (_Ordering != MeshOrdering_None) {
+    _Reordering = NewShared<MeshReordering>(_Ordering);
+    _Reordering->Input(_Surface);
+    _Reordering->Run();
+    _InputSurface   = _Surface;
+    _InputEdgeTable = _EdgeTable;
+    _InputBoundary  = _Boundary;
+    _Surface   = vtkPolyData::SafeDownCast(_Reordering->Output());
+    _EdgeTable = nullptr;
+    _Boundary  = nullptr;
+  }
+}
+
+// -----------------------------------------------------------------------------
+void SurfaceMapper::InitializeEdgeNeighborPoints()
+{
+  vtkIdType npts, *pts;
+  int       edgeId, *entry;
+
+  _EdgeNeighborPoints.resize(3 * _EdgeTable->NumberOfEdges());
+  for (size_t i = 0; i < _EdgeNeighborPoints.size(); i += 3) {
+    _EdgeNeighborPoints[i  ] =  0;
+    _EdgeNeighborPoints[i+1] = -1;
+    _EdgeNeighborPoints[i+2] = -1;
+  }
+  for (vtkIdType cellId = 0; cellId < _Surface->GetNumberOfCells(); ++cellId) {
+    _Surface->GetCellPoints(cellId, npts, pts);
+    for (vtkIdType a = 0; a < npts; ++a)
+    for (vtkIdType b = a + 1; b < npts; ++b) {
+      edgeId = _EdgeTable->EdgeId(static_cast<int>(pts[a]), static_cast<int>(pts[b]));
+      if (edgeId < 0) continue;
+      entry = _EdgeNeighborPoints.data() + 3 * edgeId;
+      if (++entry[0] < 3 && npts == 3) {
+        entry[entry[0]] = static_cast<int>(pts[3 - a - b]);
+      }
+    }
+  }
 }
 
 // -----------------------------------------------------------------------------
@@ -116,6 +177,27 @@ void SurfaceMapper::Finalize()
 {
   // Check that subclass produced output map
   mirtkAssert(_Output != nullptr, "output surface map is not nullptr");
+
+  // Restore input point order of map values and input surface attributes
+  if (_Reordering) {
+    PiecewiseLinearMap *map = dynamic_cast<PiecewiseLinearMap *>(_Output.get());
+    if (map) {
+      vtkSmartPointer<vtkPolyData> domain;
+      domain.TakeReference(_InputSurface->NewInstance());
+      domain->ShallowCopy(_InputSurface);
+      domain->GetPointData()->Initialize();
+      domain->GetCellData()->Initialize();
+      map->Domain(domain);
+      map->Values(_Reordering->RestorePointOrder(map->Values()));
+    }
+    _Surface   = _InputSurface;
+    _EdgeTable = _InputEdgeTable;
+    _Boundary  = _InputBoundary;
+    _InputSurface   = nullptr;
+    _InputEdgeTable = nullptr;
+    _InputBoundary  = nullptr;
+    _Reordering     = nullptr;
+  }
 }
 
 // =============================================================================
@@ -125,31 +207,50 @@ void SurfaceMapper::Finalize()
 // -----------------------------------------------------------------------------
 int SurfaceMapper::GetEdgeNeighborPoints(int i, int j, int &k, int &l) const
 {
-  k = l = -1;
-  unsigned short ncells1, ncells2, ncells = 0;
-  vtkIdType      *cells1, *cells2, npts, *pts, ptId;
-  _Surface->GetPointCells(static_cast<vtkIdType>(i), ncells1, cells1);
-  _Surface->GetPointCells(static_cast<vtkIdType>(j), ncells2, cells2);
-  for (unsigned short idx1 = 0; idx1 < ncells1; ++idx1) {
-    for (unsigned short idx2 = 0; idx2 < ncells2; ++idx2) {
-      if (cells1[idx1] == cells2[idx2]) {
-        ++ncells;
-        if (ncells < 3) {
-          _Surface->GetCellPoints(cells1[idx1], npts, pts);
-          if (npts == 3) {
-            if      (pts[0] != i && pts[0] != j) ptId = pts[0];
-            else if (pts[1] != i && pts[1] != j) ptId = pts[1];
-            else if (pts[2] != i && pts[2] != j) ptId = pts[2];
-            switch (ncells) {
-              case 1: k = ptId; break;
-              case 2: l = ptId; break;
-            }
-          }
-        }
-      }
+  const int edgeId = _EdgeTable->EdgeId(i, j);
+  if (edgeId < 0) {
+    k = l = -1;
+    return 0;
+  }
+  const int *entry = _EdgeNeighborPoints.data() + 3 * edgeId;
+  k = entry[1];
+  l = entry[2];
+  return entry[0];
+}
+
+// -----------------------------------------------------------------------------
+void SurfaceMapper::OriginalPointIds(Array<int> &ids) const
+{
+  if (_Reordering) {
+    for (size_t i = 0; i < ids.size(); ++i) {
+      ids[i] = OriginalPointId(ids[i]);
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+void SurfaceMapper::RestorePointOrder(Array<int> &values) const
+{
+  if (_Reordering) {
+    Array<int> restored(values.size());
+    for (size_t i = 0; i < values.size(); ++i) {
+      restored[OriginalPointId(static_cast<int>(i))] = values[i];
+    }
+    values.swap(restored);
+  }
+}
+
+// -----------------------------------------------------------------------------
+void SurfaceMapper::CheckTriangulated(const char *func) const
+{
+  // The first opposite point is only set when the edge is adjacent to a triangle
+  for (size_t e = 0; e < _EdgeNeighborPoints.size(); e += 3) {
+    const int * const entry = _EdgeNeighborPoints.data() + e;
+    if (entry[0] > 2 || entry[1] < 0) {
+      cerr << this->NameOfType() << "::" << func << ": Surface mesh must be triangulated!" << endl;
+      exit(1);
     }
   }
-  return ncells;
 }
 
 
@@ -20,11 +20,10 @@
 #include "mirtk/SymmetricWeightsSurfaceMapper.h"
 
 #include "mirtk/EdgeTable.h"
+#include "mirtk/Parallel.h"
+#include "mirtk/SparseSystemCache.h"
 
 #include "Eigen/SparseCore"
-#include "Eigen/SparseLU"
-#include "Eigen/OrderingMethods"
-#include "Eigen/IterativeLinearSolvers"
 
 
 namespace mirtk {
@@ -34,6 +33,103 @@ namespace mirtk {
 MIRTK_Common_EXPORT extern int verbose;
 
 
+// =============================================================================
+// Auxiliary functors
+// =============================================================================
+
+// -----------------------------------------------------------------------------
+/// Compute weights of edges with at least one free end point
+struct SymmetricWeightsSurfaceMapper::ComputeEdgeWeights
+{
+  const SymmetricWeightsSurfaceMapper *_Filter;
+  double                              *_Weights;
+
+  void operator ()(const blocked_range<int> &ptIds) const
+  {
+    const mirtk::EdgeTable &edgeTable = *_Filter->_EdgeTable;
+
+    int        d_i;
+    const int *j;
+
+    for (int i = ptIds.begin(); i != ptIds.end(); ++i) {
+      const bool is_free = _Filter->IsFreePoint(i);
+      edgeTable.GetAdjacentPoints(i, d_i, j);
+      for (int k = 0; k < d_i; ++k) {
+        if (i < j[k] && (is_free || _Filter->IsFreePoint(j[k]))) {
+          _Weights[edgeTable.EdgeId(i, j[k])] = _Filter->Weight(i, j[k]);
+        }
+      }
+    }
+  }
+};
+
+// -----------------------------------------------------------------------------
+/// Weight policy which looks up precomputed edge weights
+struct SymmetricWeightsSurfaceMapper::EdgeWeightArray
+{
+  const mirtk::EdgeTable *_EdgeTable;
+  const double           *_Weights;
+
+  double operator ()(int i, int j) const
+  {
+    return _Weights[_EdgeTable->EdgeId(i, j)];
+  }
+};
+
+// -----------------------------------------------------------------------------
+/// Weight policy of graph Laplacian with unit edge weights
+struct SymmetricWeightsSurfaceMapper::UnitEdgeWeight
+{
+  double operator ()(int, int) const
+  {
+    return 1.;
+  }
+};
+
+// -----------------------------------------------------------------------------
+/// Set coefficients and right-hand side of linear equations of free points,
+/// where the edge weight policy is inlined into the loop over adjacent points
+template <class TEdgeWeight>
+struct SymmetricWeightsSurfaceMapper::AssembleLinearSystem
+{
+  const SymmetricWeightsSurfaceMapper *_Filter;
+  TEdgeWeight                          _Weight;
+  Eigen::SparseMatrix<double>         *_Matrix;
+  Eigen::MatrixXd                     *_RightHandSide;
+
+  void operator ()(const blocked_range<int> &rows) const
+  {
+    const mirtk::EdgeTable &edgeTable = *_Filter->_EdgeTable;
+    const int        m         = static_cast<int>(_RightHandSide->cols());
+    const int       *offsets   = _Matrix->outerIndexPtr();
+    const int       *indices   = _Matrix->innerIndexPtr();
+    double          *values    = _Matrix->valuePtr();
+
+    int        i, c, d_i;
+    const int *j;
+    double     w_ij, w_ii;
+
+    for (int r = rows.begin(); r != rows.end(); ++r) {
+      i = _Filter->FreePointId(r);
+      edgeTable.GetAdjacentPoints(i, d_i, j);
+      w_ii = .0;
+      for (int k = 0; k < d_i; ++k) {
+        w_ij = _Weight(i, j[k]);
+        c = _Filter->FreePointIndex(j[k]);
+        if (c >= 0) {
+          values[NonZeroIndex(offsets, indices, r, c)] = -w_ij;
+        } else {
+          for (int l = 0; l < m; ++l) {
+            (*_RightHandSide)(r, l) += w_ij * _Filter->GetValue(j[k], l);
+          }
+        }
+        w_ii += w_ij;
+      }
+      values[NonZeroIndex(offsets, indices, r, r)] = w_ii;
+    }
+  }
+};
+
 // =============================================================================
 // Construction/destruction
 // =============================================================================
@@ -79,60 +175,68 @@ SymmetricWeightsSurfaceMapper::~SymmetricWeightsSurfaceMapper()
 // =============================================================================
 
 // -----------------------------------------------------------------------------
-void SymmetricWeightsSurfaceMapper::ComputeMap()
+bool SymmetricWeightsSurfaceMapper::UniformWeights() const
+{
+  return false;
+}
+
+// -----------------------------------------------------------------------------
+void SymmetricWeightsSurfaceMapper::ComputeWeights(Array<double> &weights) const
 {
-  const bool use_direct_solver = (_NumberOfIterations < 0 || _NumberOfIterations == 1);
+  weights.assign(_EdgeTable->NumberOfEdges(), .0);
+  ComputeEdgeWeights eval;
+  eval._Filter  = this;
+  eval._Weights = weights.data();
+  parallel_for(blocked_range<int>(0, NumberOfPoints()), eval);
+}
 
+// -----------------------------------------------------------------------------
+void SymmetricWeightsSurfaceMapper::ComputeMap()
+{
   typedef Eigen::MatrixXd             Values;
   typedef Eigen::SparseMatrix<double> Matrix;
-  typedef Eigen::Triplet<double>      NZEntry;
 
   const int n = NumberOfFreePoints();
   const int m = NumberOfComponents();
 
-  int i, j, r, c, l;
+  int i, r, l;
+
+  // Get cached non-zero pattern and solver of linear systems with same topology
+  SharedPtr<SparseSystemCache::Entry> cache = GetSparseSystemCacheEntry();
+  std::lock_guard<std::mutex> lock(cache->Mutex);
+  if (cache->Offsets.empty()) {
+    GetSparsityPattern(cache->Offsets, cache->Indices);
+  }
 
   Matrix A(n, n);
   Values b(n, m);
   {
-    Array<NZEntry> w;
-    Array<double>  w_ii(n, .0);
-    double         w_ij; // = w_ji
-
-    w.reserve(2 * _EdgeTable->NumberOfEdges() + n);
+    // Allocate non-zero entries of system matrix
+    const Array<int> &offsets = cache->Offsets;
+    const Array<int> &indices = cache->Indices;
+    A.resizeNonZeros(offsets[n]);
+    memcpy(A.outerIndexPtr(), offsets.data(), offsets.size() * sizeof(int));
+    memcpy(A.innerIndexPtr(), indices.data(), indices.size() * sizeof(int));
     b.setZero();
 
-    EdgeIterator edgeIt(*_EdgeTable);
-    for (edgeIt.InitTraversal(); edgeIt.GetNextEdge(i, j) != -1;) {
-      r = FreePointIndex(i);
-      c = FreePointIndex(j);
-      if (r >= 0 || c >= 0) {
-        w_ij = this->Weight(i, j);
-        if (r >= 0 && c >= 0) {
-          w.push_back(NZEntry(r, c, -w_ij));
-          w.push_back(NZEntry(c, r, -w_ij));
-        } else if (r >= 0) {
-          for (l = 0; l < m; ++l) {
-            b(r, l) += w_ij * GetValue(j, l);
-          }
-        } else if (c >= 0) {
-          for (l = 0; l < m; ++l) {
-            b(c, l) += w_ij * GetValue(i, l);
-          }
-        }
-        if (r >= 0) {
-          w_ii[r] += w_ij;
-        }
-        if (c >= 0) {
-          w_ii[c] += w_ij;
-        }
-      }
-    }
-    for (r = 0; r < n; ++r) {
-      w.push_back(NZEntry(r, r, w_ii[r]));
+    // Set coefficients of each row in parallel
+    if (this->UniformWeights()) {
+      AssembleLinearSystem<UnitEdgeWeight> assemble;
+      assemble._Filter        = this;
+      assemble._Matrix        = &A;
+      assemble._RightHandSide = &b;
+      parallel_for(blocked_range<int>(0, n), assemble);
+    } else {
+      Array<double> weights;
+      this->ComputeWeights(weights);
+      AssembleLinearSystem<EdgeWeightArray> assemble;
+      assemble._Filter            = this;
+      assemble._Weight._EdgeTable = _EdgeTable.get();
+      assemble._Weight._Weights   = weights.data();
+      assemble._Matrix            = &A;
+      assemble._RightHandSide     = &b;
+      parallel_for(blocked_range<int>(0, n), assemble);
     }
-
-    A.setFromTriplets(w.begin(), w.end());
   }
 
   if (verbose) {
@@ -144,28 +248,27 @@ void SymmetricWeightsSurfaceMapper::ComputeMap()
     cout.flush();
   }
 
+  // Solve linear system, where system matrix is symmetric
+  SparseLinearSolver &solver = cache->Solver;
+  solver.Type(_LinearSolver);
+  solver.Preconditioner(_Preconditioner);
+  solver.Symmetric(true);
+  solver.MaxNumberOfIterations(_NumberOfIterations);
+  solver.Tolerance(_Tolerance);
+  solver.MixedPrecision(_MixedPrecision);
+
   Values x(n, m);
-  int    niter = 0;
-  double error = nan;
-
-  if (use_direct_solver) {
-    Eigen::SparseLU<Matrix> solver;
-    solver.analyzePattern(A);
-    solver.factorize(A);
-    x = solver.solve(b);
-  } else {
-    Eigen::ConjugateGradient<Matrix> solver(A);
-    if (_NumberOfIterations > 0 ) solver.setMaxIterations(_NumberOfIterations);
-    if (_Tolerance          > 0.) solver.setTolerance(_Tolerance);
+  if (solver.IsIterative()) {
     for (r = 0; r < n; ++r) {
       i = FreePointId(r);
       for (l = 0; l < m; ++l) {
         x(r, l) = GetValue(i, l);
       }
     }
-    x = solver.solveWithGuess(b, x);
-    niter = solver.iterations();
-    error = solver.error();
+  }
+  if (!solver.Solve(A, b, x)) {
+    cerr << this->NameOfType() << "::ComputeMap: Failed to solve linear system" << endl;
+    exit(1);
   }
 
   for (r = 0; r < n; ++r) {
@@ -175,9 +278,16 @@ void SymmetricWeightsSurfaceMapper::ComputeMap()
     }
   }
 
-  if (verbose && !use_direct_solver) {
-    cout << "  No. of iterations            = " << niter << "\n";
-    cout << "  Estimated error              = " << error << "\n";
+  if (verbose) {
+    cout << "  Linear solver                = " << ToString(solver.UsedType()) << "\n";
+    if (IsIterativeLinearSolver(solver.UsedType())) {
+      cout << "  Preconditioner               = " << ToString(solver.PreconditionerType()) << "\n";
+      cout << "  No. of iterations            = " << solver.NumberOfIterations() << "\n";
+      cout << "  Estimated error              = " << solver.Error() << "\n";
+    } else if (solver.MixedPrecision()) {
+      cout << "  No. of refinement steps      = " << solver.NumberOfIterations() << "\n";
+      cout << "  Estimated error              = " << solver.Error() << "\n";
+    }
     cout.flush();
   }
 }
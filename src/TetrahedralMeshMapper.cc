@@ -40,7 +40,9 @@ namespace mirtk {
 // -----------------------------------------------------------------------------
 void TetrahedralMeshMapper::CopyAttributes(const TetrahedralMeshMapper &other)
 {
-  _InputMask = other._InputMask;
+  _InputMask  = other._InputMask;
+  _Ordering   = other._Ordering;
+  _Reordering = other._Reordering;
   if (other._Volume && other._Coords && other._BoundaryMask) {
     _Coords.TakeReference(other._Coords->NewInstance());
     _Coords->DeepCopy(other._Coords);
@@ -63,6 +65,8 @@ void TetrahedralMeshMapper::CopyAttributes(const TetrahedralMeshMapper &other)
 
 // -----------------------------------------------------------------------------
 TetrahedralMeshMapper::TetrahedralMeshMapper()
+:
+  _Ordering(MeshOrdering_None)
 {
 }
 
@@ -112,6 +116,16 @@ void TetrahedralMeshMapper::Initialize()
   map_index = input->GetPointData()->AddArray(_InputMap);
   if (_InputMask) mask_index = input->GetPointData()->AddArray(_InputMask);
   _Volume = Tetrahedralize(input);
+
+  // Renumber points and cells of volume mesh
+  _Reordering = nullptr;
+  if (_Ordering != MeshOrdering_None) {
+    _Reordering = NewShared<MeshReordering>(_Ordering);
+    _Reordering->Input(_Volume);
+    _Reordering->Run();
+    _Volume = _Reordering->Output();
+  }
+
   _Coords = _Volume->GetPointData()->GetArray(map_index);
   _Coords->SetName("VolumetricMap");
 
@@ -144,6 +158,17 @@ void TetrahedralMeshMapper::Initialize()
 // -----------------------------------------------------------------------------
 void TetrahedralMeshMapper::Finalize()
 {
+  // Restore point order of tetrahedralized input domain
+  if (_Reordering) {
+    _Coords       = _Reordering->RestorePointOrder(_Coords);
+    _BoundaryMask = _Reordering->RestorePointOrder(_BoundaryMask);
+    _Volume       = _Reordering->Input();
+    _Volume->GetPointData()->Initialize();
+    _Volume->GetPointData()->AddArray(_Coords);
+    _Volume->GetPointData()->AddArray(_BoundaryMask);
+    _Reordering = nullptr;
+  }
+
   // Create output map
   SharedPtr<PiecewiseLinearMap> map = NewShared<PiecewiseLinearMap>();
   map->Domain(_Volume);
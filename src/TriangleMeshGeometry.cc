@@ -0,0 +1,300 @@
+/*
+ * Medical Image Registration ToolKit (MIRTK)
+ *
+ * Copyright 2013-2016 Imperial College London
+ * Copyright 2013-2016 Andreas Schuh
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mirtk/TriangleMeshGeometry.h"
+
+#include "mirtk/Math.h"
+#include "mirtk/Parallel.h"
+
+
+namespace mirtk {
+
+
+// =============================================================================
+// Auxiliary functors
+// =============================================================================
+
+namespace TriangleMeshGeometryUtils {
+
+
+/// Number of triangles whose corner coordinates are gathered at once
+const int _BatchSize = 64;
+
+// -----------------------------------------------------------------------------
+/// Compute corner angle tangents and double area of batches of triangles
+struct ComputeTriangleGeometry
+{
+  const double *_X;
+  const double *_Y;
+  const double *_Z;
+  const int    *_Triangles;
+  double       *_Cotangents;
+  double       *_HalfAngleTangents;
+  double       *_DoubleAreas;
+
+  void operator ()(const blocked_range<int> &triangles) const
+  {
+    // Edge vectors e0 = c - b, e1 = a - c, and e2 = b - a of triangle (a, b, c),
+    // where edge vector ek is opposite to the k-th corner
+    double e0x[_BatchSize], e0y[_BatchSize], e0z[_BatchSize];
+    double e1x[_BatchSize], e1y[_BatchSize], e1z[_BatchSize];
+    double e2x[_BatchSize], e2y[_BatchSize], e2z[_BatchSize];
+
+    for (int t0 = triangles.begin(); t0 < triangles.end(); t0 += _BatchSize) {
+      const int nb = min(_BatchSize, triangles.end() - t0);
+
+      // Gather edge vectors of batch
+      for (int k = 0; k < nb; ++k) {
+        const int * const tri = _Triangles + 3 * (t0 + k);
+        const int a = tri[0], b = tri[1], c = tri[2];
+        e0x[k] = _X[c] - _X[b], e0y[k] = _Y[c] - _Y[b], e0z[k] = _Z[c] - _Z[b];
+        e1x[k] = _X[a] - _X[c], e1y[k] = _Y[a] - _Y[c], e1z[k] = _Z[a] - _Z[c];
+        e2x[k] = _X[b] - _X[a], e2y[k] = _Y[b] - _Y[a], e2z[k] = _Z[b] - _Z[a];
+      }
+
+      // Compute angles and area of triangles in batch
+      double * const cot  = _Cotangents        + 3 * t0;
+      double * const tan2 = _HalfAngleTangents + 3 * t0;
+      double * const area = _DoubleAreas       + t0;
+      for (int k = 0; k < nb; ++k) {
+        // Dot products of the two edge vectors pointing away from each corner
+        const double da = - (e2x[k] * e1x[k] + e2y[k] * e1y[k] + e2z[k] * e1z[k]);
+        const double db = - (e0x[k] * e2x[k] + e0y[k] * e2y[k] + e0z[k] * e2z[k]);
+        const double dc = - (e1x[k] * e0x[k] + e1y[k] * e0y[k] + e1z[k] * e0z[k]);
+        // Edge lengths
+        const double l0 = sqrt(e0x[k] * e0x[k] + e0y[k] * e0y[k] + e0z[k] * e0z[k]);
+        const double l1 = sqrt(e1x[k] * e1x[k] + e1y[k] * e1y[k] + e1z[k] * e1z[k]);
+        const double l2 = sqrt(e2x[k] * e2x[k] + e2y[k] * e2y[k] + e2z[k] * e2z[k]);
+        // Norm of cross product, i.e., twice the triangle area
+        const double nx = e2y[k] * e1z[k] - e2z[k] * e1y[k];
+        const double ny = e2z[k] * e1x[k] - e2x[k] * e1z[k];
+        const double nz = e2x[k] * e1y[k] - e2y[k] * e1x[k];
+        const double a2 = sqrt(nx * nx + ny * ny + nz * nz);
+        // cot(alpha) = cos(alpha) / sin(alpha) and
+        // tan(alpha/2) = (1 - cos(alpha)) / sin(alpha)
+        cot [3 * k    ] = da / a2;
+        cot [3 * k + 1] = db / a2;
+        cot [3 * k + 2] = dc / a2;
+        tan2[3 * k    ] = (l2 * l1 - da) / a2;
+        tan2[3 * k + 1] = (l0 * l2 - db) / a2;
+        tan2[3 * k + 2] = (l1 * l0 - dc) / a2;
+        area[k] = a2;
+      }
+    }
+  }
+};
+
+// -----------------------------------------------------------------------------
+/// Compute length of each edge
+struct ComputeEdgeLengths
+{
+  const TriangleMeshGeometry *_Geometry;
+  const int                  *_Edges;
+  double                     *_EdgeLengths;
+
+  void operator ()(const blocked_range<int> &edgeIds) const
+  {
+    for (int e = edgeIds.begin(); e != edgeIds.end(); ++e) {
+      _EdgeLengths[e] = sqrt(_Geometry->Distance2(_Edges[2 * e], _Edges[2 * e + 1]));
+    }
+  }
+};
+
+
+} // namespace TriangleMeshGeometryUtils
+using namespace TriangleMeshGeometryUtils;
+
+// =============================================================================
+// Construction/destruction
+// =============================================================================
+
+// -----------------------------------------------------------------------------
+void TriangleMeshGeometry::CopyAttributes(const TriangleMeshGeometry &other)
+{
+  _Surface           = other._Surface;
+  _EdgeTable         = other._EdgeTable;
+  _TriangleGeometry  = other._TriangleGeometry;
+  _X                 = other._X;
+  _Y                 = other._Y;
+  _Z                 = other._Z;
+  _Triangles         = other._Triangles;
+  _TriangleEdges     = other._TriangleEdges;
+  _Edges             = other._Edges;
+  _Cotangents        = other._Cotangents;
+  _HalfAngleTangents = other._HalfAngleTangents;
+  _DoubleAreas       = other._DoubleAreas;
+  _EdgeLengths       = other._EdgeLengths;
+}
+
+// -----------------------------------------------------------------------------
+TriangleMeshGeometry::TriangleMeshGeometry(vtkPolyData *surface, SharedPtr<mirtk::EdgeTable> edgeTable)
+:
+  _Surface(surface),
+  _EdgeTable(edgeTable),
+  _TriangleGeometry(true)
+{
+}
+
+// -----------------------------------------------------------------------------
+TriangleMeshGeometry::TriangleMeshGeometry(const TriangleMeshGeometry &other)
+:
+  Object(other)
+{
+  CopyAttributes(other);
+}
+
+// -----------------------------------------------------------------------------
+TriangleMeshGeometry &TriangleMeshGeometry::operator =(const TriangleMeshGeometry &other)
+{
+  if (this != &other) {
+    Object::operator =(other);
+    CopyAttributes(other);
+  }
+  return *this;
+}
+
+// -----------------------------------------------------------------------------
+TriangleMeshGeometry::~TriangleMeshGeometry()
+{
+}
+
+// =============================================================================
+// Execution
+// =============================================================================
+
+// -----------------------------------------------------------------------------
+void TriangleMeshGeometry::Run()
+{
+  // Check input
+  if (!_Surface) {
+    cerr << this->NameOfType() << "::Run: Missing input surface" << endl;
+    exit(1);
+  }
+  if (!_EdgeTable) {
+    _EdgeTable = NewShared<mirtk::EdgeTable>(_Surface);
+  }
+
+  // Get point IDs of triangles
+  vtkIdType npts, *pts;
+  _Triangles.clear();
+  if (_TriangleGeometry) {
+    _Triangles.reserve(3 * _Surface->GetNumberOfPolys());
+    for (vtkIdType cellId = 0; cellId < _Surface->GetNumberOfCells(); ++cellId) {
+      _Surface->GetCellPoints(cellId, npts, pts);
+      if (npts < 3) continue;
+      if (npts > 3) {
+        cerr << this->NameOfType() << "::Run: Surface mesh must be triangulated!" << endl;
+        exit(1);
+      }
+      for (vtkIdType i = 0; i < npts; ++i) {
+        _Triangles.push_back(static_cast<int>(pts[i]));
+      }
+    }
+  }
+
+  // Get end points of edges
+  int i, j, edgeId;
+  _Edges.resize(2 * _EdgeTable->NumberOfEdges());
+  EdgeIterator edgeIt(*_EdgeTable);
+  for (edgeIt.InitTraversal(); (edgeId = edgeIt.GetNextEdge(i, j)) != -1;) {
+    _Edges[2 * edgeId    ] = min(i, j);
+    _Edges[2 * edgeId + 1] = max(i, j);
+  }
+
+  // Get edge opposite to each triangle corner
+  const int ntriangles = NumberOfTriangles();
+  _TriangleEdges.resize(3 * ntriangles);
+  for (int t = 0; t < ntriangles; ++t) {
+    const int * const tri = _Triangles.data() + 3 * t;
+    for (int c = 0; c < 3; ++c) {
+      edgeId = _EdgeTable->EdgeId(tri[(c + 1) % 3], tri[(c + 2) % 3]);
+      if (edgeId < 0) {
+        cerr << this->NameOfType() << "::Run: Edge table does not match surface mesh" << endl;
+        exit(1);
+      }
+      _TriangleEdges[3 * t + c] = edgeId;
+    }
+  }
+
+  // Copy point coordinates and compute geometry
+  Update();
+}
+
+// -----------------------------------------------------------------------------
+void TriangleMeshGeometry::Update()
+{
+  // Copy point coordinates to contiguous arrays
+  const int n = static_cast<int>(_Surface->GetNumberOfPoints());
+  _X.resize(n), _Y.resize(n), _Z.resize(n);
+  double p[3];
+  for (int ptId = 0; ptId < n; ++ptId) {
+    _Surface->GetPoint(static_cast<vtkIdType>(ptId), p);
+    _X[ptId] = p[0], _Y[ptId] = p[1], _Z[ptId] = p[2];
+  }
+
+  // Compute geometry of triangles
+  const int ntriangles = NumberOfTriangles();
+  _Cotangents.resize(3 * ntriangles);
+  _HalfAngleTangents.resize(3 * ntriangles);
+  _DoubleAreas.resize(ntriangles);
+  ComputeTriangleGeometry eval;
+  eval._X                 = _X.data();
+  eval._Y                 = _Y.data();
+  eval._Z                 = _Z.data();
+  eval._Triangles         = _Triangles.data();
+  eval._Cotangents        = _Cotangents.data();
+  eval._HalfAngleTangents = _HalfAngleTangents.data();
+  eval._DoubleAreas       = _DoubleAreas.data();
+  parallel_for(blocked_range<int>(0, ntriangles, _BatchSize), eval);
+
+  // Compute lengths of edges
+  _EdgeLengths.resize(NumberOfEdges());
+  ComputeEdgeLengths lengths;
+  lengths._Geometry    = this;
+  lengths._Edges       = _Edges.data();
+  lengths._EdgeLengths = _EdgeLengths.data();
+  parallel_for(blocked_range<int>(0, NumberOfEdges()), lengths);
+}
+
+// =============================================================================
+// Geometry
+// =============================================================================
+
+// -----------------------------------------------------------------------------
+void TriangleMeshGeometry::GetEdgeEndSums(const Array<double> &v, Array<double> &s) const
+{
+  // Note: Summation is done sequentially as it is cheap compared to the
+  //       evaluation of the triangle geometry and the scatter would otherwise
+  //       require atomic updates of the edge sums.
+  const int ntriangles = NumberOfTriangles();
+  s.assign(2 * NumberOfEdges(), .0);
+  for (int t = 0; t < ntriangles; ++t) {
+    const int * const tri = _Triangles.data() + 3 * t;
+    for (int c = 0; c < 3; ++c) {
+      const int e  = _TriangleEdges[3 * t + c];
+      const int c1 = (c + 1) % 3, i = tri[c1];
+      const int c2 = (c + 2) % 3, j = tri[c2];
+      s[2 * e + (i < j ? 0 : 1)] += v[3 * t + c1];
+      s[2 * e + (j < i ? 0 : 1)] += v[3 * t + c2];
+    }
+  }
+}
+
+
+} // namespace mirtk
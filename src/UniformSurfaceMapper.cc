@@ -59,6 +59,12 @@ UniformSurfaceMapper::~UniformSurfaceMapper()
 {
 }
 
+// -----------------------------------------------------------------------------
+LinearFixedBoundarySurfaceMapper *UniformSurfaceMapper::NewCopy() const
+{
+  return new UniformSurfaceMapper(*this);
+}
+
 // =============================================================================
 // Execution
 // =============================================================================
@@ -69,5 +75,11 @@ double UniformSurfaceMapper::Weight(int, int) const
   return 1.0;
 }
 
+// -----------------------------------------------------------------------------
+bool UniformSurfaceMapper::UniformWeights() const
+{
+  return true;
+}
+
 
 } // namespace mirtk
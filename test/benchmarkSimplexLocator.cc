@@ -0,0 +1,231 @@
+/*
+ * Medical Image Registration ToolKit (MIRTK)
+ *
+ * Copyright 2016 Imperial College London
+ * Copyright 2016 Andreas Schuh
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Compares build time and query time of SimplexLocator and vtkCellLocator
+// for a folded triangulated surface resembling a cortical surface patch and
+// for a tetrahedral mesh of a cube. The test fails when the cells found by
+// SimplexLocator do not contain the query points or when it misses points
+// found by vtkCellLocator.
+//
+// Usage: benchmarkSimplexLocator [<n>]
+//
+// where n is the number of grid points along each axis of the surface mesh
+// (default: 200). The tetrahedral mesh has n / 5 grid points along each axis.
+
+#include "mirtk/SimplexLocator.h"
+
+#include "vtkSmartPointer.h"
+#include "vtkPoints.h"
+#include "vtkCellArray.h"
+#include "vtkCellType.h"
+#include "vtkCellLocator.h"
+#include "vtkGenericCell.h"
+#include "vtkIdList.h"
+#include "vtkPolyData.h"
+#include "vtkUnstructuredGrid.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace mirtk;
+using namespace std;
+
+
+/// Number of query points
+const int NumberOfQueries = 200000;
+
+// -----------------------------------------------------------------------------
+/// Elapsed wall clock time in seconds since given start time
+double Seconds(const chrono::steady_clock::time_point &start)
+{
+  return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// -----------------------------------------------------------------------------
+/// Triangulated height field with sulci-like folds
+vtkSmartPointer<vtkDataSet> FoldedSurface(int n)
+{
+  vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+  for (int j = 0; j < n; ++j)
+  for (int i = 0; i < n; ++i) {
+    const double x = double(i) / (n - 1), y = double(j) / (n - 1);
+    points->InsertNextPoint(x, y, .05 * sin(20. * x) * cos(15. * y));
+  }
+  vtkSmartPointer<vtkCellArray> triangles = vtkSmartPointer<vtkCellArray>::New();
+  for (int j = 0; j < n - 1; ++j)
+  for (int i = 0; i < n - 1; ++i) {
+    const vtkIdType a = j * n + i, b = a + 1, c = a + n, d = c + 1;
+    const vtkIdType t1[3] = {a, b, d}, t2[3] = {a, d, c};
+    triangles->InsertNextCell(3, t1);
+    triangles->InsertNextCell(3, t2);
+  }
+  vtkSmartPointer<vtkPolyData> mesh = vtkSmartPointer<vtkPolyData>::New();
+  mesh->SetPoints(points);
+  mesh->SetPolys(triangles);
+  return mesh;
+}
+
+// -----------------------------------------------------------------------------
+/// Tetrahedral mesh of unit cube with six tetrahedra per grid cell
+vtkSmartPointer<vtkDataSet> TetrahedralCube(int n)
+{
+  const int perm[6][3] = {{0,1,2}, {0,2,1}, {1,0,2}, {1,2,0}, {2,0,1}, {2,1,0}};
+  const vtkIdType stride[3] = {1, n, n * n};
+  vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+  for (int k = 0; k < n; ++k)
+  for (int j = 0; j < n; ++j)
+  for (int i = 0; i < n; ++i) {
+    points->InsertNextPoint(double(i) / (n - 1), double(j) / (n - 1), double(k) / (n - 1));
+  }
+  vtkSmartPointer<vtkUnstructuredGrid> mesh = vtkSmartPointer<vtkUnstructuredGrid>::New();
+  mesh->SetPoints(points);
+  for (int k = 0; k < n - 1; ++k)
+  for (int j = 0; j < n - 1; ++j)
+  for (int i = 0; i < n - 1; ++i) {
+    for (int t = 0; t < 6; ++t) {
+      vtkIdType ptIds[4];
+      ptIds[0] = k * stride[2] + j * stride[1] + i;
+      for (int l = 0; l < 3; ++l) {
+        ptIds[l + 1] = ptIds[l] + stride[perm[t][l]];
+      }
+      mesh->InsertNextCell(VTK_TETRA, 4, ptIds);
+    }
+  }
+  return mesh;
+}
+
+// -----------------------------------------------------------------------------
+/// Random points inside randomly chosen cells of a simplicial mesh
+vector<double> QueryPoints(vtkDataSet *mesh)
+{
+  mt19937 rng(0);
+  uniform_int_distribution<vtkIdType> cell(0, mesh->GetNumberOfCells() - 1);
+  uniform_real_distribution<double>   unit(0., 1.);
+  vector<double> points(3 * NumberOfQueries, .0);
+  vtkSmartPointer<vtkIdList> ptIds = vtkSmartPointer<vtkIdList>::New();
+  double p[3], w[4], sum;
+  for (int i = 0; i < NumberOfQueries; ++i) {
+    mesh->GetCellPoints(cell(rng), ptIds);
+    const int npts = static_cast<int>(ptIds->GetNumberOfIds());
+    sum = .0;
+    for (int j = 0; j < npts; ++j) {
+      w[j] = -log(1. - unit(rng));
+      sum += w[j];
+    }
+    for (int j = 0; j < npts; ++j) {
+      mesh->GetPoint(ptIds->GetId(j), p);
+      for (int c = 0; c < 3; ++c) {
+        points[3 * i + c] += w[j] / sum * p[c];
+      }
+    }
+  }
+  return points;
+}
+
+// -----------------------------------------------------------------------------
+/// Benchmark both locators for a given mesh
+bool Benchmark(const char *name, vtkDataSet *mesh)
+{
+  const vector<double> queries = QueryPoints(mesh);
+
+  // Build locators
+  auto start = chrono::steady_clock::now();
+  SimplexLocator simplex;
+  simplex.DataSet(mesh);
+  simplex.Initialize();
+  const double simplex_build = Seconds(start);
+
+  start = chrono::steady_clock::now();
+  vtkSmartPointer<vtkCellLocator> generic = vtkSmartPointer<vtkCellLocator>::New();
+  generic->SetDataSet(mesh);
+  generic->BuildLocator();
+  const double generic_build = Seconds(start);
+
+  // Query points
+  vector<vtkIdType> simplex_ids(NumberOfQueries), generic_ids(NumberOfQueries);
+  double w[4], pcoords[3], weights[4];
+
+  start = chrono::steady_clock::now();
+  for (int i = 0; i < NumberOfQueries; ++i) {
+    simplex_ids[i] = simplex.FindCell(&queries[3 * i], w);
+  }
+  const double simplex_query = Seconds(start);
+
+  vtkSmartPointer<vtkGenericCell> cell = vtkSmartPointer<vtkGenericCell>::New();
+  start = chrono::steady_clock::now();
+  for (int i = 0; i < NumberOfQueries; ++i) {
+    double p[3] = {queries[3 * i], queries[3 * i + 1], queries[3 * i + 2]};
+    generic_ids[i] = generic->FindCell(p, 1e-9, cell, pcoords, weights);
+  }
+  const double generic_query = Seconds(start);
+
+  // Check that found simplices contain query points
+  int nmissed = 0, nwrong = 0;
+  for (int i = 0; i < NumberOfQueries; ++i) {
+    if (simplex_ids[i] == -1) {
+      if (generic_ids[i] != -1) ++nmissed;
+      continue;
+    }
+    const double * const p = &queries[3 * i];
+    if (!simplex.Weights(simplex_ids[i], p, w)) {
+      ++nwrong;
+      continue;
+    }
+    const vtkIdType * const ptIds = simplex.CellPointIds(simplex_ids[i]);
+    double q[3] = {.0, .0, .0}, x[3];
+    for (int j = 0; j < simplex.NumberOfCellPoints(); ++j) {
+      mesh->GetPoint(ptIds[j], x);
+      for (int c = 0; c < 3; ++c) q[c] += w[j] * x[c];
+    }
+    const double dx = q[0] - p[0], dy = q[1] - p[1], dz = q[2] - p[2];
+    if (dx * dx + dy * dy + dz * dz > 1e-12) ++nwrong;
+  }
+
+  cout << name << ": " << mesh->GetNumberOfCells() << " cells, " << NumberOfQueries << " queries\n";
+  cout << "  SimplexLocator: build = " << simplex_build << "s, query = " << simplex_query << "s\n";
+  cout << "  vtkCellLocator: build = " << generic_build << "s, query = " << generic_query << "s\n";
+  cout << "  Speedup:        build = " << generic_build / simplex_build
+       << ", query = " << generic_query / simplex_query << "\n";
+  cout.flush();
+
+  if (nmissed > 0 || nwrong > 0) {
+    cerr << name << ": " << nmissed << " query points missed, " << nwrong << " located in wrong cell" << endl;
+    return false;
+  }
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+  int n = 200;
+  if (argc > 1) n = atoi(argv[1]);
+  if (n < 10) {
+    cerr << "Number of grid points must be at least 10" << endl;
+    return EXIT_FAILURE;
+  }
+  bool ok = true;
+  ok = Benchmark("FoldedSurface",   FoldedSurface(n))       && ok;
+  ok = Benchmark("TetrahedralCube", TetrahedralCube(n / 5)) && ok;
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
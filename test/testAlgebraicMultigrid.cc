@@ -0,0 +1,154 @@
+/*
+ * Medical Image Registration ToolKit (MIRTK)
+ *
+ * Copyright 2016 Imperial College London
+ * Copyright 2016 Andreas Schuh
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Checks that the smoothed aggregation multigrid hierarchy of a 2-D Poisson
+// matrix coarsens the system, that V-cycles reduce the residual by a factor
+// which is bounded independently of the grid size, and that the hierarchy
+// recomputed by Update for new matrix values converges as well.
+
+#include "mirtk/AlgebraicMultigrid.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+using namespace mirtk;
+using namespace std;
+
+
+// =============================================================================
+// Test data
+// =============================================================================
+
+/// Maximum admissible average residual reduction factor of a V-cycle
+const double MaxConvergenceFactor = .6;
+
+/// Number of V-cycles before the convergence factor is measured
+///
+/// The V-cycle is a contraction in the energy norm, not in the Euclidean norm
+/// of the residual, which may thus increase during the first V-cycle.
+const int NumberOfWarmUpCycles = 2;
+
+/// Number of V-cycles over which the convergence factor is averaged
+const int NumberOfMeasuredCycles = 10;
+
+/// Tolerance of relative residual norm of multigrid solve
+const double Tolerance = 1e-8;
+
+/// Maximum number of V-cycles of multigrid solve
+const int MaxNumberOfCycles = 50;
+
+// -----------------------------------------------------------------------------
+/// Five-point finite difference Laplacian on n x n grid with Dirichlet boundary
+/// scaled by the given factor
+AlgebraicMultigrid::Matrix PoissonMatrix(int n, double s = 1.)
+{
+  vector<Eigen::Triplet<double> > entries;
+  entries.reserve(5 * n * n);
+  for (int j = 0; j < n; ++j)
+  for (int i = 0; i < n; ++i) {
+    const int r = j * n + i;
+    entries.push_back(Eigen::Triplet<double>(r, r, 4. * s));
+    if (i > 0    ) entries.push_back(Eigen::Triplet<double>(r, r - 1, -s));
+    if (i < n - 1) entries.push_back(Eigen::Triplet<double>(r, r + 1, -s));
+    if (j > 0    ) entries.push_back(Eigen::Triplet<double>(r, r - n, -s));
+    if (j < n - 1) entries.push_back(Eigen::Triplet<double>(r, r + n, -s));
+  }
+  AlgebraicMultigrid::Matrix A(n * n, n * n);
+  A.setFromTriplets(entries.begin(), entries.end());
+  return A;
+}
+
+// =============================================================================
+// Tests
+// =============================================================================
+
+// -----------------------------------------------------------------------------
+/// Check coarsening and convergence of V-cycles on n x n Poisson problem
+bool TestPoisson(int n)
+{
+  const AlgebraicMultigrid::Matrix A = PoissonMatrix(n);
+
+  AlgebraicMultigrid amg;
+  amg.CoarseSize(50);
+  if (!amg.Setup(A)) {
+    cerr << "Poisson" << n << ": Failed to factorize coarsest level system" << endl;
+    return false;
+  }
+  if (amg.NumberOfLevels() < 2) {
+    cerr << "Poisson" << n << ": Expected more than one level, got " << amg.NumberOfLevels() << endl;
+    return false;
+  }
+  if (amg.OperatorComplexity() > 2.) {
+    cerr << "Poisson" << n << ": Operator complexity " << amg.OperatorComplexity() << " too high" << endl;
+    return false;
+  }
+
+  const AlgebraicMultigrid::Vector b = AlgebraicMultigrid::Vector::Ones(n * n);
+  AlgebraicMultigrid::Vector x = AlgebraicMultigrid::Vector::Zero(n * n);
+  for (int k = 0; k < NumberOfWarmUpCycles; ++k) {
+    amg.VCycle(b, x);
+  }
+  const double r0 = (b - A * x).norm();
+  for (int k = 0; k < NumberOfMeasuredCycles; ++k) {
+    amg.VCycle(b, x);
+  }
+  const double rho = pow((b - A * x).norm() / r0, 1. / NumberOfMeasuredCycles);
+  if (rho > MaxConvergenceFactor) {
+    cerr << "Poisson" << n << ": Average V-cycle convergence factor " << rho << " too high" << endl;
+    return false;
+  }
+
+  double error;
+  x.setZero();
+  int ncycles = amg.Solve(b, x, MaxNumberOfCycles, Tolerance, &error);
+  if (error > Tolerance) {
+    cerr << "Poisson" << n << ": Solve did not converge, relative residual norm after "
+         << ncycles << " V-cycles is " << error << endl;
+    return false;
+  }
+
+  const AlgebraicMultigrid::Matrix B = PoissonMatrix(n, 2.5);
+  if (!amg.Update(B)) {
+    cerr << "Poisson" << n << ": Failed to factorize coarsest level system after update" << endl;
+    return false;
+  }
+  x.setZero();
+  ncycles = amg.Solve(b, x, MaxNumberOfCycles, Tolerance, &error);
+  if (error > Tolerance || (b - B * x).norm() > 10. * Tolerance * b.norm()) {
+    cerr << "Poisson" << n << ": Solve after update did not converge, relative residual norm after "
+         << ncycles << " V-cycles is " << error << endl;
+    return false;
+  }
+  return true;
+}
+
+// =============================================================================
+// Main
+// =============================================================================
+
+// -----------------------------------------------------------------------------
+int main(int, char *[])
+{
+  bool ok = true;
+  ok = TestPoisson(32)  && ok;
+  ok = TestPoisson(128) && ok;
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
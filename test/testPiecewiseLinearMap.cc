@@ -0,0 +1,325 @@
+/*
+ * Medical Image Registration ToolKit (MIRTK)
+ *
+ * Copyright 2016 Imperial College London
+ * Copyright 2016 Andreas Schuh
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Checks that a piecewise linear map evaluated concurrently by many threads
+// yields results which are bit-identical to those of a serial evaluation, and
+// that the results of each evaluation function agree with those obtained by
+// locating the cell containing each query point without a walk.
+
+#include "mirtk/PiecewiseLinearMap.h"
+
+#include "vtkSmartPointer.h"
+#include "vtkPoints.h"
+#include "vtkCellArray.h"
+#include "vtkCellType.h"
+#include "vtkPointSet.h"
+#include "vtkPolyData.h"
+#include "vtkUnstructuredGrid.h"
+#include "vtkDoubleArray.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace mirtk;
+using namespace std;
+
+
+// =============================================================================
+// Test data
+// =============================================================================
+
+/// Number of grid points along each axis of the map domain
+const int N = 24;
+
+/// Number of concurrently evaluating threads
+const int NumberOfThreads = 16;
+
+/// Number of query points
+const int NumberOfQueries = 20000;
+
+// -----------------------------------------------------------------------------
+/// Jittered regular grid points in [0, 1]^d
+vtkSmartPointer<vtkPoints> GridPoints(int d)
+{
+  mt19937 rng(42);
+  uniform_real_distribution<double> jitter(-.2 / (N - 1), .2 / (N - 1));
+  vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+  const int nz = (d == 3 ? N : 1);
+  for (int k = 0; k < nz; ++k)
+  for (int j = 0; j < N;  ++j)
+  for (int i = 0; i < N;  ++i) {
+    double p[3] = {double(i) / (N - 1), double(j) / (N - 1), d == 3 ? double(k) / (N - 1) : .0};
+    for (int l = 0; l < d; ++l) {
+      const int idx = (l == 0 ? i : (l == 1 ? j : k));
+      if (0 < idx && idx < N - 1) p[l] += jitter(rng);
+    }
+    points->InsertNextPoint(p);
+  }
+  return points;
+}
+
+// -----------------------------------------------------------------------------
+/// Smooth map values with two components at the domain points
+vtkSmartPointer<vtkDataArray> MapValues(vtkPoints *points)
+{
+  vtkSmartPointer<vtkDoubleArray> values = vtkSmartPointer<vtkDoubleArray>::New();
+  values->SetNumberOfComponents(2);
+  values->SetNumberOfTuples(points->GetNumberOfPoints());
+  double p[3];
+  for (vtkIdType ptId = 0; ptId < points->GetNumberOfPoints(); ++ptId) {
+    points->GetPoint(ptId, p);
+    values->SetComponent(ptId, 0, sin(3. * p[0]) + p[1] * p[2]);
+    values->SetComponent(ptId, 1, p[0] * p[1] - cos(2. * p[2]));
+  }
+  return values;
+}
+
+// -----------------------------------------------------------------------------
+/// Triangulated planar square
+vtkSmartPointer<vtkDataSet> TriangleMesh()
+{
+  vtkSmartPointer<vtkCellArray> triangles = vtkSmartPointer<vtkCellArray>::New();
+  for (int j = 0; j < N - 1; ++j)
+  for (int i = 0; i < N - 1; ++i) {
+    const vtkIdType a = j * N + i, b = a + 1, c = a + N, d = c + 1;
+    const vtkIdType t1[3] = {a, b, d}, t2[3] = {a, d, c};
+    triangles->InsertNextCell(3, t1);
+    triangles->InsertNextCell(3, t2);
+  }
+  vtkSmartPointer<vtkPolyData> mesh = vtkSmartPointer<vtkPolyData>::New();
+  mesh->SetPoints(GridPoints(2));
+  mesh->SetPolys(triangles);
+  return mesh;
+}
+
+// -----------------------------------------------------------------------------
+/// Tetrahedral mesh of unit cube, where each grid cell is split into six
+/// tetrahedra along the paths from its first to its last corner (Kuhn)
+vtkSmartPointer<vtkDataSet> TetrahedralMesh()
+{
+  const int perm[6][3] = {{0,1,2}, {0,2,1}, {1,0,2}, {1,2,0}, {2,0,1}, {2,1,0}};
+  const vtkIdType stride[3] = {1, N, N * N};
+  vtkSmartPointer<vtkUnstructuredGrid> mesh = vtkSmartPointer<vtkUnstructuredGrid>::New();
+  mesh->SetPoints(GridPoints(3));
+  for (int k = 0; k < N - 1; ++k)
+  for (int j = 0; j < N - 1; ++j)
+  for (int i = 0; i < N - 1; ++i) {
+    for (int t = 0; t < 6; ++t) {
+      vtkIdType ptIds[4];
+      ptIds[0] = k * stride[2] + j * stride[1] + i;
+      for (int l = 0; l < 3; ++l) {
+        ptIds[l + 1] = ptIds[l] + stride[perm[t][l]];
+      }
+      mesh->InsertNextCell(VTK_TETRA, 4, ptIds);
+    }
+  }
+  return mesh;
+}
+
+// =============================================================================
+// Evaluation
+// =============================================================================
+
+/// Map values and inside flags of all query points
+struct Result
+{
+  vector<double> Values;
+  vector<char>   Inside;
+
+  Result() : Values(2 * NumberOfQueries), Inside(NumberOfQueries) {}
+
+  bool operator ==(const Result &other) const
+  {
+    return Inside == other.Inside &&
+           memcmp(Values.data(), other.Values.data(), Values.size() * sizeof(double)) == 0;
+  }
+
+  /// Whether results are equal up to round-off error
+  bool Equals(const Result &other, double tol) const
+  {
+    if (Inside != other.Inside) return false;
+    for (size_t i = 0; i < Values.size(); ++i) {
+      if (abs(Values[i] - other.Values[i]) > tol) return false;
+    }
+    return true;
+  }
+};
+
+/// Query points, some of which lie outside the map domain
+struct Queries
+{
+  vector<double> X, Y, Z;
+
+  Queries(int d)
+  :
+    X(NumberOfQueries), Y(NumberOfQueries), Z(NumberOfQueries, .0)
+  {
+    mt19937 rng(7);
+    uniform_real_distribution<double> coord(-.05, 1.05);
+    for (int i = 0; i < NumberOfQueries; ++i) {
+      X[i] = coord(rng);
+      Y[i] = coord(rng);
+      if (d == 3) Z[i] = coord(rng);
+    }
+  }
+};
+
+// -----------------------------------------------------------------------------
+/// Evaluate map at each query point using new evaluation context for each point
+void EvaluatePointsWithoutWalk(const PiecewiseLinearMap *map, const Queries *q, Result *r)
+{
+  for (int i = 0; i < NumberOfQueries; ++i) {
+    PiecewiseLinearMap::EvaluationContext ctx;
+    r->Inside[i] = map->Evaluate(ctx, &r->Values[2 * i], q->X[i], q->Y[i], q->Z[i]);
+  }
+}
+
+// -----------------------------------------------------------------------------
+/// Evaluate map at each query point using thread-local evaluation context
+void EvaluatePoints(const PiecewiseLinearMap *map, const Queries *q, Result *r)
+{
+  for (int i = 0; i < NumberOfQueries; ++i) {
+    r->Inside[i] = map->Evaluate(&r->Values[2 * i], q->X[i], q->Y[i], q->Z[i]);
+  }
+}
+
+// -----------------------------------------------------------------------------
+/// Evaluate map at each query point using own evaluation context
+void EvaluatePointsWithContext(const PiecewiseLinearMap *map, const Queries *q, Result *r)
+{
+  PiecewiseLinearMap::EvaluationContext ctx;
+  for (int i = 0; i < NumberOfQueries; ++i) {
+    r->Inside[i] = map->Evaluate(ctx, &r->Values[2 * i], q->X[i], q->Y[i], q->Z[i]);
+  }
+}
+
+// -----------------------------------------------------------------------------
+/// Evaluate map at all query points at once
+void EvaluateBatch(const PiecewiseLinearMap *map, const Queries *q, Result *r)
+{
+  bool *inside = new bool[NumberOfQueries];
+  map->Evaluate(r->Values.data(), NumberOfQueries, q->X.data(), q->Y.data(), q->Z.data(), inside);
+  for (int i = 0; i < NumberOfQueries; ++i) {
+    r->Inside[i] = inside[i];
+  }
+  delete[] inside;
+}
+
+// -----------------------------------------------------------------------------
+/// Compare results of concurrent evaluation by many threads to serial evaluation
+///
+/// The cell locator is built by the first concurrent query.
+bool TestConcurrentEvaluation(const char *name, vtkDataSet *domain, int d,
+                              void (*eval)(const PiecewiseLinearMap *, const Queries *, Result *))
+{
+  PiecewiseLinearMap map;
+  map.Domain(domain);
+  map.Values(MapValues(vtkPointSet::SafeDownCast(domain)->GetPoints()));
+  map.Initialize();
+
+  const Queries queries(d);
+
+  vector<Result> results(NumberOfThreads);
+  vector<thread> threads;
+  for (int t = 0; t < NumberOfThreads; ++t) {
+    threads.push_back(thread(eval, &map, &queries, &results[t]));
+  }
+  for (int t = 0; t < NumberOfThreads; ++t) {
+    threads[t].join();
+  }
+
+  Result expected;
+  thread serial(eval, &map, &queries, &expected);
+  serial.join();
+
+  int ninside = 0;
+  for (int i = 0; i < NumberOfQueries; ++i) {
+    if (expected.Inside[i]) ++ninside;
+  }
+  if (ninside == 0 || ninside == NumberOfQueries) {
+    cerr << name << ": Expected query points both inside and outside of map domain" << endl;
+    return false;
+  }
+
+  bool ok = true;
+  for (int t = 0; t < NumberOfThreads; ++t) {
+    if (!(results[t] == expected)) {
+      cerr << name << ": Result of thread " << t << " differs from serial evaluation" << endl;
+      ok = false;
+    }
+  }
+  return ok;
+}
+
+// -----------------------------------------------------------------------------
+/// Compare results of evaluation function to those of walk-free evaluation
+///
+/// Map values at points on a face shared by two cells may differ by round-off
+/// error depending on which of the cells was found to contain the point.
+bool TestConsistentEvaluation(const char *name, vtkDataSet *domain, int d,
+                              void (*eval)(const PiecewiseLinearMap *, const Queries *, Result *))
+{
+  PiecewiseLinearMap map;
+  map.Domain(domain);
+  map.Values(MapValues(vtkPointSet::SafeDownCast(domain)->GetPoints()));
+  map.Initialize();
+
+  const Queries queries(d);
+
+  Result result, expected;
+  eval(&map, &queries, &result);
+  EvaluatePointsWithoutWalk(&map, &queries, &expected);
+
+  if (!result.Equals(expected, 1e-9)) {
+    cerr << name << ": Result differs from evaluation at each point without walk" << endl;
+    return false;
+  }
+  return true;
+}
+
+// =============================================================================
+// Main
+// =============================================================================
+
+// -----------------------------------------------------------------------------
+int main(int, char *[])
+{
+  vtkSmartPointer<vtkDataSet> triangles  = TriangleMesh();
+  vtkSmartPointer<vtkDataSet> tetrahedra = TetrahedralMesh();
+
+  bool ok = true;
+  ok = TestConcurrentEvaluation("TrianglesEvaluatePoints",               triangles,  2, EvaluatePoints)            && ok;
+  ok = TestConcurrentEvaluation("TrianglesEvaluatePointsWithContext",    triangles,  2, EvaluatePointsWithContext) && ok;
+  ok = TestConcurrentEvaluation("TrianglesEvaluateBatch",                triangles,  2, EvaluateBatch)             && ok;
+  ok = TestConcurrentEvaluation("TetrahedraEvaluatePoints",              tetrahedra, 3, EvaluatePoints)            && ok;
+  ok = TestConcurrentEvaluation("TetrahedraEvaluatePointsWithContext",   tetrahedra, 3, EvaluatePointsWithContext) && ok;
+  ok = TestConcurrentEvaluation("TetrahedraEvaluateBatch",               tetrahedra, 3, EvaluateBatch)             && ok;
+  ok = TestConsistentEvaluation("TrianglesConsistentPoints",             triangles,  2, EvaluatePoints)            && ok;
+  ok = TestConsistentEvaluation("TrianglesConsistentPointsWithContext",  triangles,  2, EvaluatePointsWithContext) && ok;
+  ok = TestConsistentEvaluation("TrianglesConsistentBatch",              triangles,  2, EvaluateBatch)             && ok;
+  ok = TestConsistentEvaluation("TetrahedraConsistentPoints",            tetrahedra, 3, EvaluatePoints)            && ok;
+  ok = TestConsistentEvaluation("TetrahedraConsistentPointsWithContext", tetrahedra, 3, EvaluatePointsWithContext) && ok;
+  ok = TestConsistentEvaluation("TetrahedraConsistentBatch",             tetrahedra, 3, EvaluateBatch)             && ok;
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -22,6 +22,7 @@
 
 #include "mirtk/PointSetIO.h"
 #include "mirtk/PointSetUtils.h"
+#include "mirtk/LinearSolverType.h"
 
 #include "mirtk/UniformSurfaceMapper.h"                   // Tutte (1964)
 #include "mirtk/ChordLengthSurfaceMapper.h"               // Kent et al. (1991), Floater (1997)
@@ -80,6 +81,25 @@ void PrintHelp(const char* name)
   cout << "  -name <string>        Name of point data array used as fixed point map.  (default: tcoords)\n";
   cout << "  -mask <string>        Name of point data array used as fixed point mask. (default: boundary)\n";
   cout << "  -max-iterations <n>   Maximum no. of linear solver iterations. (default: 1 or size of problem)\n";
+  cout << "  -solver <name>        Sparse linear solver: LU, LDLT, LLT, CG, BiCGSTAB, or AMG. The default is a\n";
+  cout << "                        direct solver when the maximum no. of iterations is 1, and an iterative\n";
+  cout << "                        solver otherwise. The Cholesky factorization LDLT/LLT and CG require a\n";
+  cout << "                        symmetric system matrix as does AMG. (default: Default)\n";
+  cout << "  -precond <name>       Preconditioner of iterative solver: None, Jacobi, IC, ILUT, or AMG.\n";
+  cout << "                        The incomplete Cholesky factorization IC and the algebraic multigrid\n";
+  cout << "                        AMG require a symmetric system matrix and ILUT the BiCGSTAB solver.\n";
+  cout << "                        (default: Jacobi)\n";
+  cout << "  -levels <n>           Number of coarse-to-fine multiresolution levels used to initialize the\n";
+  cout << "                        iterative solver of a fixed boundary surface map. Coarser levels are\n";
+  cout << "                        obtained by decimation of the input surface. (default: 1)\n";
+  cout << "  -mixed-precision      Factorize system matrix or compute IC/ILUT preconditioner in single precision.\n";
+  cout << "                        Direct solvers improve the solution by iterative refinement in double precision.\n";
+  cout << "  -ordering <name>      Renumber surface points and cells before computing the map: None, RCM\n";
+  cout << "                        (reverse Cuthill-McKee), or SFC (space-filling curve). The output map\n";
+  cout << "                        is defined on the input surface in its original order. (default: None)\n";
+  cout << "  -exact-intrinsic      Solve the linear system with the near-optimal lambda value of an intrinsic\n";
+  cout << "                        map with least distortion instead of using the affine combination of the\n";
+  cout << "                        conformal and authalic maps, which is then the initial guess. (default: off)\n";
   PrintCommonOptions(cout);
   cout << "\n";
 }
@@ -129,11 +149,18 @@ int main(int argc, char *argv[])
   const char *boundary_map_name = nullptr;
 
   SurfaceMappingMethod method = MAP_MeanValue;
+  LinearSolverType     solver = LinearSolver_Default;
+
+  LinearSolverPreconditioner preconditioner = Preconditioner_Default;
 
   int    niters                = -1; // Number of iterations
+  int    nlevels               = 1;  // Number of multiresolution levels
+  bool   mixed_precision       = false; // Factorize in single precision
+  MeshOrdering ordering        = MeshOrdering_None; // Point and cell order
   int    p_harmonic_exponent   = 2;  // Exponent of p-harmonic energy
   int    chord_length_exponent = 1;  // Weighted least squares exponent
   double intrinsic_lambda      = .5; // Conformal vs. authalic energy weight
+  bool   intrinsic_exact       = false; // Re-solve with near-optimal lambda
   Array<int> selection;              // Selected (boundary) points
 
   for (ALL_OPTIONS) {
@@ -198,6 +225,20 @@ int main(int argc, char *argv[])
     else if (OPTION("-max-iterations") || OPTION("-max-iter") || OPTION("-iterations") || OPTION("-iter")) {
       PARSE_ARGUMENT(niters);
     }
+    else if (OPTION("-solver") || OPTION("-linear-solver")) {
+      PARSE_ARGUMENT(solver);
+    }
+    else if (OPTION("-preconditioner") || OPTION("-precond")) {
+      PARSE_ARGUMENT(preconditioner);
+    }
+    else if (OPTION("-levels") || OPTION("-multires")) {
+      PARSE_ARGUMENT(nlevels);
+    }
+    else if (OPTION("-ordering") || OPTION("-reorder")) {
+      PARSE_ARGUMENT(ordering);
+    }
+    else if (OPTION("-mixed-precision")) mixed_precision = true;
+    else if (OPTION("-exact-intrinsic")) intrinsic_exact = true;
     else HANDLE_COMMON_OR_UNKNOWN_OPTION();
   }
 
@@ -220,8 +261,13 @@ int main(int argc, char *argv[])
       const char *msg = "Computing uniform surface map...";
       if (verbose) cout << msg, cout.flush();
       UniformSurfaceMapper mapper;
+      mapper.LinearSolver(solver);
+      mapper.MixedPrecision(mixed_precision);
+      mapper.Preconditioner(preconditioner);
       mapper.NumberOfIterations(niters);
+      mapper.NumberOfLevels(nlevels);
       mapper.Surface(surface);
+      mapper.Ordering(ordering);
       mapper.Input(boundary_map);
       mapper.Run();
       surface_map = mapper.Output();
@@ -232,8 +278,13 @@ int main(int argc, char *argv[])
       const char *msg = "Computing chord length weighted surface map...";
       if (verbose) cout << msg, cout.flush();
       ChordLengthSurfaceMapper mapper(chord_length_exponent);
+      mapper.LinearSolver(solver);
+      mapper.MixedPrecision(mixed_precision);
+      mapper.Preconditioner(preconditioner);
       mapper.NumberOfIterations(niters);
+      mapper.NumberOfLevels(nlevels);
       mapper.Surface(surface);
+      mapper.Ordering(ordering);
       mapper.Input(boundary_map);
       mapper.Run();
       surface_map = mapper.Output();
@@ -244,8 +295,13 @@ int main(int argc, char *argv[])
       const char *msg = "Computing shape preserving surface map...";
       if (verbose) cout << msg, cout.flush();
       ShapePreservingSurfaceMapper mapper;
+      mapper.LinearSolver(solver);
+      mapper.MixedPrecision(mixed_precision);
+      mapper.Preconditioner(preconditioner);
       mapper.NumberOfIterations(niters);
+      mapper.NumberOfLevels(nlevels);
       mapper.Surface(surface);
+      mapper.Ordering(ordering);
       mapper.Input(boundary_map);
       mapper.Run();
       surface_map = mapper.Output();
@@ -256,8 +312,13 @@ int main(int argc, char *argv[])
       const char *msg = "Computing mean value convex map...";
       if (verbose) cout << msg, cout.flush();
       MeanValueSurfaceMapper mapper;
+      mapper.LinearSolver(solver);
+      mapper.MixedPrecision(mixed_precision);
+      mapper.Preconditioner(preconditioner);
       mapper.NumberOfIterations(niters);
+      mapper.NumberOfLevels(nlevels);
       mapper.Surface(surface);
+      mapper.Ordering(ordering);
       mapper.Input(boundary_map);
       mapper.Run();
       surface_map = mapper.Output();
@@ -268,8 +329,13 @@ int main(int argc, char *argv[])
       const char *msg = "Computing harmonic surface map...";
       if (verbose) cout << msg, cout.flush();
       HarmonicSurfaceMapper mapper;
+      mapper.LinearSolver(solver);
+      mapper.MixedPrecision(mixed_precision);
+      mapper.Preconditioner(preconditioner);
       mapper.NumberOfIterations(niters);
+      mapper.NumberOfLevels(nlevels);
       mapper.Surface(surface);
+      mapper.Ordering(ordering);
       mapper.Input(boundary_map);
       mapper.Run();
       surface_map = mapper.Output();
@@ -285,8 +351,13 @@ int main(int argc, char *argv[])
       const char *msg = "Computing discrete authalic surface map...";
       if (verbose) cout << msg, cout.flush();
       AuthalicSurfaceMapper mapper;
+      mapper.LinearSolver(solver);
+      mapper.MixedPrecision(mixed_precision);
+      mapper.Preconditioner(preconditioner);
       mapper.NumberOfIterations(niters);
+      mapper.NumberOfLevels(nlevels);
       mapper.Surface(surface);
+      mapper.Ordering(ordering);
       mapper.Input(boundary_map);
       mapper.Run();
       surface_map = mapper.Output();
@@ -302,8 +373,13 @@ int main(int argc, char *argv[])
         cout << "\n  Authalic  energy weight      = " << 1. - mapper.Lambda();
         cout.flush();
       }
+      mapper.LinearSolver(solver);
+      mapper.MixedPrecision(mixed_precision);
+      mapper.Preconditioner(preconditioner);
       mapper.NumberOfIterations(niters);
+      mapper.NumberOfLevels(nlevels);
       mapper.Surface(surface);
+      mapper.Ordering(ordering);
       mapper.Input(boundary_map);
       mapper.Run();
       surface_map = mapper.Output();
@@ -314,8 +390,14 @@ int main(int argc, char *argv[])
       const char *msg = "Computing intrinsic surface map with least area distortion...";
       if (verbose) cout << msg, cout.flush();
       IntrinsicLeastAreaDistortionSurfaceMapper mapper;
+      mapper.LinearSolver(solver);
+      mapper.MixedPrecision(mixed_precision);
+      mapper.Preconditioner(preconditioner);
       mapper.NumberOfIterations(niters);
+      mapper.NumberOfLevels(nlevels);
       mapper.Surface(surface);
+      mapper.Ordering(ordering);
+      mapper.ExactSolution(intrinsic_exact);
       mapper.Input(boundary_map);
       mapper.Run();
       surface_map = mapper.Output();
@@ -326,8 +408,14 @@ int main(int argc, char *argv[])
       const char *msg = "Computing intrinsic surface map with least edge length distortion...";
       if (verbose) cout << msg, cout.flush();
       IntrinsicLeastEdgeLengthDistortionSurfaceMapper mapper;
+      mapper.LinearSolver(solver);
+      mapper.MixedPrecision(mixed_precision);
+      mapper.Preconditioner(preconditioner);
       mapper.NumberOfIterations(niters);
+      mapper.NumberOfLevels(nlevels);
       mapper.Surface(surface);
+      mapper.Ordering(ordering);
+      mapper.ExactSolution(intrinsic_exact);
       mapper.Input(boundary_map);
       mapper.Run();
       surface_map = mapper.Output();
@@ -341,8 +429,11 @@ int main(int argc, char *argv[])
       const char *msg = "Computing conformal flattening...";
       if (verbose) cout << msg, cout.flush();
       ConformalSurfaceFlattening mapper;
+      mapper.LinearSolver(solver);
+      mapper.MixedPrecision(mixed_precision);
       mapper.NumberOfIterations(niters);
       mapper.Surface(surface);
+      mapper.Ordering(ordering);
       mapper.Run();
       surface_map = mapper.Output();
       if (verbose) cout << msg, cout.flush();
@@ -355,8 +446,12 @@ int main(int argc, char *argv[])
       const char *msg = "Computing least squares conformal map...";
       if (verbose) cout << msg, cout.flush();
       LeastSquaresConformalSurfaceMapper mapper;
+      mapper.LinearSolver(solver);
+      mapper.MixedPrecision(mixed_precision);
+      mapper.Preconditioner(preconditioner);
       mapper.NumberOfIterations(niters);
       mapper.Surface(surface);
+      mapper.Ordering(ordering);
       if (selection.size() > 0) {
         mapper.AddFixedPoint(selection[0], 0., 0.);
         if (selection.size() > 1) {
@@ -22,6 +22,7 @@
 
 #include "mirtk/PointSetIO.h"
 #include "mirtk/PointSetUtils.h"
+#include "mirtk/LinearSolverType.h"
 
 #include "mirtk/AsConformalAsPossibleMapper.h"
 #include "mirtk/HarmonicTetrahedralMeshMapper.h"
@@ -67,6 +68,14 @@ void PrintHelp(const char* name)
   cout << "  -meshless     Use meshless mapping method if possible.\n";
   cout << "\n";
   cout << "Optional arguments:\n";
+  cout << "  -max-iterations <n>   Maximum no. of linear solver iterations.\n";
+  cout << "  -solver <name>        Sparse linear solver: LU, LDLT, LLT, CG, BiCGSTAB, or AMG. (default: CG)\n";
+  cout << "  -precond <name>       Preconditioner of iterative solver: None, Jacobi, IC, ILUT, or AMG.\n";
+  cout << "                        The algebraic multigrid (AMG) is recommended for large meshes. (default: Jacobi)\n";
+  cout << "  -mixed-precision      Factorize system matrix or compute IC/ILUT preconditioner in single precision.\n";
+  cout << "                        Direct solvers improve the solution by iterative refinement in double precision.\n";
+  cout << "  -ordering <name>      Renumber tetrahedral mesh points and cells before computing the map:\n";
+  cout << "                        None, RCM (reverse Cuthill-McKee), or SFC (space-filling curve). (default: None)\n";
   PrintCommonOptions(cout);
   cout << "\n";
 }
@@ -118,7 +127,11 @@ SharedPtr<Mapping> SolveVolumetricMap(vtkSmartPointer<vtkPointSet>  domain,
                                       vtkSmartPointer<vtkDataArray> values,
                                       vtkSmartPointer<vtkDataArray> mask,
                                       MapVolumeMethod               method,
-                                      int                           niterations)
+                                      int                           niterations,
+                                      LinearSolverType              solver,
+                                      LinearSolverPreconditioner    preconditioner,
+                                      bool                          mixed_precision,
+                                      MeshOrdering                  ordering)
 {
   SharedPtr<Mapping> map;
   if (method == MAP_Harmonic) {
@@ -131,6 +144,10 @@ SharedPtr<Mapping> SolveVolumetricMap(vtkSmartPointer<vtkPointSet>  domain,
     case MAP_ACAP: {
       if (verbose) cout << "Computing as-conformal-as-possible map...", cout.flush();
       AsConformalAsPossibleMapper mapper;
+      mapper.LinearSolver(solver);
+      mapper.Preconditioner(preconditioner);
+      mapper.MixedPrecision(mixed_precision);
+      mapper.Ordering(ordering);
       mapper.InputSet(domain);
       mapper.InputMap(values);
       mapper.Run();
@@ -139,6 +156,10 @@ SharedPtr<Mapping> SolveVolumetricMap(vtkSmartPointer<vtkPointSet>  domain,
     case MAP_HarmonicFEM: {
       if (verbose) cout << "Computing piecewise linear harmonic map...", cout.flush();
       HarmonicTetrahedralMeshMapper mapper;
+      mapper.LinearSolver(solver);
+      mapper.Preconditioner(preconditioner);
+      mapper.MixedPrecision(mixed_precision);
+      mapper.Ordering(ordering);
       mapper.NumberOfIterations(niterations);
       mapper.InputSet(domain);
       mapper.InputMap(values);
@@ -178,9 +199,14 @@ int main(int argc, char *argv[])
   const char *values_name = nullptr;   // Name of point data array with fixed point values
   const char *mask_name   = nullptr;   // Name of point data array with fixed point mask
 
-  MapVolumeMethod method   = MAP_Harmonic;
-  bool            meshless = false;
-  int             niter    = 0;
+  MapVolumeMethod  method   = MAP_Harmonic;
+  bool             meshless = false;
+  int              niter    = 0;
+  LinearSolverType solver   = LinearSolver_Default;
+  bool             mixed    = false;
+  MeshOrdering     ordering = MeshOrdering_None;
+
+  LinearSolverPreconditioner preconditioner = Preconditioner_Default;
 
   for (ALL_OPTIONS) {
     if      (OPTION("-name")) values_name = ARGUMENT;
@@ -196,6 +222,16 @@ int main(int argc, char *argv[])
     else if (OPTION("-max-iterations") || OPTION("-max-iter") || OPTION("-iterations") || OPTION("-iter")) {
       PARSE_ARGUMENT(niter);
     }
+    else if (OPTION("-solver") || OPTION("-linear-solver")) {
+      PARSE_ARGUMENT(solver);
+    }
+    else if (OPTION("-preconditioner") || OPTION("-precond")) {
+      PARSE_ARGUMENT(preconditioner);
+    }
+    else if (OPTION("-ordering") || OPTION("-reorder")) {
+      PARSE_ARGUMENT(ordering);
+    }
+    else if (OPTION("-mixed-precision")) mixed = true;
     else HANDLE_COMMON_OR_UNKNOWN_OPTION();
   }
   if (meshless) {
@@ -228,7 +264,7 @@ int main(int argc, char *argv[])
   }
 
   // Compute volumetric map given boundary surface map
-  SharedPtr<Mapping> map(SolveVolumetricMap(domain, values, mask, method, niter));
+  SharedPtr<Mapping> map(SolveVolumetricMap(domain, values, mask, method, niter, solver, preconditioner, mixed, ordering));
   if (!map->Write(output_name)) {
     FatalError("Failed to write volumetric map to " << output_name);
   }
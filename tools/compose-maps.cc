@@ -19,6 +19,7 @@
 
 #include "mirtk/Common.h"
 #include "mirtk/Options.h"
+#include "mirtk/Parallel.h"
 
 #include "mirtk/PointSetIO.h"
 #include "mirtk/PiecewiseLinearMap.h"
@@ -375,24 +376,81 @@ void InverseStereographicProjection(PiecewiseLinearMap &map, const ParameterList
 // Input mapping
 // =============================================================================
 
+// -----------------------------------------------------------------------------
+/// Evaluate map at consecutive batches of points
+class EvaluateBatches
+{
+  const Mapping *_Map;
+  const double  *_X, *_Y, *_Z;
+  double        *_Values;
+  const int      _NumberOfPoints;
+  const int      _BatchSize;
+
+public:
+
+  EvaluateBatches(const Mapping *map, int n, const double *x, const double *y,
+                  const double *z, double *v, int batch_size)
+  :
+    _Map(map), _X(x), _Y(y), _Z(z), _Values(v),
+    _NumberOfPoints(n), _BatchSize(batch_size)
+  {}
+
+  void operator ()(const blocked_range<int> &batches) const
+  {
+    const int m = _Map->NumberOfComponents();
+    Array<double> f(_BatchSize * m);
+    for (int b = batches.begin(); b != batches.end(); ++b) {
+      const int i1 = b * _BatchSize;
+      const int n  = min(_BatchSize, _NumberOfPoints - i1);
+      _Map->Evaluate(f.data(), n, _X + i1, _Y + i1, _Z + i1);
+      for (int j = 0; j < m; ++j) {
+        const double *v = f.data() + j * n;
+        double       *w = _Values + j * _NumberOfPoints + i1;
+        for (int i = 0; i < n; ++i) {
+          w[i] = v[i];
+        }
+      }
+    }
+  }
+};
+
 // -----------------------------------------------------------------------------
 /// Compose piecewise linear map with another Mapping
 void Compose(PiecewiseLinearMap &map, const char *input_name)
 {
   UniquePtr<Mapping> other(Mapping::New(input_name));
   vtkDataArray *f = map.Values();
+  const int d = static_cast<int>(f->GetNumberOfComponents());
+  if (d > 3) {
+    FatalError("Codomain dimension of intermediate map must be at most 3!");
+  }
   vtkSmartPointer<vtkDataArray> values;
   values.TakeReference(f->NewInstance());
   values->SetName(f->GetName());
-  values->SetNumberOfComponents(f->GetNumberOfComponents());
-  values->SetNumberOfTuples(f->GetNumberOfTuples());
+  const int n = static_cast<int>(f->GetNumberOfTuples());
+  const int m = other->NumberOfComponents();
+  values->SetNumberOfComponents(m);
+  values->SetNumberOfTuples(n);
   double p[3] = {.0};
-  double *v = new double[f->GetNumberOfComponents()];
-  for (vtkIdType i = 0; i < f->GetNumberOfTuples(); ++i) {
-    f->GetTuple(i, v);
-    other->Evaluate(v, p);
-    values->SetTuple(static_cast<vtkIdType>(i), v);
+  double *x = new double[n];
+  double *y = new double[n];
+  double *z = new double[n];
+  double *v = new double[n * m];
+  for (int i = 0; i < n; ++i) {
+    f->GetTuple(static_cast<vtkIdType>(i), p);
+    x[i] = p[0], y[i] = p[1], z[i] = p[2];
+  }
+  const int batch_size = 1024;
+  const int nbatches   = (n + batch_size - 1) / batch_size;
+  EvaluateBatches eval(other.get(), n, x, y, z, v, batch_size);
+  parallel_for(blocked_range<int>(0, nbatches), eval);
+  for (int i = 0; i < n; ++i)
+  for (int j = 0; j < m; ++j) {
+    values->SetComponent(static_cast<vtkIdType>(i), j, v[j * n + i]);
   }
+  delete[] x;
+  delete[] y;
+  delete[] z;
   delete[] v;
   map.Values(values);
 }
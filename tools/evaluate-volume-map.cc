@@ -26,6 +26,8 @@
 #include "mirtk/GenericImage.h"
 #include "mirtk/GradientImageFilter.h"
 #include "mirtk/PiecewiseLinearMap.h"
+#include "mirtk/MeshlessHarmonicMap.h"
+#include "mirtk/MeshlessBiharmonicMap.h"
 
 #include "vtkSmartPointer.h"
 #include "vtkPolyData.h"
@@ -61,6 +63,9 @@ void PrintHelp(const char* name)
   cout << "  -lattice <file>             Lattice attributes used to discretize the map domain\n";
   cout << "                              on a regular grid are read from the given image file.\n";
   cout << "                              (default: derived from map domain)\n";
+  cout << "  -opening-angle <value>      Opening angle of treecode used to approximate a meshless\n";
+  cout << "                              harmonic map. Exact summation when zero. Not supported\n";
+  cout << "                              for meshless biharmonic maps. (default: 0)\n";
   PrintCommonOptions(cout);
   cout << endl;
 }
@@ -379,6 +384,8 @@ int main(int argc, char *argv[])
   const char *outside_name            = nullptr;
   const char *distance_name           = nullptr;
 
+  double opening_angle = .0;
+
   for (ALL_OPTIONS) {
     if      (OPTION("-target") || OPTION("-domain"))   target_name = ARGUMENT;
     else if (OPTION("-source") || OPTION("-codomain")) source_name = ARGUMENT;
@@ -398,6 +405,9 @@ int main(int argc, char *argv[])
     else if (OPTION("-distance")) {
       distance_name = ARGUMENT;
     }
+    else if (OPTION("-opening-angle") || OPTION("-theta")) {
+      PARSE_ARGUMENT(opening_angle);
+    }
     else HANDLE_COMMON_OR_UNKNOWN_OPTION();
   }
 
@@ -416,6 +426,19 @@ int main(int argc, char *argv[])
   PiecewiseLinearMap *dmap = dynamic_cast<PiecewiseLinearMap *>(map.get());
   if (verbose) cout << " done" << endl;
 
+  // Use treecode to evaluate meshless harmonic map
+  MeshlessHarmonicMap *hmap = dynamic_cast<MeshlessHarmonicMap *>(map.get());
+  if (opening_angle > .0 && dynamic_cast<MeshlessBiharmonicMap *>(map.get())) {
+    cerr << "Warning: Option -opening-angle ignored, treecode not implemented for meshless biharmonic map" << endl;
+    hmap = nullptr;
+  }
+  if (hmap && opening_angle > .0) {
+    if (verbose) cout << "Build treecode...", cout.flush();
+    hmap->OpeningAngle(opening_angle);
+    hmap->Initialize();
+    if (verbose) cout << " done" << endl;
+  }
+
   if (target && output_name) {
     double p[3];
 
@@ -425,17 +448,33 @@ int main(int argc, char *argv[])
     discrete_map->SetName("Map");
     discrete_map->SetNumberOfComponents(map->NumberOfComponents());
     discrete_map->SetNumberOfTuples(target->GetNumberOfPoints());
-    double *v = new double[map->NumberOfComponents()];
-    for (vtkIdType ptId = 0; ptId < target->GetNumberOfPoints(); ++ptId) {
-      target->GetPoint(ptId, p);
-      if (!map->Evaluate(v, p)) {
+    const int n = static_cast<int>(target->GetNumberOfPoints());
+    const int m = map->NumberOfComponents();
+    double *x = new double[n];
+    double *y = new double[n];
+    double *z = new double[n];
+    double *v = new double[n * m];
+    bool   *inside = new bool[n];
+    for (int i = 0; i < n; ++i) {
+      target->GetPoint(static_cast<vtkIdType>(i), p);
+      x[i] = p[0], y[i] = p[1], z[i] = p[2];
+    }
+    map->Evaluate(v, n, x, y, z, inside);
+    for (int i = 0; i < n; ++i) {
+      if (!inside[i]) {
         cerr << "Warning: Map undefined at point ("
-             << p[0] << ", " << p[1] << ", " << p[2]
-             << ") with ID " << ptId << endl;
+             << x[i] << ", " << y[i] << ", " << z[i]
+             << ") with ID " << i << endl;
+      }
+      for (int j = 0; j < m; ++j) {
+        discrete_map->SetComponent(static_cast<vtkIdType>(i), j, v[j * n + i]);
       }
-      discrete_map->SetTuple(ptId, v);
     }
+    delete[] x;
+    delete[] y;
+    delete[] z;
     delete[] v;
+    delete[] inside;
     if (discrete_map->GetNumberOfComponents() == 1) {
       target->GetPointData()->SetScalars(discrete_map);
     } else if (discrete_map->GetNumberOfComponents() == 3) {